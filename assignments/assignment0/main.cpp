@@ -8,6 +8,7 @@
 #include <ew/transform.h>
 #include <ew/cameraController.h>
 #include <ew/texture.h>
+#include <ew/textureCompression.h>
 
 #include <GLFW/glfw3.h>
 #include <imgui.h>
@@ -51,7 +52,7 @@ int main() {
 	camera.fov = 60.0f; // Vertical field of view, in degrees
 
 	// Handles to OpenGL object are unsigned integers
-	GLuint brickTexture = ew::loadTexture("assets/brick_color.jpg");
+	GLuint brickTexture = ew::loadTexture(ew::getCompressedTexturePath("assets/brick_color.jpg").c_str());
 
 	ew::Transform monkeyTransform;
 
@@ -8,6 +8,7 @@
 #include <ew/transform.h>
 #include <ew/cameraController.h>
 #include <ew/texture.h>
+#include <ew/textureCompression.h>
 
 #include <tslib/framebuffer.h>
 
@@ -70,7 +71,7 @@ int main() {
 	glCreateVertexArrays(1, &dummyVAO);
 
 	// Handles to OpenGL object are unsigned integers
-	GLuint brickTexture = ew::loadTexture("assets/brick_color.jpg");
+	GLuint brickTexture = ew::loadTexture(ew::getCompressedTexturePath("assets/brick_color.jpg").c_str());
 
 	GLenum attachments[] = { GL_COLOR_ATTACHMENT0 };
 	glDrawBuffers(1, attachments);
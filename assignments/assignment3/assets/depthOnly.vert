@@ -1,11 +1,21 @@
 #version 450
 
+// Compile with INSTANCED 1 for ew::Mesh::drawInstanced / ew::Model::drawInstanced
+#ifndef INSTANCED
+#define INSTANCED 0
+#endif
+
 layout (location = 0) in vec3 vPos;
+#if INSTANCED
+layout (location = 5) in mat4 _Model; // Per instance, locations 5-8
+#endif
 
 uniform mat4 _ViewProjection;
+#if !INSTANCED
 uniform mat4 _Model;
+#endif
 
 void main()
 {
     gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
-}
\ No newline at end of file
+}
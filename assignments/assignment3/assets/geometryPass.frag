@@ -8,7 +8,6 @@ in Surface{
 	vec3 WorldPos; 
 	vec3 WorldNormal;
 	vec2 TexCoord;
-	vec4 LightSpacePos;
 }fs_in;
 
 uniform sampler2D _MainTex;
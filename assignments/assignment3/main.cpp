@@ -3,15 +3,23 @@
 
 #include <ew/external/glad.h>
 #include <ew/shader.h>
+#include <ew/shaderCache.h>
+#include <ew/shaderBatch.h>
 #include <ew/model.h>
+#include <ew/assetStreamer.h>
+#include <ew/textureRegistry.h>
+#include <ew/lodSelector.h>
+#include <ew/frustum.h>
 #include <ew/camera.h>
 #include <ew/transform.h>
 #include <ew/cameraController.h>
 #include <ew/texture.h>
+#include <ew/textureCompression.h>
 #include <ew/procGen.h>
 
 #include <tslib/framebuffer.h>
-#include <tslib/shadowbuffer.h>
+#include <tslib/rendertargets.h>
+#include <tslib/cascadedshadows.h>
 
 #include <GLFW/glfw3.h>
 #include <imgui.h>
@@ -21,9 +29,9 @@
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 GLFWwindow* initWindow(const char* title, int width, int height);
 void drawUI();
+int drawMonkeys(ew::Model& model, const ew::Frustum& frustum, ew::LodSelector& selector, int* lodStates);
 
 ew::Camera camera;
-ew::Camera shadowCam;
 ew::CameraController cameraController;
 ew::Transform monkeyTransform;
 ew::Transform planeTransform;
@@ -33,9 +41,6 @@ int screenWidth = 1080;
 int screenHeight = 720;
 float prevFrameTime;
 float deltaTime;
-int shadowMapResolution = 2048;
-
-tslib::Shadowbuffer sb;
 tslib::Framebuffer gb;
 
 struct Material {
@@ -54,6 +59,38 @@ struct Light {
 	glm::vec3 lightColor = glm::vec3(1);
 }light;
 
+struct LevelOfDetail {
+	int numLods = 4;
+	int triangleBudget = 0;
+	int monkeyLods[64]; // Per monkey state for hysteresis, -1 until first selected
+	int shadowMonkeyLods[tslib::MAX_SHADOW_CASCADES][64]; // Each cascade selects detail for its own light camera
+}lod;
+
+struct Instancing {
+	static const int MAX_LODS = 8;
+	std::vector<glm::mat4> transforms[MAX_LODS]; // Monkey transforms bucketed by selected level
+	int drawCalls = 0; // Monkey draw calls of the last G-Buffer pass
+}instancing;
+
+// Cascades fitted to the camera frustum instead of one map over the whole scene
+struct ShadowSettings {
+	int resolution = 1024; // Per cascade
+	int cascadeCount = 3;
+	int activeCascades = 0; // Trails cascadeCount by a frame after it changes
+	unsigned int cascadeViews[tslib::MAX_SHADOW_CASCADES] = {};
+}shadowSettings;
+
+struct Streaming {
+	float budgetMs = 2.0f; // Upload time allowed per frame
+	int pending = 0;
+	double lastUpdateMs = 0.0;
+	size_t textureBytes = 0; // Resident in the texture registry
+	int textureCount = 0;
+}streaming;
+
+ew::LodSelector lodSelector;
+ew::LodSelector shadowLodSelector;
+
 struct PointLight {
 	glm::vec3 position;
 	float radius;
@@ -66,13 +103,22 @@ int main() {
 	GLFWwindow* window = initWindow("Assignment 0", screenWidth, screenHeight);
 	glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
 
-	// Init shaders and model
-	ew::Shader deferredShader = ew::Shader("assets/deferredLit.vert", "assets/deferredLit.frag");
-	ew::Shader convolutionShader = ew::Shader("assets/edge.vert", "assets/edge.frag");
-	ew::Shader depthShader = ew::Shader("assets/depthOnly.vert", "assets/depthOnly.frag");
-	ew::Shader gBufferShader = ew::Shader("assets/lit.vert", "assets/geometryPass.frag");
-	ew::Shader lightOrbShader = ew::Shader("assets/lightOrb.vert", "assets/lightOrb.frag");
-	ew::Model monkeyModel = ew::Model("assets/suzanne.obj");
+	// Submit shaders, they compile in the background while the rest of startup runs
+	ew::setShaderCacheDirectory("shadercache");
+	ew::ShaderBatch shaderBatch(window);
+	ew::ShaderFuture deferredFuture = shaderBatch.add("assets/deferredLit.vert", "assets/deferredLit.frag");
+	ew::ShaderFuture convolutionFuture = shaderBatch.add("assets/edge.vert", "assets/edge.frag");
+	ew::ShaderFuture depthFuture = shaderBatch.add("assets/depthOnly.vert", "assets/depthOnly.frag", { { "INSTANCED", "1" } });
+	ew::ShaderFuture gBufferFuture = shaderBatch.add("assets/lit.vert", "assets/geometryPass.frag", { { "INSTANCED", "1" } });
+	ew::ShaderFuture lightOrbFuture = shaderBatch.add("assets/lightOrb.vert", "assets/lightOrb.frag");
+
+	// Assets load in the background and draw as placeholders until ready, nearest to the camera first
+	// Each texture is decoded once however many materials use it, unused ones are evicted past 256 MB
+	ew::TextureRegistry textureRegistry(256 << 20);
+	ew::AssetStreamer assetStreamer(ew::WorkerPool::getShared(), 0, &textureRegistry);
+	glm::vec3 monkeyGridCenter = glm::vec3(17.5, 0, 17.5);
+	// Cooked on a worker on first launch, later launches map the .ewmesh instead of importing and simplifying again
+	ew::ModelHandle monkeyModel = assetStreamer.requestCookedModel("assets/suzanne.obj", monkeyGridCenter, ew::VertexFormat::FLOAT, lod.numLods);
 	ew::Mesh planeMesh = ew::Mesh(ew::createPlane(40, 40, 5));
 	ew::Mesh sphereMesh = ew::Mesh(ew::createSphere(1.0f, 8));
 
@@ -84,14 +130,14 @@ int main() {
 	camera.aspectRatio = (float)screenWidth / screenHeight;
 	camera.fov = 60.0f;
 
-	// Create Framebuffer
-	tslib::Framebuffer fb = tslib::createFramebuffer(screenWidth, screenHeight, GL_RGBA16);
-
-	// Check for complete framebuffer
-	GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
-		printf("Framebuffer incomplete: %d", fboStatus);
-	}
+	// Render targets are acquired per frame from a pool, so they follow the window size.
+	// The lighting target's depth matches the G-Buffer's so the orbs can depth test against a blit of it.
+	tslib::RenderTargetPool renderTargets;
+	tslib::RenderTargetDesc litColor;
+	litColor.format = GL_RGBA16;
+	tslib::RenderTargetDesc litDepth;
+	litDepth.format = GL_DEPTH_COMPONENT16;
+	litDepth.usage = tslib::RenderTargetUsage::DEPTH;
 
 	// Init Point Lights
 	for (int i = 0; i < 8; i++) {
@@ -102,28 +148,23 @@ int main() {
 		}
 	}
 
-	// Create Shadowbuffer
-	sb = tslib::createShadowbuffer(shadowMapResolution);
-
-	// Setup Shadow Camera
-	shadowCam.target = planeTransform.position;
-	shadowCam.position = shadowCam.target - light.lightDirection * 15.0f;
-	shadowCam.orthographic = true;
-	shadowCam.orthoHeight = 50.0;
-	shadowCam.nearPlane = 0.01f;
-	shadowCam.farPlane = 50.0f;
-	shadowCam.aspectRatio = 1.0;
+	for (int i = 0; i < 64; i++) {
+		lod.monkeyLods[i] = -1;
+		for (unsigned int c = 0; c < tslib::MAX_SHADOW_CASCADES; c++) {
+			lod.shadowMonkeyLods[c][i] = -1;
+		}
+	}
 
-	// Create GBuffer
-	gb = tslib::createGBuffer(screenWidth, screenHeight);
+	// Create cascaded shadow map, fitted to the camera every frame
+	tslib::CascadedShadowMap cascadedShadows(shadowSettings.resolution, shadowSettings.cascadeCount);
 
 	// Create Dummy VAO
 	unsigned int dummyVAO;
 	glCreateVertexArrays(1, &dummyVAO);
 
 	// Load Textures
-	GLuint monkeyTexture = ew::loadTexture("assets/cork.jpg");
-	GLuint groundTexture = ew::loadTexture("assets/brick_color.jpg");
+	ew::TextureHandle monkeyTexture = assetStreamer.requestTexture(ew::getCompressedTexturePath("assets/cork.jpg"), monkeyGridCenter);
+	ew::TextureHandle groundTexture = assetStreamer.requestTexture(ew::getCompressedTexturePath("assets/brick_color.jpg"), planeTransform.position);
 
 	GLenum attachments[] = { GL_COLOR_ATTACHMENT0 };
 	glDrawBuffers(1, attachments);
@@ -132,6 +173,14 @@ int main() {
 	glCullFace(GL_BACK);
 	glEnable(GL_DEPTH_TEST);
 
+	// Wait for shaders before first use
+	shaderBatch.wait();
+	ew::Shader deferredShader = deferredFuture.get();
+	ew::Shader convolutionShader = convolutionFuture.get();
+	ew::Shader depthShader = depthFuture.get();
+	ew::Shader gBufferShader = gBufferFuture.get();
+	ew::Shader lightOrbShader = lightOrbFuture.get();
+
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
 
@@ -140,32 +189,49 @@ int main() {
 		prevFrameTime = time;
 
 		cameraController.move(window, &camera, deltaTime);
-		shadowCam.position = shadowCam.target - light.lightDirection * 15.0f;
+		// A minimized window reports a zero size
+		if (screenWidth > 0 && screenHeight > 0) {
+			camera.aspectRatio = (float)screenWidth / screenHeight;
+		}
+		if (cascadedShadows.getCascadeCount() != (unsigned int)shadowSettings.cascadeCount) {
+			cascadedShadows.resize(shadowSettings.resolution, shadowSettings.cascadeCount);
+		}
+		cascadedShadows.update(camera, light.lightDirection);
+		shadowSettings.activeCascades = cascadedShadows.getCascadeCount();
+		for (unsigned int i = 0; i < cascadedShadows.getCascadeCount(); i++) {
+			shadowSettings.cascadeViews[i] = cascadedShadows.getCascadeView(i);
+		}
+
+		assetStreamer.update(camera.position, streaming.budgetMs);
+		streaming.pending = assetStreamer.getPendingCount();
+		streaming.lastUpdateMs = assetStreamer.getLastUpdateMs();
+		streaming.textureBytes = textureRegistry.getResidentBytes();
+		streaming.textureCount = textureRegistry.getResidentCount();
 
 		// Rotate model around Y axis
 		monkeyTransform.rotation = glm::rotate(monkeyTransform.rotation, deltaTime, glm::vec3(0.0, 1.0, 0.0));
 
-		// Render Shadow Map
-		glBindFramebuffer(GL_FRAMEBUFFER, sb.fbo);
-		glViewport(0, 0, sb.resolution, sb.resolution);
-		glClear(GL_DEPTH_BUFFER_BIT);
-
+		// Render Shadow Map, each cascade culls casters against its own light camera
 		depthShader.use();
-		depthShader.setMat4("_ViewProjection", shadowCam.projectionMatrix() * shadowCam.viewMatrix());
-
-		for (int i = 0; i < 8; i++) {
-			for (int j = 0; j < 8; j++) {
-				monkeyTransform.position = glm::vec3(i * 5, 0, j * 5);
-				depthShader.setInt("_MainTex", 0);
-				depthShader.setMat4("_Model", monkeyTransform.modelMatrix());
-				monkeyModel.draw();
-			}
+		for (unsigned int i = 0; i < cascadedShadows.getCascadeCount(); i++) {
+			cascadedShadows.bindCascade(i);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			depthShader.setMat4("_ViewProjection", cascadedShadows.getViewProjection(i));
+
+			// Shadow map texels are the pixels here
+			shadowLodSelector.begin(cascadedShadows.getCamera(i), (float)cascadedShadows.getResolution());
+			drawMonkeys(assetStreamer.getModel(monkeyModel), ew::Frustum(cascadedShadows.getViewProjection(i)), shadowLodSelector, lod.shadowMonkeyLods[i]);
+			shadowLodSelector.end();
 		}
 
 		// Bind textures
-		glBindTextureUnit(0, monkeyTexture);
-		glBindTextureUnit(1, groundTexture);
-		glBindTextureUnit(2, sb.shadowMap);
+		glBindTextureUnit(0, assetStreamer.getTexture(monkeyTexture));
+		glBindTextureUnit(1, assetStreamer.getTexture(groundTexture));
+
+		// Resizes rebuild screen sized targets on their next acquire
+		renderTargets.setScreenSize(screenWidth, screenHeight);
+		renderTargets.beginFrame();
+		gb = renderTargets.acquireGBuffer(tslib::GBufferLayout::FULL);
 
 		// Render to G-Buffer
 		glBindFramebuffer(GL_FRAMEBUFFER, gb.fbo);
@@ -176,20 +242,18 @@ int main() {
 		gBufferShader.use();
 		gBufferShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
 
-		for (int i = 0; i < 8; i++) {
-			for (int j = 0; j < 8; j++) {
-				monkeyTransform.position = glm::vec3(i * 5, 0, j * 5);
-				gBufferShader.setInt("_MainTex", 0);
-				gBufferShader.setMat4("_Model", monkeyTransform.modelMatrix());
-				monkeyModel.draw();
-			}
-		}
+		lodSelector.triangleBudget = lod.triangleBudget;
+		lodSelector.begin(camera, (float)gb.height);
+		gBufferShader.setInt("_MainTex", 0);
+		instancing.drawCalls = drawMonkeys(assetStreamer.getModel(monkeyModel), ew::Frustum(camera.projectionMatrix() * camera.viewMatrix()), lodSelector, lod.monkeyLods);
+		lodSelector.end();
 
 		gBufferShader.setInt("_MainTex", 1);
-		gBufferShader.setMat4("_Model", planeTransform.modelMatrix());
-		planeMesh.draw();
+		glm::mat4 planeModel = planeTransform.modelMatrix();
+		planeMesh.drawInstanced(&planeModel, 1);
 
 		// Bind framebuffer
+		tslib::Framebuffer fb = renderTargets.acquireFramebuffer(&litColor, 1, &litDepth);
 		glBindFramebuffer(GL_FRAMEBUFFER, fb.fbo);
 		glViewport(0, 0, fb.width, fb.height);
 		glClearColor(0.6f, 0.8f, 0.92f, 1.0f);
@@ -199,10 +263,10 @@ int main() {
 		// Shader Setup
 		deferredShader.use();
 
-		deferredShader.setInt("_ShadowMap", 3);
 		deferredShader.setVec3("_EyePos", camera.position);
 		deferredShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
-		deferredShader.setMat4("_LightViewProj", shadowCam.projectionMatrix() * shadowCam.viewMatrix());
+		deferredShader.setMat4("_View", camera.viewMatrix());
+		cascadedShadows.setUniforms(deferredShader, 3);
 		deferredShader.setVec3("_LightDirection", light.lightDirection);
 		deferredShader.setVec3("_LightColor", light.lightColor);
 
@@ -221,7 +285,6 @@ int main() {
 		glBindTextureUnit(0, gb.colorBuffers[0]);
 		glBindTextureUnit(1, gb.colorBuffers[1]);
 		glBindTextureUnit(2, gb.colorBuffers[2]);
-		glBindTextureUnit(3, sb.shadowMap);
 		
 		glBindVertexArray(dummyVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 3);
@@ -229,7 +292,8 @@ int main() {
 		// Draw Orbs
 		glBindFramebuffer(GL_READ_FRAMEBUFFER, gb.fbo);
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb.fbo);
-		glBlitFramebuffer(0, 0, screenWidth, screenHeight, 0, 0, screenWidth, screenHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		glBlitFramebuffer(0, 0, gb.width, gb.height, 0, 0, fb.width, fb.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		renderTargets.releaseFramebuffer(gb);
 
 		lightOrbShader.use();
 		lightOrbShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
@@ -246,6 +310,7 @@ int main() {
 
 		// Bind
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, screenWidth, screenHeight);
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -255,6 +320,7 @@ int main() {
 		glBindTextureUnit(0, fb.colorBuffers[0]);
 		glBindVertexArray(dummyVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 3);
+		renderTargets.releaseFramebuffer(fb);
 
 		drawUI();
 
@@ -262,9 +328,6 @@ int main() {
 		glfwPollEvents();
 	}
 
-	glad_glDeleteFramebuffers(1, &fb.fbo);
-	glad_glDeleteFramebuffers(1, &sb.fbo);
-
 	printf("Shutting down...");
 }
 
@@ -274,6 +337,37 @@ void resetCamera(ew::Camera* camera, ew::CameraController* controller) {
 	controller->yaw = controller->pitch = 0;
 }
 
+// Buckets the 8x8 monkey grid by selected level of detail and draws each bucket as one instanced draw,
+// skipping monkeys outside frustum. Expects a shader compiled with INSTANCED 1 to be in use. Returns the number of draw calls.
+int drawMonkeys(ew::Model& model, const ew::Frustum& frustum, ew::LodSelector& selector, int* lodStates) {
+	glm::vec3 boundsCenter = (model.getBoundsMin() + model.getBoundsMax()) * 0.5f;
+	float boundsRadius = glm::length(model.getBoundsMax() - model.getBoundsMin()) * 0.5f;
+	for (int i = 0; i < Instancing::MAX_LODS; i++) {
+		instancing.transforms[i].clear();
+	}
+	for (int i = 0; i < 8; i++) {
+		for (int j = 0; j < 8; j++) {
+			monkeyTransform.position = glm::vec3(i * 5, 0, j * 5);
+			glm::mat4 transform = monkeyTransform.modelMatrix();
+			glm::vec3 center = glm::vec3(transform * glm::vec4(boundsCenter, 1.0f));
+			float scale = glm::max(monkeyTransform.scale.x, glm::max(monkeyTransform.scale.y, monkeyTransform.scale.z));
+			if (frustum.sphereOutside(center, boundsRadius * scale)) {
+				continue;
+			}
+			int level = glm::min(selector.select(model, transform, &lodStates[i * 8 + j]), Instancing::MAX_LODS - 1);
+			instancing.transforms[level].push_back(transform);
+		}
+	}
+	int drawCalls = 0;
+	for (int i = 0; i < Instancing::MAX_LODS; i++) {
+		if (!instancing.transforms[i].empty()) {
+			model.drawInstanced(instancing.transforms[i], i);
+			drawCalls += (int)model.getMeshes().size();
+		}
+	}
+	return drawCalls;
+}
+
 void drawUI() {
 	ImGui_ImplGlfw_NewFrame();
 	ImGui_ImplOpenGL3_NewFrame();
@@ -298,6 +392,28 @@ void drawUI() {
 		ImGui::SliderFloat("Z", &light.lightDirection.z, -2.0f, 2.0f);
 	}
 
+	if (ImGui::CollapsingHeader("Level of Detail")) {
+		ImGui::SliderFloat("Pixel Error", &lodSelector.pixelError, 0.25f, 16.0f);
+		ImGui::SliderFloat("Hysteresis", &lodSelector.hysteresis, 0.0f, 0.9f);
+		ImGui::InputInt("Triangle Budget", &lod.triangleBudget, 1000, 10000);
+		lod.triangleBudget = glm::max(lod.triangleBudget, 0);
+		ImGui::Text("Monkey Triangles: %u", lodSelector.getTriangleCount());
+		ImGui::Text("Monkey Draw Calls: %d", instancing.drawCalls);
+		shadowLodSelector.pixelError = lodSelector.pixelError;
+		shadowLodSelector.hysteresis = lodSelector.hysteresis;
+	}
+
+	if (ImGui::CollapsingHeader("Shadows")) {
+		ImGui::SliderInt("Cascades", &shadowSettings.cascadeCount, 2, tslib::MAX_SHADOW_CASCADES);
+	}
+
+	if (ImGui::CollapsingHeader("Streaming")) {
+		ImGui::SliderFloat("Upload Budget (ms)", &streaming.budgetMs, 0.0f, 16.0f);
+		ImGui::Text("Pending Assets: %d", streaming.pending);
+		ImGui::Text("Last Update: %.2f ms", streaming.lastUpdateMs);
+		ImGui::Text("Textures: %d resident, %.1f MB", streaming.textureCount, streaming.textureBytes / (1024.0 * 1024.0));
+	}
+
 	if (ImGui::Button("Toggle Edge Detect")) {
 		edge.enabled = !edge.enabled;
 	}
@@ -307,9 +423,15 @@ void drawUI() {
 	ImGui::Begin("Shadow Map"); {
 		ImGui::BeginChild("Shadow Map");
 
+		// Cascades side by side, nearest first
 		ImVec2 windowSize = ImGui::GetWindowSize();
-
-		ImGui::Image((ImTextureID)sb.shadowMap, windowSize, ImVec2(0, 1), ImVec2(1, 0));
+		float cascadeSize = glm::min(windowSize.x / shadowSettings.activeCascades, windowSize.y);
+		for (int i = 0; i < shadowSettings.activeCascades; i++) {
+			if (i > 0) {
+				ImGui::SameLine(0.0f, 0.0f);
+			}
+			ImGui::Image((ImTextureID)shadowSettings.cascadeViews[i], ImVec2(cascadeSize, cascadeSize), ImVec2(0, 1), ImVec2(1, 0));
+		}
 		ImGui::EndChild();
 		ImGui::End();
 	}
@@ -1,11 +1,52 @@
 #version 450
 
-layout (location = 0) in vec3 vPos;
+// Compile with QUANTIZED_POSITIONS 1 for ew::VertexFormat::PACKED_QUANTIZED meshes,
+// MULTI_DRAW 1 for meshes in an ew::GeometryArena drawn through ew::DrawList
+#ifndef QUANTIZED_POSITIONS
+#define QUANTIZED_POSITIONS 0
+#endif
+#ifndef MULTI_DRAW
+#define MULTI_DRAW 0
+#endif
+
+#if MULTI_DRAW
+// Drawn by ew::DrawList, the model matrix and dequantization come from the draw's entry in _Draws
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+
+#if QUANTIZED_POSITIONS
+layout(location = 0) in vec3 vPosQuantized; // unorm16 position inside the mesh bounds
+#if !MULTI_DRAW
+layout(location = 3) in vec3 vPosScale; // Dequantization transform, set by ew::Mesh::draw
+layout(location = 4) in vec3 vPosOffset;
+#endif
+#else
+layout(location = 0) in vec3 vPos; // Vertex position in model space
+#endif
 
 uniform mat4 _ViewProjection;
+#if MULTI_DRAW
+struct DrawData {
+	mat4 model;
+	vec4 positionScale;
+	vec4 positionOffset;
+};
+layout(std430, binding = 2) readonly buffer DrawDataBuffer {
+	DrawData _Draws[];
+};
+#else
 uniform mat4 _Model;
+#endif
 
 void main()
 {
+#if MULTI_DRAW
+	mat4 _Model = _Draws[gl_DrawIDARB].model;
+	vec3 vPosScale = _Draws[gl_DrawIDARB].positionScale.xyz;
+	vec3 vPosOffset = _Draws[gl_DrawIDARB].positionOffset.xyz;
+#endif
+#if QUANTIZED_POSITIONS
+	vec3 vPos = vPosQuantized * vPosScale + vPosOffset;
+#endif
     gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
 }
\ No newline at end of file
@@ -3,27 +3,31 @@ out vec4 FragColor;
 in vec2 UV;
 
 uniform sampler2D _ColorBuffer;
-uniform int _Enabled;
 uniform int _Intensity;
 
+// Compile with EDGE_DETECT 1 for the edge kernel, otherwise the color buffer is passed through
+#ifndef EDGE_DETECT
+#define EDGE_DETECT 0
+#endif
+
 #define edgeKernel mat3(-1, -1, -1, -1, 8, -1, -1, -1, -1)
 
 void main() {
-	if (_Enabled == 0) {
-		vec3 color = texture(_ColorBuffer, UV).rgb;
-		FragColor = vec4(color, 1.0);
-	} else {
-		vec2 texelSize = 1.0 / textureSize(_ColorBuffer, 0).xy;
-		vec3 totalColor = vec3(0);
-		for (int x = 0; x < 3; x++)
+#if EDGE_DETECT
+	vec2 texelSize = 1.0 / textureSize(_ColorBuffer, 0).xy;
+	vec3 totalColor = vec3(0);
+	for (int x = 0; x < 3; x++)
+	{
+		for (int y = 0; y < 3; y++)
 		{
-			for (int y = 0; y < 3; y++)
-			{
-				vec2 offset = vec2(x, y) * texelSize;
-				totalColor += texture(_ColorBuffer, UV + offset).rgb * edgeKernel[x][y];
-			}
+			vec2 offset = vec2(x, y) * texelSize;
+			totalColor += texture(_ColorBuffer, UV + offset).rgb * edgeKernel[x][y];
 		}
-
-		FragColor = vec4(totalColor,1.0);
 	}
+
+	FragColor = vec4(totalColor,1.0);
+#else
+	vec3 color = texture(_ColorBuffer, UV).rgb;
+	FragColor = vec4(color, 1.0);
+#endif
 }
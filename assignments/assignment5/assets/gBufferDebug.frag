@@ -0,0 +1,26 @@
+#version 450
+out vec4 FragColor;
+
+in vec2 UV;
+
+// 0 = albedo, 1 = world normal, 2 = world position
+uniform int _Channel;
+
+#include "tslib/gBuffer.glsl"
+
+void main(){
+	vec3 pos, normal, albedo;
+	if (!readGBuffer(UV, pos, normal, albedo)) {
+		FragColor = vec4(0, 0, 0, 1);
+		return;
+	}
+
+	vec3 color = albedo;
+	if (_Channel == 1) {
+		color = normal * 0.5 + 0.5;
+	}
+	else if (_Channel == 2) {
+		color = fract(pos);
+	}
+	FragColor = vec4(color, 1.0);
+}
@@ -1,20 +1,49 @@
 #version 450
 
+// Compile with COMPACT_GBUFFER 1 for tslib::GBufferLayout::COMPACT
+#ifndef COMPACT_GBUFFER
+#define COMPACT_GBUFFER 0
+#endif
+
+#if COMPACT_GBUFFER
+// Position is rebuilt from depth by the lighting pass
+layout(location = 0) out vec2 gNormal;
+layout(location = 1) out vec4 gAlbedo;
+#else
 layout(location = 0) out vec3 gPosition;
 layout(location = 1) out vec3 gNormal;
 layout(location = 2) out vec3 gAlbedo;
+#endif
 
 in Surface{
 	vec3 WorldPos; 
 	vec3 WorldNormal;
 	vec2 TexCoord;
-	vec4 LightSpacePos;
 }fs_in;
 
 uniform sampler2D _MainTex;
+// Stored in albedo alpha, 0 marks pixels with no surface
+uniform uint _MaterialBits = 1u;
+
+#if COMPACT_GBUFFER
+// Unit vector folded onto an octahedron then flattened to [-1,1]^2
+vec2 octEncode(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	if (n.z < 0.0) {
+		vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signs;
+	}
+	return n.xy;
+}
+#endif
 
 void main(){
+#if COMPACT_GBUFFER
+	gAlbedo = vec4(texture(_MainTex,fs_in.TexCoord).rgb, float(_MaterialBits) / 255.0);
+	gNormal = octEncode(normalize(fs_in.WorldNormal));
+#else
 	gPosition = fs_in.WorldPos;
 	gAlbedo = texture(_MainTex,fs_in.TexCoord).rgb;
 	gNormal = normalize(fs_in.WorldNormal);
+#endif
 }
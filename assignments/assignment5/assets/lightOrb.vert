@@ -1,11 +1,25 @@
 #version 450 core
 
-//Vertex attributes
-layout(location = 0) in vec3 vPos;
+// Compile with QUANTIZED_POSITIONS 1 for ew::VertexFormat::PACKED_QUANTIZED meshes
+#ifndef QUANTIZED_POSITIONS
+#define QUANTIZED_POSITIONS 0
+#endif
+
+// Vertex attributes
+#if QUANTIZED_POSITIONS
+layout(location = 0) in vec3 vPosQuantized; // unorm16 position inside the mesh bounds
+layout(location = 3) in vec3 vPosScale; // Dequantization transform, set by ew::Mesh::draw
+layout(location = 4) in vec3 vPosOffset;
+#else
+layout(location = 0) in vec3 vPos; // Vertex position in model space
+#endif
 
 uniform mat4 _Model; 
 uniform mat4 _ViewProjection;
 
 void main(){
+#if QUANTIZED_POSITIONS
+	vec3 vPos = vPosQuantized * vPosScale + vPosOffset;
+#endif
 	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
 }
@@ -1,25 +1,84 @@
 #version 450
 
+// Compile with PACKED_NORMALS 1 for ew::VertexFormat::PACKED meshes, add QUANTIZED_POSITIONS 1 for PACKED_QUANTIZED.
+// MULTI_DRAW 1 for meshes in an ew::GeometryArena drawn through ew::DrawList.
+#ifndef PACKED_NORMALS
+#define PACKED_NORMALS 0
+#endif
+#ifndef QUANTIZED_POSITIONS
+#define QUANTIZED_POSITIONS 0
+#endif
+#ifndef MULTI_DRAW
+#define MULTI_DRAW 0
+#endif
+
+#if MULTI_DRAW
+// Drawn by ew::DrawList, the model matrix and dequantization come from the draw's entry in _Draws
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+
 // Vertex attributes
+#if QUANTIZED_POSITIONS
+layout(location = 0) in vec3 vPosQuantized; // unorm16 position inside the mesh bounds
+#if !MULTI_DRAW
+layout(location = 3) in vec3 vPosScale; // Dequantization transform, set by ew::Mesh::draw
+layout(location = 4) in vec3 vPosOffset;
+#endif
+#else
 layout(location = 0) in vec3 vPos; // Vertex position in model space
-layout(location = 1) in vec3 vNormal; // Vertex position in model space
+#endif
+#if PACKED_NORMALS
+layout(location = 1) in vec2 vNormalOct; // Octahedral encoded normal
+#else
+layout(location = 1) in vec3 vNormal; // Vertex normal in model space
+#endif
 layout(location = 2) in vec2 vTexCoord; // Vertex texture coordinate (UV)
 
+#if MULTI_DRAW
+struct DrawData {
+	mat4 model;
+	vec4 positionScale;
+	vec4 positionOffset;
+};
+layout(std430, binding = 2) readonly buffer DrawDataBuffer {
+	DrawData _Draws[];
+};
+#else
 uniform mat4 _Model; // Model->World Matrix
+#endif
 uniform mat4 _ViewProjection; // Combined View->Projection Matrix
-uniform mat4 _LightViewProj; //view + projection of light source camera
 
 out Surface{
 	vec3 WorldPos; // Vertex position in world space
 	vec3 WorldNormal; // Vertex normal in world space
 	vec2 TexCoord;
-	vec4 LightSpacePos;
 }vs_out;
 
+#if PACKED_NORMALS
+// Unfolds an octahedral encoded normal back onto the unit sphere
+vec3 decodeOctahedral(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+#endif
+
 void main(){
+#if MULTI_DRAW
+	mat4 _Model = _Draws[gl_DrawIDARB].model;
+	vec3 vPosScale = _Draws[gl_DrawIDARB].positionScale.xyz;
+	vec3 vPosOffset = _Draws[gl_DrawIDARB].positionOffset.xyz;
+#endif
+#if QUANTIZED_POSITIONS
+	vec3 vPos = vPosQuantized * vPosScale + vPosOffset;
+#endif
+#if PACKED_NORMALS
+	vec3 vNormal = decodeOctahedral(vNormalOct);
+#endif
 	vs_out.WorldPos = vec3(_Model * vec4(vPos,1.0));
 	vs_out.WorldNormal = transpose(inverse(mat3(_Model))) * vNormal;
 	vs_out.TexCoord = vTexCoord;
-	vs_out.LightSpacePos = _LightViewProj * _Model * vec4(vPos, 1.0);
 	gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
 }
@@ -0,0 +1,113 @@
+#version 450
+out vec4 FragColor; //The color of this fragment
+
+in vec2 UV;
+
+uniform sampler2D _MainTex;
+uniform vec3 _EyePos;
+uniform vec3 _LightDirection;
+uniform vec3 _LightColor;
+uniform vec3 _AmbientColor = vec3(0.3,0.4,0.46);
+
+#include "tslib/cascadedShadows.glsl"
+
+struct PointLight{
+	vec3 position;
+	float radius;
+	vec4 color;
+};
+// Filled by tslib::PointLightBuffer
+layout(std430, binding = 1) readonly buffer PointLights {
+	uint _NumPointLights;
+	PointLight _PointLights[];
+};
+
+
+struct Material{
+	float Ka; //Ambient coefficient (0-1)
+	float Kd; //Diffuse coefficient (0-1)
+	float Ks; //Specular coefficient (0-1)
+	float Shininess; //Affects size of specular highlight
+};
+uniform Material _Material;
+
+#include "tslib/gBuffer.glsl"
+
+// Must match tslib/lighttiles.h. MAX_LIGHTS_PER_TILE can be overridden to match LightTiles::maxLightsPerTile.
+#define TILE_SIZE 16
+#ifndef MAX_LIGHTS_PER_TILE
+#define MAX_LIGHTS_PER_TILE 256
+#endif
+
+// Per tile light lists from lightCulling.comp, [count, index0, index1, ...]
+layout(std430, binding = 0) readonly buffer TileLights {
+	uint _TileLightData[];
+};
+uniform int _NumTilesX;
+
+float attenuateExponential(float distance, float radius) {
+	float i = clamp(1.0 - pow(distance/radius,4.0),0.0,1.0);
+	return i * i;
+}
+
+vec3 calcPointLight(PointLight light,vec3 normal,vec3 pos,vec3 toEye){
+	vec3 diff = light.position - pos;
+
+	//Direction toward light position
+	vec3 toLight = normalize(diff);
+
+	// Blinn-Phong calculations
+	float diffuseFactor = max(dot(normal, toLight),0.0);
+
+	vec3 h = normalize(toLight + toEye);
+	float specularFactor = pow(max(dot(normal, h), 0.0), _Material.Shininess);
+
+	vec3 lightColor = (diffuseFactor + specularFactor) * vec3(light.color);
+
+	// Attenuation
+	float d = length(diff); //Distance to light
+	lightColor *= attenuateExponential(d, light.radius);
+	return lightColor;
+}
+
+
+vec3 calculateLighting(vec3 normal, vec3 worldPos) {
+	vec3 toLight = -_LightDirection;
+	float diffuseFactor = max(dot(normal, toLight),0.0);
+	vec3 toEye = normalize(_EyePos - worldPos);
+	vec3 h = normalize(toLight + toEye);
+	float specularFactor = pow(max(dot(normal, h), 0.0), _Material.Shininess);
+
+	vec3 diffuse = _Material.Kd * diffuseFactor * _LightColor;
+	vec3 specular = _Material.Ks * specularFactor * _LightColor;
+	vec3 ambient = _Material.Ka * _AmbientColor;
+
+	float shadow = calcShadow(_ShadowMap, worldPos, normal, _LightDirection);
+	vec3 light = ambient + (diffuse + specular) * (1.0 - shadow);
+
+	return light;
+}
+
+void main(){
+	vec3 pos, normal, albedo;
+	// Nothing was drawn here
+	if (!readGBuffer(UV, pos, normal, albedo)) {
+		FragColor = vec4(0);
+		return;
+	}
+	vec3 toEye = normalize(_EyePos - pos);
+
+	vec3 totalLight = vec3(0);
+	totalLight += calculateLighting(normal, pos);
+
+	// Only shade the lights binned into this pixel's tile
+	ivec2 tile = ivec2(gl_FragCoord.xy) / TILE_SIZE;
+	uint tileOffset = (tile.y * _NumTilesX + tile.x) * (MAX_LIGHTS_PER_TILE + 1);
+	uint numLights = _TileLightData[tileOffset];
+	for (uint i = 0; i < numLights; i++) {
+		uint lightIndex = _TileLightData[tileOffset + 1 + i];
+		totalLight += calcPointLight(_PointLights[lightIndex], normal, pos, toEye);
+	}
+
+	FragColor = vec4(albedo * totalLight, 0);
+}
@@ -3,15 +3,30 @@
 
 #include <ew/external/glad.h>
 #include <ew/shader.h>
+#include <ew/shaderCache.h>
+#include <ew/shaderBatch.h>
+#include <ew/shaderVariants.h>
 #include <ew/model.h>
+#include <ew/assetStreamer.h>
+#include <ew/textureRegistry.h>
+#include <ew/lodSelector.h>
+#include <ew/meshletCuller.h>
+#include <ew/geometryArena.h>
+#include <ew/drawList.h>
 #include <ew/camera.h>
 #include <ew/transform.h>
 #include <ew/cameraController.h>
 #include <ew/texture.h>
+#include <ew/textureCompression.h>
 #include <ew/procGen.h>
+#include <ew/meshOptimizer.h>
 
 #include <tslib/framebuffer.h>
-#include <tslib/shadowbuffer.h>
+#include <tslib/rendertargets.h>
+#include <tslib/framegraph.h>
+#include <tslib/cascadedshadows.h>
+#include <tslib/lighttiles.h>
+#include <tslib/pointlights.h>
 
 #include <GLFW/glfw3.h>
 #include <imgui.h>
@@ -23,7 +38,6 @@ GLFWwindow* initWindow(const char* title, int width, int height);
 void drawUI();
 
 ew::Camera camera;
-ew::Camera shadowCam;
 ew::CameraController cameraController;
 ew::Transform monkeyTransform;
 ew::Transform planeTransform;
@@ -33,9 +47,9 @@ int screenWidth = 1080;
 int screenHeight = 720;
 float prevFrameTime;
 float deltaTime;
-int shadowMapResolution = 2048;
+// Vertex layout of every mesh, the geometry shaders are compiled to match
+const ew::VertexFormat vertexFormat = ew::VertexFormat::PACKED_QUANTIZED;
 
-tslib::Shadowbuffer sb;
 tslib::Framebuffer gb;
 
 struct Material {
@@ -49,18 +63,126 @@ struct EdgeDetect {
 	bool enabled = 0;
 }edge;
 
+struct TiledLighting {
+	bool enabled = true;
+	int maxLightsPerTile = tslib::MAX_LIGHTS_PER_TILE;
+	float gpuTimeMs = 0.0f;
+}tiledLighting;
+
+// Compact trades the position target for a depth reconstruction in the lighting pass
+struct GBufferSettings {
+	tslib::GBufferLayout layout = tslib::GBufferLayout::COMPACT;
+	unsigned int bytesPerPixel = 0;
+}gBufferSettings;
+
+// Screen sized targets come from a pool each frame instead of living for the whole run
+struct RenderTargetStats {
+	size_t allocatedBytes = 0;
+	size_t peakBytes = 0;
+	unsigned int createdCount = 0; // Stays flat unless the window or a layout changes
+}renderTargetStats;
+
+// One G-Buffer attachment decoded into a quarter size target, its pass is culled while hidden
+struct GBufferDebug {
+	bool enabled = false;
+	int channel = 0; // 0 = albedo, 1 = normal, 2 = position
+	unsigned int texture = 0; // Only valid while the UI pass runs
+}gBufferDebug;
+
+// Passes the frame graph ran or culled last frame
+struct FrameGraphStats {
+	std::vector<tslib::FrameGraph::PassTiming> timings;
+	unsigned int barrierCount = 0;
+	bool printTimings = false;
+}frameGraphStats;
+
+// Cascades fitted to the camera frustum instead of one map over the whole scene
+struct ShadowSettings {
+	int pcfSize = 3;
+	int resolution = 1024; // Per cascade
+	int cascadeCount = 3;
+	float splitLambda = 0.75f;
+	float distance = 40.0f;
+	// The ground and pillars are drawn into a cache that is only redrawn when they or the light camera move
+	bool staticCaching = true;
+	// Filled each frame for the UI
+	int activeCascades = 0; // Trails cascadeCount by a frame after it changes
+	unsigned int cascadeViews[tslib::MAX_SHADOW_CASCADES] = {};
+	float cascadeSplits[tslib::MAX_SHADOW_CASCADES] = {};
+	float texelSizes[tslib::MAX_SHADOW_CASCADES] = {};
+	unsigned int texelCount = 0;
+	unsigned int staticRefreshes[tslib::MAX_SHADOW_CASCADES] = {};
+	unsigned int staticReuses[tslib::MAX_SHADOW_CASCADES] = {};
+}shadowSettings;
+
+// Ring of pillars around the mech, static shadow casters
+struct Pillars {
+	int count = 8;
+	float ringRadius = 4.0f;
+	float placedRadius = 0.0f; // Ring radius the transforms were built for
+	std::vector<glm::mat4> transforms;
+}pillars;
+
 struct Light {
 	glm::vec3 lightDirection = glm::vec3(-1.0, -1.0, -1.0);
 	glm::vec3 lightColor = glm::vec3(1);
 }light;
 
-struct PointLight {
-	glm::vec3 position;
-	float radius;
-	glm::vec4 color;
+struct PointLightSettings {
+	int count = 0;
+	int prevCount = 0;
+	float radius = 2.0f;
+}pointLightSettings;
+
+// Views that select levels of detail, each node keeps a level per view
+enum LodView {
+	LOD_VIEW_CAMERA,
+	LOD_VIEW_SHADOW, // First shadow cascade, the others follow it
+	LOD_VIEW_COUNT = LOD_VIEW_SHADOW + tslib::MAX_SHADOW_CASCADES
 };
-const int MAX_POINT_LIGHTS = 64;
-PointLight pointLights[MAX_POINT_LIGHTS];
+
+struct LevelOfDetail {
+	int numLods = 4;
+	int triangleBudget = 0;
+	ew::LodSelector selectors[LOD_VIEW_COUNT];
+}levelOfDetail;
+
+struct MeshletCulling {
+	bool frustum = true;
+	bool backface = true;
+	ew::MeshletCuller cullers[LOD_VIEW_COUNT];
+}meshletCulling;
+
+// Rolling waves over the ground plane, rewritten into a dynamic mesh every frame
+struct Ground {
+	bool animated = false;
+	int subdivisions = 128;
+	float amplitude = 0.25f;
+	float wavelength = 3.0f;
+	float speed = 1.0f;
+	bool deformed = false; // Vertices differ from the flat plane
+	unsigned int growCount = 0;
+}ground;
+
+// Draws every mech node with one glMultiDrawElementsIndirect per pass instead of meshlet culled draws per node
+struct MultiDraw {
+	bool enabled = true;
+	std::vector<int> monkeyMeshes; // Handles in the geometry arena
+	unsigned int drawCount[LOD_VIEW_COUNT] = {};
+	unsigned int culledCount[LOD_VIEW_COUNT] = {};
+	unsigned int streamStalls = 0; // Frames that waited on the GPU before writing draw data
+	unsigned int streamOverflows = 0; // Draw lists that didn't fit in the frame's region and used their own buffers
+	size_t streamBytes = 0; // Draw data written into the stream buffer last frame
+}multiDraw;
+
+// Textures load in the background, drawing a placeholder until ready
+struct Streaming {
+	float budgetMs = 2.0f; // Upload time allowed per frame
+	int pending = 0;
+	double lastUpdateMs = 0.0;
+	size_t textureBytes = 0; // Resident in the texture registry
+	int textureCount = 0;
+}streaming;
 
 struct KeyFrame {
 	glm::vec3 position;
@@ -150,9 +272,16 @@ struct Node {
 	Node* parent;
 	Node* children[10];
 	unsigned int numChildren;
+	int lodState[LOD_VIEW_COUNT]; // Level drawn last frame, for hysteresis, -1 until first selected
 
 	AnimationClip animation;
 
+	Node() {
+		for (int i = 0; i < LOD_VIEW_COUNT; i++) {
+			lodState[i] = -1;
+		}
+	}
+
 	void Update(float dt) {
 		if (animation.numKeyFrames != 0)
 			localTransform = animation.Update(dt);
@@ -219,13 +348,117 @@ void UpdateAnimsRecursive(Node* node, float dt) {
 		UpdateAnimsRecursive(node->children[i], dt);
 }
 
-void DrawNodesRecursive(ew::Shader shader, ew::Model model, Node* node) {
-	shader.setInt("_MainTex", 0);
-	shader.setMat4("_Model", node->globalTransform);
-	model.draw();
+// Hashed at compile time, resolved against each shader's uniform table
+constexpr unsigned int MODEL_UNIFORM = ew::uniformHash("_Model");
+
+void DrawNodesRecursive(const ew::Shader& shader, ew::UniformLocation modelUniform, ew::Model& model, Node* node, LodView view) {
+	shader.setMat4(modelUniform, node->globalTransform);
+	int lod = levelOfDetail.selectors[view].select(model, node->globalTransform, &node->lodState[view]);
+	meshletCulling.cullers[view].draw(model, node->globalTransform, lod);
 
 	for (int i = 0; i < node->numChildren; i++)
-		DrawNodesRecursive(shader, model, node->children[i]);
+		DrawNodesRecursive(shader, modelUniform, model, node->children[i], view);
+}
+
+// Same as DrawNodesRecursive, but queues the node's arena meshes on a draw list
+void QueueNodesRecursive(ew::DrawList& drawList, const ew::Model& model, Node* node, LodView view) {
+	int lod = levelOfDetail.selectors[view].select(model, node->globalTransform, &node->lodState[view]);
+	for (int mesh : multiDraw.monkeyMeshes)
+		drawList.add(mesh, node->globalTransform, lod);
+
+	for (int i = 0; i < node->numChildren; i++)
+		QueueNodesRecursive(drawList, model, node->children[i], view);
+}
+
+// Displaces the flat plane's vertices along two crossing sine waves, with analytic normals
+void DeformGround(std::vector<ew::Vertex>& vertices, const std::vector<ew::Vertex>& flat, float time) {
+	float k = 2.0f * glm::pi<float>() / ground.wavelength;
+	float phase = time * ground.speed;
+	for (size_t i = 0; i < flat.size(); i++) {
+		glm::vec3 p = flat[i].pos;
+		float sx = sinf(p.x * k + phase), cx = cosf(p.x * k + phase);
+		float sz = sinf(p.z * k * 0.7f + phase), cz = cosf(p.z * k * 0.7f + phase);
+		vertices[i].pos.y = p.y + ground.amplitude * sx * cz;
+		glm::vec3 dx = glm::vec3(1.0f, ground.amplitude * k * cx * cz, 0.0f);
+		glm::vec3 dz = glm::vec3(0.0f, -ground.amplitude * k * 0.7f * sx * sz, 1.0f);
+		vertices[i].normal = glm::normalize(glm::cross(dz, dx));
+	}
+}
+
+// Lays out lights in a grid over the ground plane
+void CreatePointLights(tslib::PointLightBuffer* lights, int count, float radius) {
+	lights->clear();
+
+	int gridSize = (int)ceil(sqrt((float)count));
+	float spacing = 10.0f / gridSize;
+	for (int i = 0; i < count; i++) {
+		tslib::PointLight pointLight;
+		pointLight.position = glm::vec3((i % gridSize + 0.5f) * spacing - 5.0f, -1.5f, (i / gridSize + 0.5f) * spacing - 5.0f);
+		pointLight.radius = radius;
+		pointLight.color = glm::vec4(rand() % 4, rand() % 4, rand() % 4, 1);
+		lights->add(pointLight);
+	}
+}
+
+ew::ShaderDefines VertexDefines() {
+	return {
+		{ "PACKED_NORMALS", vertexFormat != ew::VertexFormat::FLOAT ? "1" : "0" },
+		{ "QUANTIZED_POSITIONS", vertexFormat == ew::VertexFormat::PACKED_QUANTIZED ? "1" : "0" }
+	};
+}
+
+// Shader variants for the current settings. Each distinct set is compiled once, on first use.
+ew::ShaderDefines MultiDrawDefines() {
+	ew::ShaderDefines defines = VertexDefines();
+	defines.push_back({ "MULTI_DRAW", "1" });
+	return defines;
+}
+
+const char* CompactGBufferDefine() {
+	return gBufferSettings.layout == tslib::GBufferLayout::COMPACT ? "1" : "0";
+}
+
+ew::ShaderDefines GBufferDefines() {
+	ew::ShaderDefines defines = VertexDefines();
+	defines.push_back({ "COMPACT_GBUFFER", CompactGBufferDefine() });
+	return defines;
+}
+
+ew::ShaderDefines GBufferMultiDrawDefines() {
+	ew::ShaderDefines defines = MultiDrawDefines();
+	defines.push_back({ "COMPACT_GBUFFER", CompactGBufferDefine() });
+	return defines;
+}
+
+ew::ShaderDefines LightingDefines() {
+	return { { "PCF_SIZE", std::to_string(shadowSettings.pcfSize) }, { "COMPACT_GBUFFER", CompactGBufferDefine() } };
+}
+
+ew::ShaderDefines TiledLightingDefines() {
+	return { { "PCF_SIZE", std::to_string(shadowSettings.pcfSize) }, { "MAX_LIGHTS_PER_TILE", std::to_string(tiledLighting.maxLightsPerTile) },
+		{ "COMPACT_GBUFFER", CompactGBufferDefine() } };
+}
+
+ew::ShaderDefines LightCullingDefines() {
+	return { { "MAX_LIGHTS_PER_TILE", std::to_string(tiledLighting.maxLightsPerTile) } };
+}
+
+ew::ShaderDefines GBufferDebugDefines() {
+	return { { "COMPACT_GBUFFER", CompactGBufferDefine() } };
+}
+
+ew::ShaderDefines EdgeDefines() {
+	return { { "EDGE_DETECT", edge.enabled ? "1" : "0" } };
+}
+
+// Casters that only move when the ground is deformed or the pillars are moved
+void DrawStaticCasters(const ew::Shader& shader, const ew::Mesh& planeMesh, const ew::Mesh& pillarMesh) {
+	shader.setMat4("_Model", planeTransform.modelMatrix());
+	planeMesh.draw();
+	for (const glm::mat4& transform : pillars.transforms) {
+		shader.setMat4("_Model", transform);
+		pillarMesh.draw();
+	}
 }
 
 void ClearNodesRecursive(Node* node) {
@@ -239,15 +472,52 @@ int main() {
 	GLFWwindow* window = initWindow("Assignment 5", screenWidth, screenHeight);
 	glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
 
-	// Init shaders and model
-	ew::Shader deferredShader = ew::Shader("assets/deferredLit.vert", "assets/deferredLit.frag");
-	ew::Shader convolutionShader = ew::Shader("assets/edge.vert", "assets/edge.frag");
-	ew::Shader depthShader = ew::Shader("assets/depthOnly.vert", "assets/depthOnly.frag");
-	ew::Shader gBufferShader = ew::Shader("assets/lit.vert", "assets/geometryPass.frag");
-	ew::Shader lightOrbShader = ew::Shader("assets/lightOrb.vert", "assets/lightOrb.frag");
-	ew::Model monkeyModel = ew::Model("assets/suzanne.obj");
-	ew::Mesh planeMesh = ew::Mesh(ew::createPlane(10, 10, 5));
-	ew::Mesh sphereMesh = ew::Mesh(ew::createSphere(1.0f, 8));
+	// Submit shaders, they compile in the background while the model and textures load
+	ew::setShaderCacheDirectory("shadercache");
+	double startupTime = glfwGetTime();
+	ew::ShaderBatch shaderBatch(window);
+	ew::ShaderFuture depthFuture = shaderBatch.add("assets/depthOnly.vert", "assets/depthOnly.frag", VertexDefines());
+	ew::ShaderFuture lightOrbFuture = shaderBatch.add("assets/lightOrb.vert", "assets/lightOrb.frag", VertexDefines());
+	ew::ShaderFuture depthMultiDrawFuture = shaderBatch.add("assets/depthOnly.vert", "assets/depthOnly.frag", MultiDrawDefines());
+
+	// Shaders specialized by settings, the startup variants compile with the rest
+	ew::ShaderVariants gBufferVariants("assets/lit.vert", "assets/geometryPass.frag");
+	ew::ShaderVariants deferredVariants("assets/deferredLit.vert", "assets/deferredLit.frag");
+	ew::ShaderVariants tiledDeferredVariants("assets/deferredLit.vert", "assets/tiledDeferredLit.frag");
+	ew::ShaderVariants lightCullingVariants("assets/lightCulling.comp");
+	// The edge and debug passes only run once toggled on in the UI, their variants compile then
+	ew::ShaderVariants convolutionVariants("assets/edge.vert", "assets/edge.frag");
+	ew::ShaderVariants gBufferDebugVariants("assets/deferredLit.vert", "assets/gBufferDebug.frag");
+	gBufferVariants.prewarm(shaderBatch, GBufferDefines());
+	gBufferVariants.prewarm(shaderBatch, GBufferMultiDrawDefines());
+	deferredVariants.prewarm(shaderBatch, LightingDefines());
+	tiledDeferredVariants.prewarm(shaderBatch, TiledLightingDefines());
+	lightCullingVariants.prewarm(shaderBatch, LightCullingDefines());
+
+	// Init model
+	std::vector<ew::MeshData> monkeyData = ew::loadModelMeshData("assets/suzanne.obj", levelOfDetail.numLods);
+	ew::Model monkeyModel = ew::Model(monkeyData, vertexFormat);
+
+	// Shared buffers for multi-draw, the model's meshes are added once and drawn per node
+	ew::GeometryArena geometryArena(1 << 16, 1 << 18, vertexFormat);
+	for (const ew::MeshData& meshData : monkeyData)
+		multiDraw.monkeyMeshes.push_back(geometryArena.add(meshData));
+	// Per frame draw data goes into a persistently mapped ring, one region per frame in flight
+	ew::StreamBuffer frameStream(1 << 20);
+	ew::DrawList shadowDrawList(geometryArena, &frameStream);
+	ew::DrawList cameraDrawList(geometryArena, &frameStream);
+	// The ground is dynamic so it can be deformed every frame without reallocating
+	ew::MeshData planeFlat = ew::createPlane(10, 10, ground.subdivisions);
+	ew::MeshData sphereData = ew::createSphere(1.0f, 8);
+	ew::MeshData pillarData = ew::createCylinder(0.3f, 3.0f, 16);
+	ew::optimizeMesh(planeFlat);
+	ew::optimizeMesh(sphereData);
+	ew::optimizeMesh(pillarData);
+	ew::MeshData planeData = planeFlat;
+	int planeSubdivisions = ground.subdivisions;
+	ew::Mesh planeMesh = ew::Mesh(planeData, vertexFormat, ew::MeshUsage::DYNAMIC);
+	ew::Mesh sphereMesh = ew::Mesh(sphereData, vertexFormat);
+	ew::Mesh pillarMesh = ew::Mesh(pillarData, vertexFormat);
 
 	planeTransform.position = glm::vec3(0, -2.0, 0);
 
@@ -257,46 +527,49 @@ int main() {
 	camera.aspectRatio = (float)screenWidth / screenHeight;
 	camera.fov = 60.0f;
 
-	// Create Framebuffer
-	tslib::Framebuffer fb = tslib::createFramebuffer(screenWidth, screenHeight, GL_RGBA16);
-
-	// Check for complete framebuffer
-	GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
-		printf("Framebuffer incomplete: %d", fboStatus);
-	}
+	// Render targets are acquired per frame, the lighting pass only needs color since nothing depth tests against it
+	tslib::RenderTargetPool renderTargets;
+	renderTargets.setScreenSize(screenWidth, screenHeight);
+	tslib::RenderTargetDesc litTarget;
+	litTarget.format = GL_RGBA16;
+	tslib::RenderTargetDesc gBufferDebugTarget;
+	gBufferDebugTarget.format = GL_RGBA8;
+	gBufferDebugTarget.scale = 0.25f;
+	// Passes are declared every frame and run through the graph, which takes its targets from the pool
+	tslib::FrameGraph frameGraph(renderTargets);
 
 	// Init Point Lights
-	/*for (int i = 0; i < 8; i++) {
-		for (int j = 0; j < 8; j++) {
-			pointLights[i * 8 + j].color = glm::vec4(rand() % 4, rand() % 4, rand() % 4, 1);
-			pointLights[i * 8 + j].radius = 6.0f;
-			pointLights[i * 8 + j].position = glm::vec3((i * 5) + 2.5f, -0.5, (j * 5) + 2.5f);
-		}
-	}*/
+	tslib::PointLightBuffer pointLights;
+	CreatePointLights(&pointLights, pointLightSettings.count, pointLightSettings.radius);
 
-	// Create Shadowbuffer
-	sb = tslib::createShadowbuffer(shadowMapResolution);
+	// Create cascaded shadow map, fitted to the camera every frame
+	tslib::CascadedShadowMap cascadedShadows(shadowSettings.resolution, shadowSettings.cascadeCount);
 
-	// Setup Shadow Camera
-	shadowCam.target = planeTransform.position;
-	shadowCam.position = shadowCam.target - light.lightDirection * 15.0f;
-	shadowCam.orthographic = true;
-	shadowCam.orthoHeight = 50.0;
-	shadowCam.nearPlane = 0.01f;
-	shadowCam.farPlane = 50.0f;
-	shadowCam.aspectRatio = 1.0;
+	// G-Buffer targets are frame graph transients, its size is measured the first time the pass runs
+	tslib::GBufferLayout gBufferLayout = gBufferSettings.layout;
 
-	// Create GBuffer
-	gb = tslib::createGBuffer(screenWidth, screenHeight);
+	// Create light tiles
+	tslib::LightTiles lightTiles = tslib::createLightTiles(screenWidth, screenHeight, tiledLighting.maxLightsPerTile);
 
 	// Create Dummy VAO
 	unsigned int dummyVAO;
 	glCreateVertexArrays(1, &dummyVAO);
 
 	// Load Textures
-	GLuint monkeyTexture = ew::loadTexture("assets/cork.jpg");
-	GLuint groundTexture = ew::loadTexture("assets/cormn.png");
+	// The model stays synchronous since the geometry arena needs its mesh data up front
+	// Each texture is decoded once however many materials use it, unused ones are evicted past 256 MB
+	ew::TextureRegistry textureRegistry(256 << 20);
+	ew::AssetStreamer assetStreamer(ew::WorkerPool::getShared(), 0, &textureRegistry);
+	ew::TextureHandle monkeyTexture = assetStreamer.requestTexture(ew::getCompressedTexturePath("assets/cork.jpg"));
+	ew::TextureHandle groundTexture = assetStreamer.requestTexture(ew::getCompressedTexturePath("assets/cormn.png"), planeTransform.position);
+
+	// Wait for shaders before first use
+	double assetsLoadedTime = glfwGetTime();
+	shaderBatch.wait();
+	ew::Shader depthShader = depthFuture.get();
+	ew::Shader lightOrbShader = lightOrbFuture.get();
+	ew::Shader depthMultiDrawShader = depthMultiDrawFuture.get();
+	printf("Startup: assets loaded in %.2f ms, shaders ready %.2f ms later\n", (assetsLoadedTime - startupTime) * 1000.0, (glfwGetTime() - assetsLoadedTime) * 1000.0);
 
 	GLenum attachments[] = { GL_COLOR_ATTACHMENT0 };
 	glDrawBuffers(1, attachments);
@@ -356,117 +629,348 @@ int main() {
 		prevFrameTime = time;
 
 		cameraController.move(window, &camera, deltaTime);
-		shadowCam.position = shadowCam.target - light.lightDirection * 15.0f;
+		// A minimized window reports a zero size
+		if (screenWidth > 0 && screenHeight > 0) {
+			camera.aspectRatio = (float)screenWidth / screenHeight;
+		}
+
+		frameStream.beginFrame();
+
+		assetStreamer.update(camera.position, streaming.budgetMs);
+		streaming.pending = assetStreamer.getPendingCount();
+		streaming.lastUpdateMs = assetStreamer.getLastUpdateMs();
+		streaming.textureBytes = textureRegistry.getResidentBytes();
+		streaming.textureCount = textureRegistry.getResidentCount();
+
+		// Regenerate the ground at a new resolution, only growing its buffers when they are too small
+		if (planeSubdivisions != ground.subdivisions) {
+			planeSubdivisions = ground.subdivisions;
+			planeFlat = ew::createPlane(10, 10, planeSubdivisions);
+			ew::optimizeMesh(planeFlat);
+			planeData = planeFlat;
+			planeMesh.load(planeData, vertexFormat, ew::MeshUsage::DYNAMIC);
+			ground.deformed = false;
+			ground.growCount = planeMesh.getGrowCount();
+			cascadedShadows.invalidateStatic();
+		}
+		if (ground.animated) {
+			DeformGround(planeData.vertices, planeFlat.vertices, time);
+			planeMesh.updateVertices(planeData.vertices);
+			ground.deformed = true;
+			cascadedShadows.invalidateStatic();
+		}
+		else if (ground.deformed) {
+			planeData.vertices = planeFlat.vertices;
+			planeMesh.updateVertices(planeData.vertices);
+			ground.deformed = false;
+			cascadedShadows.invalidateStatic();
+		}
+
+		// Place the pillars evenly around the ring, standing on the ground
+		if (pillars.placedRadius != pillars.ringRadius) {
+			pillars.placedRadius = pillars.ringRadius;
+			pillars.transforms.clear();
+			for (int i = 0; i < pillars.count; i++) {
+				float angle = 2.0f * glm::pi<float>() * i / pillars.count;
+				glm::vec3 position = planeTransform.position + glm::vec3(cosf(angle) * pillars.ringRadius, 1.5f, sinf(angle) * pillars.ringRadius);
+				pillars.transforms.push_back(glm::translate(glm::mat4(1.0f), position));
+			}
+			cascadedShadows.invalidateStatic();
+		}
+
+		// Fit the cascades after the static casters are updated, so moving them invalidates this frame's cache
+		if (cascadedShadows.getResolution() != (unsigned int)shadowSettings.resolution || cascadedShadows.getCascadeCount() != (unsigned int)shadowSettings.cascadeCount) {
+			cascadedShadows.resize(shadowSettings.resolution, shadowSettings.cascadeCount);
+		}
+		cascadedShadows.setStaticCaching(shadowSettings.staticCaching);
+		cascadedShadows.splitLambda = shadowSettings.splitLambda;
+		cascadedShadows.shadowDistance = shadowSettings.distance;
+		cascadedShadows.update(camera, light.lightDirection);
+		shadowSettings.activeCascades = cascadedShadows.getCascadeCount();
+		shadowSettings.texelCount = cascadedShadows.getTexelCount() * (cascadedShadows.getStaticCaching() ? 2 : 1);
+		for (unsigned int i = 0; i < cascadedShadows.getCascadeCount(); i++) {
+			shadowSettings.cascadeViews[i] = cascadedShadows.getCascadeView(i);
+			shadowSettings.cascadeSplits[i] = cascadedShadows.getSplit(i);
+			shadowSettings.texelSizes[i] = cascadedShadows.getTexelSize(i);
+			shadowSettings.staticRefreshes[i] = cascadedShadows.getStaticRefreshCount(i);
+			shadowSettings.staticReuses[i] = cascadedShadows.getStaticReuseCount(i);
+		}
 
 		// Update Animations and Solve Transforms
 		UpdateAnimsRecursive(torso, deltaTime);
 		SolveFKRecursive(torso);
 
-		// Render Shadow Map
-		glBindFramebuffer(GL_FRAMEBUFFER, sb.fbo);
-		glViewport(0, 0, sb.resolution, sb.resolution);
-		glClear(GL_DEPTH_BUFFER_BIT);
-
-		depthShader.use();
-		depthShader.setMat4("_ViewProjection", shadowCam.projectionMatrix() * shadowCam.viewMatrix());
-
-		DrawNodesRecursive(depthShader, monkeyModel, torso);
-
-		// Bind textures
-		glBindTextureUnit(0, monkeyTexture);
-		glBindTextureUnit(1, groundTexture);
-		glBindTextureUnit(2, sb.shadowMap);
-
-		// Render to G-Buffer
-		glBindFramebuffer(GL_FRAMEBUFFER, gb.fbo);
-		glViewport(0, 0, gb.width, gb.height);
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		gBufferShader.use();
-		gBufferShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
-
-		DrawNodesRecursive(gBufferShader, monkeyModel, torso);
-
-		gBufferShader.setInt("_MainTex", 1);
-		gBufferShader.setMat4("_Model", planeTransform.modelMatrix());
-		planeMesh.draw();
-
-		// Bind framebuffer
-		glBindFramebuffer(GL_FRAMEBUFFER, fb.fbo);
-		glViewport(0, 0, fb.width, fb.height);
-		glClearColor(0.6f, 0.8f, 0.92f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glCullFace(GL_BACK);
-
-		// Shader Setup
-		deferredShader.use();
-
-		deferredShader.setInt("_ShadowMap", 3);
-		deferredShader.setVec3("_EyePos", camera.position);
-		deferredShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
-		deferredShader.setMat4("_LightViewProj", shadowCam.projectionMatrix() * shadowCam.viewMatrix());
-		deferredShader.setVec3("_LightDirection", light.lightDirection);
-		deferredShader.setVec3("_LightColor", light.lightColor);
-
-		deferredShader.setFloat("_Material.Ka", material.Ka);
-		deferredShader.setFloat("_Material.Kd", material.Kd);
-		deferredShader.setFloat("_Material.Ks", material.Ks);
-		deferredShader.setFloat("_Material.Shininess", material.Shininess);
-
-		for (int i = 0; i < MAX_POINT_LIGHTS; i++) {
-			std::string prefix = "_PointLights[" + std::to_string(i) + "].";
-			deferredShader.setVec3(prefix + "position", pointLights[i].position);
-			deferredShader.setFloat(prefix + "radius", pointLights[i].radius);
-			deferredShader.setVec4(prefix + "color", pointLights[i].color);
+		// Resizes rebuild screen sized targets on their next acquire, targets of an old layout are freed once idle
+		renderTargets.setScreenSize(screenWidth, screenHeight);
+		renderTargets.beginFrame();
+
+		// Tile lists are sized by the G-Buffer and the per tile light limit
+		unsigned int targetWidth, targetHeight;
+		renderTargets.getSize(litTarget, targetWidth, targetHeight);
+		if (lightTiles.maxLightsPerTile != tiledLighting.maxLightsPerTile || lightTiles.width != targetWidth || lightTiles.height != targetHeight) {
+			glDeleteBuffers(1, &lightTiles.ssbo);
+			lightTiles = tslib::createLightTiles(targetWidth, targetHeight, tiledLighting.maxLightsPerTile);
+		}
+
+		// Upload changed point lights
+		if (pointLightSettings.count != pointLightSettings.prevCount) {
+			CreatePointLights(&pointLights, pointLightSettings.count, pointLightSettings.radius);
+			pointLightSettings.prevCount = pointLightSettings.count;
+		}
+		pointLights.upload();
+		pointLights.bind(1);
+
+		// Declare this frame's passes, the graph culls the ones nothing displays and orders the rest
+		frameGraph.reset();
+		tslib::Framebuffer backbuffer = tslib::Framebuffer();
+		backbuffer.fbo = 0;
+		backbuffer.width = screenWidth;
+		backbuffer.height = screenHeight;
+		tslib::FrameGraphResource backbufferTarget = frameGraph.importTarget("Backbuffer", backbuffer);
+		tslib::FrameGraphResource shadowMap = frameGraph.importTexture("Shadow Map", cascadedShadows.getTexture());
+		tslib::FrameGraphResource staticShadows = cascadedShadows.getStaticCaching() ? frameGraph.importTexture("Static Shadows", cascadedShadows.getStaticTexture()) : tslib::FrameGraphResource();
+		tslib::FrameGraphResource lightTileList = frameGraph.importBuffer("Light Tiles", lightTiles.ssbo);
+
+		int gBufferFormats[3];
+		tslib::RenderTargetDesc gBufferDepthDesc;
+		gBufferDepthDesc.usage = tslib::RenderTargetUsage::DEPTH;
+		unsigned int numGBufferColors = tslib::getGBufferFormats(gBufferSettings.layout, gBufferFormats, gBufferDepthDesc.format);
+		tslib::FrameGraphResource gBufferColors[3];
+		for (unsigned int i = 0; i < numGBufferColors; i++) {
+			tslib::RenderTargetDesc desc;
+			desc.format = gBufferFormats[i];
+			gBufferColors[i] = frameGraph.createTexture("G-Buffer " + std::to_string(i), desc);
+		}
+		tslib::FrameGraphResource gBufferDepth = frameGraph.createTexture("G-Buffer Depth", gBufferDepthDesc);
+		// Without edge detection nothing post processes the lit image, so lighting draws straight to the screen
+		tslib::FrameGraphResource litColor = edge.enabled ? frameGraph.createTexture("Lit", litTarget) : backbufferTarget;
+		tslib::FrameGraphResource gBufferDebugView = frameGraph.createTexture("G-Buffer Debug", gBufferDebugTarget);
+
+		// Lighting and the debug view sample the G-Buffer the same way
+		bool compactGBuffer = gBufferSettings.layout == tslib::GBufferLayout::COMPACT;
+		auto bindGBuffer = [&]() {
+			if (compactGBuffer) {
+				glBindTextureUnit(0, frameGraph.getTexture(gBufferDepth));
+				glBindTextureUnit(1, frameGraph.getTexture(gBufferColors[0]));
+				glBindTextureUnit(2, frameGraph.getTexture(gBufferColors[1]));
+			}
+			else {
+				glBindTextureUnit(0, frameGraph.getTexture(gBufferColors[0]));
+				glBindTextureUnit(1, frameGraph.getTexture(gBufferColors[1]));
+				glBindTextureUnit(2, frameGraph.getTexture(gBufferColors[2]));
+			}
+		};
+
+		// Only cascades whose light camera moved, or whose casters did, redraw the static casters
+		if (staticShadows.valid()) {
+			frameGraph.addPass("Static Shadow Cache", tslib::PassType::RASTER, [&]() {
+				depthShader.use();
+				for (unsigned int i = 0; i < cascadedShadows.getCascadeCount(); i++) {
+					if (!cascadedShadows.needsStaticRefresh(i)) {
+						continue;
+					}
+					cascadedShadows.bindStaticCascade(i);
+					glClear(GL_DEPTH_BUFFER_BIT);
+					depthShader.setMat4("_ViewProjection", cascadedShadows.getViewProjection(i));
+					DrawStaticCasters(depthShader, planeMesh, pillarMesh);
+				}
+			}).write(staticShadows);
+		}
+
+		// Each cascade culls casters and picks their detail against its own light camera.
+		// With caching the static casters are a depth copy and only the mech is drawn.
+		frameGraph.addPass("Shadow Map", tslib::PassType::RASTER, [&]() {
+			for (unsigned int i = 0; i < cascadedShadows.getCascadeCount(); i++) {
+				LodView view = (LodView)(LOD_VIEW_SHADOW + i);
+				const ew::Camera& cascadeCam = cascadedShadows.getCamera(i);
+				cascadedShadows.bindCascade(i);
+				if (staticShadows.valid()) {
+					cascadedShadows.copyStaticCascade(i);
+				}
+				else {
+					glClear(GL_DEPTH_BUFFER_BIT);
+					depthShader.use();
+					depthShader.setMat4("_ViewProjection", cascadedShadows.getViewProjection(i));
+					DrawStaticCasters(depthShader, planeMesh, pillarMesh);
+				}
+
+				// Shadow map texels are the pixels here
+				ew::LodSelector& shadowLods = levelOfDetail.selectors[view];
+				shadowLods.begin(cascadeCam, (float)cascadedShadows.getResolution());
+				if (multiDraw.enabled) {
+					depthMultiDrawShader.use();
+					depthMultiDrawShader.setMat4("_ViewProjection", cascadedShadows.getViewProjection(i));
+					shadowDrawList.begin(cascadeCam);
+					QueueNodesRecursive(shadowDrawList, monkeyModel, torso, view);
+					shadowDrawList.draw();
+					multiDraw.drawCount[view] = shadowDrawList.getDrawCount();
+					multiDraw.culledCount[view] = shadowDrawList.getCulledCount();
+				}
+				else {
+					depthShader.use();
+					depthShader.setMat4("_ViewProjection", cascadedShadows.getViewProjection(i));
+					meshletCulling.cullers[view].begin(cascadeCam);
+					DrawNodesRecursive(depthShader, depthShader.getUniformLocation(MODEL_UNIFORM), monkeyModel, torso, view);
+				}
+				shadowLods.end();
+			}
+		}).read(staticShadows).write(shadowMap);
+
+		frameGraph.addPass("G-Buffer", tslib::PassType::RASTER, [&]() {
+			gb = frameGraph.getFramebuffer();
+			if (gBufferSettings.bytesPerPixel == 0 || gBufferLayout != gBufferSettings.layout) {
+				gBufferLayout = gBufferSettings.layout;
+				gBufferSettings.bytesPerPixel = tslib::getBytesPerPixel(gb);
+			}
+			// Alpha must clear to 0, in the compact layout albedo alpha 0 marks pixels with no surface
+			const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			const float clearDepth = 1.0f;
+			for (unsigned int i = 0; i < gb.numColorBuffers; i++) {
+				glClearBufferfv(GL_COLOR, i, clearColor);
+			}
+			glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+
+			glBindTextureUnit(0, assetStreamer.getTexture(monkeyTexture));
+			glBindTextureUnit(1, assetStreamer.getTexture(groundTexture));
+
+			// The shaders switch variants to match the layout
+			const ew::Shader& gBufferShader = gBufferVariants.get(GBufferDefines());
+			const ew::Shader& gBufferMultiDrawShader = gBufferVariants.get(GBufferMultiDrawDefines());
+
+			ew::LodSelector& cameraLods = levelOfDetail.selectors[LOD_VIEW_CAMERA];
+			cameraLods.triangleBudget = levelOfDetail.triangleBudget;
+			cameraLods.begin(camera, (float)gb.height);
+			if (multiDraw.enabled) {
+				gBufferMultiDrawShader.use();
+				gBufferMultiDrawShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+				gBufferMultiDrawShader.setInt("_MainTex", 0);
+				cameraDrawList.begin(camera);
+				QueueNodesRecursive(cameraDrawList, monkeyModel, torso, LOD_VIEW_CAMERA);
+				cameraDrawList.draw();
+				multiDraw.drawCount[LOD_VIEW_CAMERA] = cameraDrawList.getDrawCount();
+				multiDraw.culledCount[LOD_VIEW_CAMERA] = cameraDrawList.getCulledCount();
+			}
+			else {
+				gBufferShader.use();
+				gBufferShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+				gBufferShader.setInt("_MainTex", 0);
+				meshletCulling.cullers[LOD_VIEW_CAMERA].begin(camera);
+				DrawNodesRecursive(gBufferShader, gBufferShader.getUniformLocation(MODEL_UNIFORM), monkeyModel, torso, LOD_VIEW_CAMERA);
+			}
+			cameraLods.end();
+
+			gBufferShader.use();
+			gBufferShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+			gBufferShader.setInt("_MainTex", 1);
+			DrawStaticCasters(gBufferShader, planeMesh, pillarMesh);
+		}).write(gBufferColors[0]).write(gBufferColors[1]).write(gBufferColors[2]).write(gBufferDepth);
+
+		// Bin point lights into screen tiles, culled unless the tiled lighting shader reads them
+		frameGraph.addPass("Light Culling", tslib::PassType::COMPUTE, [&]() {
+			const ew::Shader& lightCullingShader = lightCullingVariants.get(LightCullingDefines());
+			lightCullingShader.use();
+			lightCullingShader.setMat4("_View", camera.viewMatrix());
+			lightCullingShader.setMat4("_InvProjection", glm::inverse(camera.projectionMatrix()));
+			tslib::dispatchLightCulling(lightTiles, frameGraph.getTexture(gBufferDepth));
+		}).read(gBufferDepth).write(lightTileList);
+
+		tslib::FrameGraphPassBuilder lightingPass = frameGraph.addPass("Lighting", tslib::PassType::RASTER, [&]() {
+			glClearColor(0.6f, 0.8f, 0.92f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glCullFace(GL_BACK);
+
+			// Shader Setup
+			const ew::Shader& lightingShader = tiledLighting.enabled ? tiledDeferredVariants.get(TiledLightingDefines()) : deferredVariants.get(LightingDefines());
+			lightingShader.use();
+
+			lightingShader.setVec3("_EyePos", camera.position);
+			lightingShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+			lightingShader.setMat4("_InvViewProjection", glm::inverse(camera.projectionMatrix() * camera.viewMatrix()));
+			lightingShader.setMat4("_View", camera.viewMatrix());
+			lightingShader.setVec3("_LightDirection", light.lightDirection);
+			lightingShader.setVec3("_LightColor", light.lightColor);
+
+			lightingShader.setFloat("_Material.Ka", material.Ka);
+			lightingShader.setFloat("_Material.Kd", material.Kd);
+			lightingShader.setFloat("_Material.Ks", material.Ks);
+			lightingShader.setFloat("_Material.Shininess", material.Shininess);
+
+			if (tiledLighting.enabled) {
+				lightingShader.setInt("_NumTilesX", lightTiles.numTilesX);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, frameGraph.getBuffer(lightTileList));
+			}
+
+			bindGBuffer();
+			cascadedShadows.setUniforms(lightingShader, 3);
+
+			glBindVertexArray(dummyVAO);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		});
+		lightingPass.read(gBufferColors[0]).read(gBufferColors[1]).read(gBufferColors[2]).read(shadowMap).write(litColor);
+		if (compactGBuffer) {
+			lightingPass.read(gBufferDepth);
+		}
+		if (tiledLighting.enabled) {
+			lightingPass.read(lightTileList);
 		}
 
-		glBindTextureUnit(0, gb.colorBuffers[0]);
-		glBindTextureUnit(1, gb.colorBuffers[1]);
-		glBindTextureUnit(2, gb.colorBuffers[2]);
-		glBindTextureUnit(3, sb.shadowMap);
-		
-		glBindVertexArray(dummyVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
-
-		// Draw Orbs
-		/*glBindFramebuffer(GL_READ_FRAMEBUFFER, gb.fbo);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb.fbo);
-		glBlitFramebuffer(0, 0, screenWidth, screenHeight, 0, 0, screenWidth, screenHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-
-		lightOrbShader.use();
-		lightOrbShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
-		for (int i = 0; i < MAX_POINT_LIGHTS; i++)
-		{
-			glm::mat4 m = glm::mat4(1.0f);
-			m = glm::translate(m, pointLights[i].position);
-			m = glm::scale(m, glm::vec3(0.3f));
-
-			lightOrbShader.setMat4("_Model", m);
-			lightOrbShader.setVec3("_Color", pointLights[i].color);
-			sphereMesh.draw();
-		}*/
-
-		// Bind
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		convolutionShader.use();
-		convolutionShader.setInt("_Enabled", edge.enabled);
-
-		glBindTextureUnit(0, fb.colorBuffers[0]);
-		glBindVertexArray(dummyVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
-
-		drawUI();
+		// Culled unless the GBuffers window shows it
+		frameGraph.addPass("G-Buffer Debug", tslib::PassType::RASTER, [&]() {
+			const ew::Shader& gBufferDebugShader = gBufferDebugVariants.get(GBufferDebugDefines());
+			gBufferDebugShader.use();
+			gBufferDebugShader.setInt("_Channel", gBufferDebug.channel);
+			gBufferDebugShader.setMat4("_InvViewProjection", glm::inverse(camera.projectionMatrix() * camera.viewMatrix()));
+			bindGBuffer();
+
+			glBindVertexArray(dummyVAO);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		}).read(gBufferColors[0]).read(gBufferColors[1]).read(gBufferColors[2]).read(gBufferDepth).write(gBufferDebugView);
+
+		if (edge.enabled) {
+			frameGraph.addPass("Edge Detect", tslib::PassType::RASTER, [&]() {
+				glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				const ew::Shader& convolutionShader = convolutionVariants.get(EdgeDefines());
+				convolutionShader.use();
+
+				glBindTextureUnit(0, frameGraph.getTexture(litColor));
+				glBindVertexArray(dummyVAO);
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+			}).read(litColor).write(backbufferTarget);
+		}
+
+		// Draws over the frame, which is what keeps the passes before it alive
+		frameGraph.addPass("UI", tslib::PassType::RASTER, [&]() {
+			gBufferDebug.texture = gBufferDebug.enabled ? frameGraph.getTexture(gBufferDebugView) : 0;
+			drawUI();
+		}).read(backbufferTarget).write(backbufferTarget).read(gBufferDebug.enabled ? gBufferDebugView : tslib::FrameGraphResource()).sideEffect();
+
+		frameGraph.compile();
+		frameGraph.execute();
+
+		tiledLighting.gpuTimeMs = frameGraph.getGpuMs("Lighting");
+		frameGraphStats.timings = frameGraph.getTimings();
+		frameGraphStats.barrierCount = frameGraph.getBarrierCount();
+		if (frameGraphStats.printTimings) {
+			frameGraph.printTimings();
+			frameGraphStats.printTimings = false;
+		}
+
+		renderTargetStats.allocatedBytes = renderTargets.getAllocatedBytes();
+		renderTargetStats.peakBytes = renderTargets.getPeakBytes();
+		renderTargetStats.createdCount = renderTargets.getCreatedCount();
+
+		multiDraw.streamStalls = frameStream.getStallCount();
+		multiDraw.streamOverflows = frameStream.getOverflowCount();
+		multiDraw.streamBytes = frameStream.getUsedBytes();
+		frameStream.endFrame();
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
-	glad_glDeleteFramebuffers(1, &fb.fbo);
-	glad_glDeleteFramebuffers(1, &sb.fbo);
+	glDeleteBuffers(1, &lightTiles.ssbo);
 
 	ClearNodesRecursive(torso);
 
@@ -496,6 +1000,33 @@ void drawUI() {
 		ImGui::SliderFloat("Shininess", &material.Shininess, 2.0f, 1024.0f);
 	}
 
+	if (ImGui::CollapsingHeader("Shadows")) {
+		// Odd kernel widths only
+		int pcfIndex = shadowSettings.pcfSize / 2;
+		if (ImGui::Combo("PCF Kernel", &pcfIndex, "1x1\0" "3x3\0" "5x5\0" "7x7\0")) {
+			shadowSettings.pcfSize = pcfIndex * 2 + 1;
+		}
+		ImGui::SliderInt("Cascades", &shadowSettings.cascadeCount, 2, tslib::MAX_SHADOW_CASCADES);
+		// Power of two sizes from 512 to 2048
+		int resolutionIndex = shadowSettings.resolution / 1024;
+		if (ImGui::Combo("Cascade Resolution", &resolutionIndex, "512\0" "1024\0" "2048\0")) {
+			shadowSettings.resolution = 512 << resolutionIndex;
+		}
+		ImGui::SliderFloat("Split Blend (uniform - log)", &shadowSettings.splitLambda, 0.0f, 1.0f);
+		ImGui::SliderFloat("Shadow Distance", &shadowSettings.distance, 5.0f, 100.0f);
+		for (int i = 0; i < shadowSettings.activeCascades; i++) {
+			ImGui::Text("Cascade %d: to %.1f, %.4f units/texel", i, shadowSettings.cascadeSplits[i], shadowSettings.texelSizes[i]);
+		}
+		ImGui::Text("Shadow texels: %.2f M, %.1f MB", shadowSettings.texelCount / 1000000.0f, shadowSettings.texelCount * 2 / (1024.0f * 1024.0f));
+		ImGui::Checkbox("Cache Static Casters", &shadowSettings.staticCaching);
+		ImGui::SliderFloat("Pillar Ring Radius", &pillars.ringRadius, 1.0f, 5.0f);
+		if (shadowSettings.staticCaching) {
+			for (int i = 0; i < shadowSettings.activeCascades; i++) {
+				ImGui::Text("Cascade %d static casters: %u redraws, %u frames cached", i, shadowSettings.staticRefreshes[i], shadowSettings.staticReuses[i]);
+			}
+		}
+	}
+
 	if (ImGui::CollapsingHeader("Light Direction"))
 	{
 		ImGui::SliderFloat("X", &light.lightDirection.x, -2.0f, 2.0f);
@@ -503,27 +1034,131 @@ void drawUI() {
 		ImGui::SliderFloat("Z", &light.lightDirection.z, -2.0f, 2.0f);
 	}
 
+	if (ImGui::CollapsingHeader("Ground")) {
+		ImGui::Checkbox("Animated", &ground.animated);
+		ImGui::SliderInt("Subdivisions", &ground.subdivisions, 5, 512);
+		ImGui::SliderFloat("Amplitude", &ground.amplitude, 0.0f, 1.0f);
+		ImGui::SliderFloat("Wavelength", &ground.wavelength, 0.5f, 10.0f);
+		ImGui::SliderFloat("Speed", &ground.speed, 0.0f, 5.0f);
+		ImGui::Text("Buffer reallocations: %u", ground.growCount);
+	}
+
+	if (ImGui::CollapsingHeader("Streaming")) {
+		ImGui::SliderFloat("Upload Budget (ms)", &streaming.budgetMs, 0.0f, 16.0f);
+		ImGui::Text("Pending Assets: %d", streaming.pending);
+		ImGui::Text("Last Update: %.2f ms", streaming.lastUpdateMs);
+		ImGui::Text("Textures: %d resident, %.1f MB", streaming.textureCount, streaming.textureBytes / (1024.0 * 1024.0));
+	}
+
+	if (ImGui::CollapsingHeader("Level of Detail")) {
+		ew::LodSelector& cameraLods = levelOfDetail.selectors[LOD_VIEW_CAMERA];
+		ImGui::SliderFloat("Pixel Error", &cameraLods.pixelError, 0.25f, 16.0f);
+		ImGui::SliderFloat("Hysteresis", &cameraLods.hysteresis, 0.0f, 0.9f);
+		ImGui::InputInt("Triangle Budget", &levelOfDetail.triangleBudget, 1000, 10000);
+		levelOfDetail.triangleBudget = glm::max(levelOfDetail.triangleBudget, 0);
+		unsigned int shadowTriangles = 0;
+		for (int i = LOD_VIEW_SHADOW; i < LOD_VIEW_COUNT; i++) {
+			shadowTriangles += i < LOD_VIEW_SHADOW + shadowSettings.activeCascades ? levelOfDetail.selectors[i].getTriangleCount() : 0;
+			levelOfDetail.selectors[i].pixelError = cameraLods.pixelError;
+			levelOfDetail.selectors[i].hysteresis = cameraLods.hysteresis;
+		}
+		ImGui::Text("Model Triangles: %u (shadow %u)", cameraLods.getTriangleCount(), shadowTriangles);
+	}
+
+	if (ImGui::CollapsingHeader("Multi-Draw Indirect")) {
+		ImGui::Checkbox("Enabled", &multiDraw.enabled);
+		if (multiDraw.enabled) {
+			ImGui::Text("Camera: %u draws in one call, %u culled", multiDraw.drawCount[LOD_VIEW_CAMERA], multiDraw.culledCount[LOD_VIEW_CAMERA]);
+			for (int i = 0; i < shadowSettings.activeCascades; i++) {
+				ImGui::Text("Cascade %d: %u draws in one call, %u culled", i, multiDraw.drawCount[LOD_VIEW_SHADOW + i], multiDraw.culledCount[LOD_VIEW_SHADOW + i]);
+			}
+			ImGui::Text("Stream: %zu bytes this frame, %u stalls, %u overflows", multiDraw.streamBytes, multiDraw.streamStalls, multiDraw.streamOverflows);
+		}
+		else {
+			ImGui::Text("One draw per node, see Meshlet Culling");
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Meshlet Culling")) {
+		ImGui::Checkbox("Frustum", &meshletCulling.frustum);
+		ImGui::Checkbox("Back-facing Cones", &meshletCulling.backface);
+		for (int i = 0; i < LOD_VIEW_COUNT; i++) {
+			ew::MeshletCuller& culler = meshletCulling.cullers[i];
+			culler.frustumCulling = meshletCulling.frustum;
+			culler.coneCulling = meshletCulling.backface;
+			if (i >= LOD_VIEW_SHADOW + shadowSettings.activeCascades) {
+				continue;
+			}
+			std::string viewName = i == LOD_VIEW_CAMERA ? "Camera" : "Cascade " + std::to_string(i - LOD_VIEW_SHADOW);
+			ImGui::Text("%s: %u of %u culled (frustum %u, back-facing %u)", viewName.c_str(),
+				culler.getCulledCount(), culler.getMeshletCount(), culler.getFrustumCulledCount(), culler.getBackfaceCulledCount());
+		}
+	}
+
 	if (ImGui::Button("Toggle Edge Detect")) {
 		edge.enabled = !edge.enabled;
 	}
 
+	if (ImGui::CollapsingHeader("Lighting")) {
+		ImGui::SliderInt("Point Lights", &pointLightSettings.count, 0, 4096);
+		ImGui::Checkbox("Tiled Light Culling", &tiledLighting.enabled);
+
+		// Power of two limits from 64 to 512
+		int maxLightsIndex = 0;
+		while ((64 << maxLightsIndex) < tiledLighting.maxLightsPerTile)
+			maxLightsIndex++;
+		if (ImGui::Combo("Max Lights Per Tile", &maxLightsIndex, "64\0" "128\0" "256\0" "512\0")) {
+			tiledLighting.maxLightsPerTile = 64 << maxLightsIndex;
+		}
+		ImGui::Text("Lighting pass: %.3f ms", tiledLighting.gpuTimeMs);
+
+		int layoutIndex = (int)gBufferSettings.layout;
+		if (ImGui::Combo("G-Buffer Layout", &layoutIndex, "Full (position, normal, albedo)\0" "Compact (depth, octahedral normal)\0")) {
+			gBufferSettings.layout = (tslib::GBufferLayout)layoutIndex;
+		}
+		ImGui::Text("G-Buffer: %u bytes/pixel, %.1f MB", gBufferSettings.bytesPerPixel, gBufferSettings.bytesPerPixel * gb.width * gb.height / (1024.0f * 1024.0f));
+		ImGui::Text("Render targets: %.1f MB (peak %.1f MB), %u created", renderTargetStats.allocatedBytes / (1024.0f * 1024.0f),
+			renderTargetStats.peakBytes / (1024.0f * 1024.0f), renderTargetStats.createdCount);
+	}
+
+	if (ImGui::CollapsingHeader("Frame Graph")) {
+		for (const tslib::FrameGraph::PassTiming& timing : frameGraphStats.timings) {
+			if (timing.culled) {
+				ImGui::TextDisabled("%s: culled", timing.name.c_str());
+			}
+			else {
+				ImGui::Text("%s: GPU %.3f ms, CPU %.3f ms", timing.name.c_str(), timing.gpuMs, timing.cpuMs);
+			}
+		}
+		ImGui::Text("Memory barriers: %u", frameGraphStats.barrierCount);
+		if (ImGui::Button("Print Pass Timings")) {
+			frameGraphStats.printTimings = true;
+		}
+	}
+
 	ImGui::End();
 
 	ImGui::Begin("Shadow Map"); {
 		ImGui::BeginChild("Shadow Map");
 
+		// Cascades side by side, nearest first
 		ImVec2 windowSize = ImGui::GetWindowSize();
-
-		ImGui::Image((ImTextureID)sb.shadowMap, windowSize, ImVec2(0, 1), ImVec2(1, 0));
+		float cascadeSize = glm::min(windowSize.x / shadowSettings.activeCascades, windowSize.y);
+		for (int i = 0; i < shadowSettings.activeCascades; i++) {
+			if (i > 0) {
+				ImGui::SameLine(0.0f, 0.0f);
+			}
+			ImGui::Image((ImTextureID)shadowSettings.cascadeViews[i], ImVec2(cascadeSize, cascadeSize), ImVec2(0, 1), ImVec2(1, 0));
+		}
 		ImGui::EndChild();
 		ImGui::End();
 	}
 
 	ImGui::Begin("GBuffers"); {
-		ImVec2 texSize = ImVec2(gb.width / 4, gb.height / 4);
-		for (size_t i = 0; i < 3; i++)
-		{
-			ImGui::Image((ImTextureID)gb.colorBuffers[i], texSize, ImVec2(0, 1), ImVec2(1, 0));
+		ImGui::Checkbox("Show", &gBufferDebug.enabled);
+		ImGui::Combo("Channel", &gBufferDebug.channel, "Albedo\0" "Normal\0" "Position\0");
+		if (gBufferDebug.texture != 0) {
+			ImGui::Image((ImTextureID)gBufferDebug.texture, ImVec2(gb.width / 4, gb.height / 4), ImVec2(0, 1), ImVec2(1, 0));
 		}
 		ImGui::End();
 	}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/procGen.h>
+#include <ew/model.h>
+#include <ew/assetStreamer.h>
+
+#include "benchmarks.h"
+
+/// <summary>
+/// Writes a mesh as a Wavefront OBJ so the benchmark has models to stream without shipping them
+/// </summary>
+static bool writeObj(const std::string& path, const ew::MeshData& meshData) {
+	FILE* out = fopen(path.c_str(), "w");
+	if (out == nullptr) {
+		return false;
+	}
+	for (const ew::Vertex& v : meshData.vertices) {
+		fprintf(out, "v %f %f %f\nvn %f %f %f\nvt %f %f\n", v.pos.x, v.pos.y, v.pos.z, v.normal.x, v.normal.y, v.normal.z, v.uv.x, v.uv.y);
+	}
+	for (size_t i = 0; i + 2 < meshData.indices.size(); i += 3) {
+		unsigned int a = meshData.indices[i] + 1, b = meshData.indices[i + 1] + 1, c = meshData.indices[i + 2] + 1;
+		fprintf(out, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+	}
+	fclose(out);
+	return true;
+}
+
+/// <summary>
+/// Time until the first frame can be drawn when a scene's models load before the render loop, against requesting
+/// them from an AssetStreamer and drawing placeholders while they arrive under a per frame upload budget.
+/// </summary>
+void runAssetStreamingBenchmark() {
+	const int modelCount = 16;
+	const int numLods = 2;
+	ew::MeshData sphere = ew::createSphere(1.0f, 96);
+	printf("\nAsset streaming (%d models, %zu triangles each)\n", modelCount, sphere.indices.size() / 3);
+	std::vector<std::string> paths;
+	for (int i = 0; i < modelCount; i++) {
+		paths.push_back("assets/streamBench" + std::to_string(i) + ".obj");
+		if (!writeObj(paths.back(), sphere)) {
+			printf("  Failed to write %s\n", paths.back().c_str());
+			return;
+		}
+	}
+
+	{
+		BenchTimer timer;
+		std::vector<ew::Model> models;
+		for (const std::string& path : paths) {
+			models.push_back(ew::Model(path, ew::VertexFormat::FLOAT, numLods));
+		}
+		glFinish();
+		printf("  %-24s first frame %9.1f ms\n", "synchronous", timer.elapsedMs());
+	}
+	{
+		const double budgetMs = 2.0;
+		ew::WorkerPool pool;
+		BenchTimer timer;
+		ew::AssetStreamer streamer(pool);
+		for (int i = 0; i < modelCount; i++) {
+			streamer.requestModel(paths[i], glm::vec3(i * 3.0f, 0, 0), ew::VertexFormat::FLOAT, numLods);
+		}
+		streamer.update(glm::vec3(0), budgetMs);
+		double firstFrameMs = timer.elapsedMs();
+		int frames = 1;
+		double worstUpdateMs = streamer.getLastUpdateMs();
+		while (streamer.getPendingCount() > 0) {
+			streamer.update(glm::vec3(0), budgetMs);
+			worstUpdateMs = std::max(worstUpdateMs, streamer.getLastUpdateMs());
+			frames++;
+			//Stands in for the rest of a frame so the workers get time
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		glFinish();
+		printf("  %-24s first frame %9.1f ms, all loaded %9.1f ms over %d frames, worst update %.2f ms\n", "streamed, 2 ms budget", firstFrameMs, timer.elapsedMs(), frames, worstUpdateMs);
+	}
+	for (const std::string& path : paths) {
+		remove(path.c_str());
+	}
+}
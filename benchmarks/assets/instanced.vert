@@ -0,0 +1,27 @@
+#version 450
+
+// INSTANCED 1 reads the model and normal matrices from the per instance attributes of ew::Mesh::drawInstanced
+#ifndef INSTANCED
+#define INSTANCED 0
+#endif
+
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+#if INSTANCED
+layout(location = 5) in mat4 _Model;
+layout(location = 9) in mat3 _NormalMatrix;
+#else
+uniform mat4 _Model;
+#endif
+
+uniform mat4 _ViewProjection;
+
+out vec3 WorldNormal;
+
+void main(){
+#if !INSTANCED
+	mat3 _NormalMatrix = transpose(inverse(mat3(_Model)));
+#endif
+	WorldNormal = _NormalMatrix * vNormal;
+	gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
+}
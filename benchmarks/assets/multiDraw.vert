@@ -0,0 +1,33 @@
+#version 450
+
+// MULTI_DRAW 1 reads the model matrix written by ew::DrawList instead of the _Model uniform
+#ifndef MULTI_DRAW
+#define MULTI_DRAW 0
+#endif
+
+#if MULTI_DRAW
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+
+layout(location = 0) in vec3 vPos;
+
+uniform mat4 _ViewProjection;
+#if MULTI_DRAW
+struct DrawData {
+	mat4 model;
+	vec4 positionScale;
+	vec4 positionOffset;
+};
+layout(std430, binding = 2) readonly buffer DrawDataBuffer {
+	DrawData _Draws[];
+};
+#else
+uniform mat4 _Model;
+#endif
+
+void main(){
+#if MULTI_DRAW
+	mat4 _Model = _Draws[gl_DrawIDARB].model;
+#endif
+	gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 450
+out vec4 FragColor;
+
+// Same shape as the old uniform array point lights
+struct PointLight{
+	vec3 position;
+	float radius;
+	vec4 color;
+};
+#define MAX_POINT_LIGHTS 64
+uniform PointLight _PointLights[MAX_POINT_LIGHTS];
+
+void main(){
+	vec4 color = vec4(0);
+	for (int i = 0; i < MAX_POINT_LIGHTS; i++) {
+		color += _PointLights[i].color * _PointLights[i].radius + vec4(_PointLights[i].position, 0);
+	}
+	FragColor = color;
+}
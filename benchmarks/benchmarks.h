@@ -0,0 +1,29 @@
+#pragma once
+#include <chrono>
+
+struct GLFWwindow;
+
+// Wall clock timer for CPU side measurements
+struct BenchTimer {
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	double elapsedMs() const {
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+};
+
+void runUniformBenchmark();
+void runShaderCacheBenchmark();
+void runShaderBatchBenchmark(GLFWwindow* window);
+void runMeshOptimizerBenchmark();
+void runLodBenchmark();
+void runMeshletBenchmark();
+void runMultiDrawBenchmark();
+void runInstancingBenchmark();
+void runDynamicMeshBenchmark();
+void runModelLoadBenchmark();
+void runModelImportBenchmark();
+void runAssetStreamingBenchmark();
+void runTextureRegistryBenchmark();
+void runTextureUploadBenchmark();
+void runTextureCompressionBenchmark();
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <math.h>
+
+#include <ew/external/glad.h>
+#include <ew/procGen.h>
+
+#include "benchmarks.h"
+
+static const int SUBDIVISIONS = 512;
+static const int FRAMES = 20;
+
+static void deform(ew::MeshData& meshData, const ew::MeshData& flat, float time) {
+	for (size_t i = 0; i < flat.vertices.size(); i++) {
+		const glm::vec3& p = flat.vertices[i].pos;
+		meshData.vertices[i].pos.y = 0.25f * sinf(p.x * 2.0f + time) * cosf(p.z * 1.5f + time);
+	}
+}
+
+/// <summary>
+/// A deforming plane re-uploaded every frame: reloading a static mesh, reloading a dynamic mesh into its existing
+/// storage, and updating only the vertices. The mesh is drawn after each upload so the driver has to honor in-flight reads.
+/// </summary>
+void runDynamicMeshBenchmark() {
+	ew::MeshData flat = ew::createPlane(10.0f, 10.0f, SUBDIVISIONS);
+	ew::MeshData meshData = flat;
+	printf("\nDynamic mesh updates (%zu vertices)\n", flat.vertices.size());
+
+	const char* names[3] = { "static load", "dynamic load", "dynamic updateVertices" };
+	for (int mode = 0; mode < 3; mode++) {
+		ew::Mesh mesh = ew::Mesh(flat, ew::VertexFormat::PACKED_QUANTIZED, mode == 0 ? ew::MeshUsage::STATIC : ew::MeshUsage::DYNAMIC);
+		double uploadMs = 0.0;
+		glFinish();
+		BenchTimer total;
+		for (int frame = 0; frame < FRAMES; frame++) {
+			deform(meshData, flat, frame * 0.1f);
+			BenchTimer timer;
+			if (mode == 2) {
+				mesh.updateVertices(meshData.vertices);
+			}
+			else {
+				mesh.load(meshData, ew::VertexFormat::PACKED_QUANTIZED, mode == 0 ? ew::MeshUsage::STATIC : ew::MeshUsage::DYNAMIC);
+			}
+			uploadMs += timer.elapsedMs();
+			mesh.draw(ew::DrawMode::POINTS);
+		}
+		glFinish();
+		printf("  %-24s upload %7.3f ms  frame %7.3f ms  %u reallocations\n", names[mode], uploadMs / FRAMES, total.elapsedMs() / FRAMES, mesh.getGrowCount());
+	}
+}
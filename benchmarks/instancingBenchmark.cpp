@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/shader.h>
+#include <ew/procGen.h>
+#include <ew/camera.h>
+#include <ew/transform.h>
+
+#include "benchmarks.h"
+
+static const int NUM_INSTANCES = 4096;
+static const int FRAMES = 20;
+
+/// <summary>
+/// One mesh drawn many times: a _Model uniform and glDrawElements per instance with the normal matrix inverted per
+/// vertex, against one glDrawElementsInstanced with model and normal matrices streamed from the CPU.
+/// </summary>
+void runInstancingBenchmark() {
+	printf("\nInstanced drawing (%d instances)\n", NUM_INSTANCES);
+	ew::Mesh mesh = ew::Mesh(ew::createSphere(0.4f, 16));
+
+	ew::Camera camera;
+	camera.position = glm::vec3(0.0f);
+	camera.target = glm::vec3(0.0f, 0.0f, -1.0f);
+	camera.farPlane = 200.0f;
+	glm::mat4 viewProjection = camera.projectionMatrix() * camera.viewMatrix();
+
+	std::vector<glm::mat4> transforms;
+	for (int i = 0; i < NUM_INSTANCES; i++) {
+		glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3((i % 64) - 32.0f, ((i / 64) % 64) - 32.0f, -80.0f));
+		transforms.push_back(glm::rotate(m, i * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f)));
+	}
+
+	{
+		ew::Shader shader = ew::Shader("assets/instanced.vert", "assets/solid.frag");
+		shader.use();
+		shader.setMat4("_ViewProjection", viewProjection);
+		constexpr unsigned int MODEL_UNIFORM = ew::uniformHash("_Model");
+		ew::UniformLocation modelUniform = shader.getUniformLocation(MODEL_UNIFORM);
+
+		double submitMs = 0.0;
+		double totalMs = 0.0;
+		for (int frame = 0; frame < FRAMES; frame++) {
+			glFinish();
+			BenchTimer timer;
+			for (int i = 0; i < NUM_INSTANCES; i++) {
+				shader.setMat4(modelUniform, transforms[i]);
+				mesh.draw();
+			}
+			submitMs += timer.elapsedMs();
+			glFinish();
+			totalMs += timer.elapsedMs();
+		}
+		printf("  %-28s submit %7.3f ms  total %7.3f ms\n", "glDrawElements per instance", submitMs / FRAMES, totalMs / FRAMES);
+	}
+	{
+		ew::Shader shader = ew::Shader("assets/instanced.vert", "assets/solid.frag", { { "INSTANCED", "1" } });
+		shader.use();
+		shader.setMat4("_ViewProjection", viewProjection);
+
+		double submitMs = 0.0;
+		double totalMs = 0.0;
+		for (int frame = 0; frame < FRAMES; frame++) {
+			glFinish();
+			BenchTimer timer;
+			mesh.drawInstanced(transforms);
+			submitMs += timer.elapsedMs();
+			glFinish();
+			totalMs += timer.elapsedMs();
+		}
+		printf("  %-28s submit %7.3f ms  total %7.3f ms\n", "glDrawElementsInstanced", submitMs / FRAMES, totalMs / FRAMES);
+	}
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+
+#include <ew/external/glad.h>
+#include <ew/shader.h>
+#include <ew/procGen.h>
+#include <ew/meshOptimizer.h>
+#include <ew/meshSimplifier.h>
+#include <ew/lodSelector.h>
+
+#include "benchmarks.h"
+
+static const int GRID_SIZE = 8;
+static const float GRID_SPACING = 5.0f;
+static const int FRAMES = 20;
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+
+static void generateAndReport(const char* name, ew::MeshData meshData, int numLods) {
+	ew::optimizeMesh(meshData);
+	BenchTimer timer;
+	ew::generateLods(meshData, numLods);
+	double ms = timer.elapsedMs();
+	printf("  %s: %zu levels in %.2f ms\n", name, meshData.lods.size(), ms);
+	for (size_t i = 0; i < meshData.lods.size(); i++) {
+		printf("    lod %zu %8u triangles  error %.5f\n", i, meshData.lods[i].indexCount / 3, meshData.lods[i].error);
+	}
+}
+
+/// <summary>
+/// Draws a grid of meshes seen across the diagonal, the same layout as the monkeys in assignment3
+/// </summary>
+/// <returns>Time until the draws finish in milliseconds, averaged over FRAMES</returns>
+static double drawGrid(const ew::Shader& shader, const ew::Mesh& mesh, const ew::Camera& camera, ew::LodSelector* selector, int* lodStates) {
+	double totalMs = 0.0;
+	for (int frame = 0; frame < FRAMES; frame++) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glFinish();
+		BenchTimer timer;
+		if (selector != nullptr) {
+			selector->begin(camera, (float)HEIGHT);
+		}
+		for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((i % GRID_SIZE) * GRID_SPACING, 0.0f, (i / GRID_SIZE) * GRID_SPACING));
+			shader.setMat4("_Model", model);
+			int lod = selector != nullptr ? selector->select(mesh, model, &lodStates[i]) : 0;
+			mesh.draw(ew::DrawMode::TRIANGLES, lod);
+		}
+		if (selector != nullptr) {
+			selector->end();
+		}
+		glFinish();
+		totalMs += timer.elapsedMs();
+	}
+	return totalMs / FRAMES;
+}
+
+/// <summary>
+/// LOD chain build time, then triangles and frame time for a grid of instances at several screen space error limits
+/// </summary>
+void runLodBenchmark() {
+	printf("\nLevel of detail\n");
+	generateAndReport("sphere", ew::createSphere(1.0f, 256), 6);
+	generateAndReport("plane", ew::createPlane(10.0f, 10.0f, 256), 6);
+
+	ew::MeshData meshData = ew::createSphere(1.0f, 128);
+	ew::optimizeMesh(meshData);
+	ew::generateLods(meshData, 6);
+	ew::Mesh mesh = ew::Mesh(meshData);
+
+	ew::Shader shader = ew::Shader("assets/uniformBench.vert", "assets/uniformBench.frag");
+	shader.use();
+	ew::Camera camera;
+	camera.position = glm::vec3(-2.0f, 2.0f, -2.0f);
+	camera.target = glm::vec3(GRID_SIZE * GRID_SPACING * 0.5f, 0.0f, GRID_SIZE * GRID_SPACING * 0.5f);
+	camera.aspectRatio = (float)WIDTH / HEIGHT;
+	shader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+
+	//The benchmark window is tiny, render at the resolution the errors are measured for
+	unsigned int fbo, renderbuffers[2];
+	glCreateFramebuffers(1, &fbo);
+	glCreateRenderbuffers(2, renderbuffers);
+	glNamedRenderbufferStorage(renderbuffers[0], GL_RGBA8, WIDTH, HEIGHT);
+	glNamedRenderbufferStorage(renderbuffers[1], GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+	glNamedFramebufferRenderbuffer(fbo, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	glNamedFramebufferRenderbuffer(fbo, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+
+	printf("  %d spheres at %dx%d\n", GRID_SIZE * GRID_SIZE, WIDTH, HEIGHT);
+	double fullMs = drawGrid(shader, mesh, camera, nullptr, nullptr);
+	printf("    %-24s %8u triangles  %.3f ms\n", "full detail", (unsigned int)(mesh.getLodTriangleCount(0) * GRID_SIZE * GRID_SIZE), fullMs);
+
+	const float pixelErrors[] = { 0.5f, 1.0f, 2.0f, 4.0f };
+	for (float pixelError : pixelErrors) {
+		ew::LodSelector selector;
+		selector.pixelError = pixelError;
+		int lodStates[GRID_SIZE * GRID_SIZE];
+		for (int& state : lodStates) {
+			state = -1;
+		}
+		double ms = drawGrid(shader, mesh, camera, &selector, lodStates);
+		char label[64];
+		snprintf(label, sizeof(label), "%.1f px error", pixelError);
+		printf("    %-24s %8u triangles  %.3f ms\n", label, selector.getTriangleCount(), ms);
+	}
+	glDisable(GL_DEPTH_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteRenderbuffers(2, renderbuffers);
+}
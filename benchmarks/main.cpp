@@ -0,0 +1,61 @@
+#include <stdio.h>
+
+#include <ew/external/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "benchmarks.h"
+
+GLFWwindow* initHiddenWindow(const char* title, int width, int height);
+
+int main() {
+	GLFWwindow* window = initHiddenWindow("Benchmarks", 64, 64);
+	if (window == nullptr) {
+		return 1;
+	}
+	printf("Renderer: %s\n", glGetString(GL_RENDERER));
+	printf("Version: %s\n\n", glGetString(GL_VERSION));
+
+	runUniformBenchmark();
+	runShaderCacheBenchmark();
+	runShaderBatchBenchmark(window);
+	runMeshOptimizerBenchmark();
+	runLodBenchmark();
+	runMeshletBenchmark();
+	runMultiDrawBenchmark();
+	runInstancingBenchmark();
+	runDynamicMeshBenchmark();
+	runModelLoadBenchmark();
+	runModelImportBenchmark();
+	runAssetStreamingBenchmark();
+	runTextureRegistryBenchmark();
+	runTextureUploadBenchmark();
+	runTextureCompressionBenchmark();
+
+	glfwTerminate();
+	return 0;
+}
+
+/// <summary>
+/// Initializes GLFW and GLAD with an invisible window so benchmarks have a GL context
+/// </summary>
+/// <returns>Returns window handle on success or null on fail</returns>
+GLFWwindow* initHiddenWindow(const char* title, int width, int height) {
+	if (!glfwInit()) {
+		printf("GLFW failed to init!");
+		return nullptr;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(width, height, title, NULL, NULL);
+	if (window == NULL) {
+		printf("GLFW failed to create window");
+		return nullptr;
+	}
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGL(glfwGetProcAddress)) {
+		printf("GLAD Failed to load GL headers");
+		return nullptr;
+	}
+	return window;
+}
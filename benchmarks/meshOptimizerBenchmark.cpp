@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <algorithm>
+#include <random>
+
+#include <ew/procGen.h>
+#include <ew/meshOptimizer.h>
+#include <ew/model.h>
+
+#include "benchmarks.h"
+
+//Imported models from assignment5's asset folder, copied next to the benchmark for the startup benchmark
+static const char* IMPORTED_MODELS[] = {
+	"assets/startup/Suzanne.obj",
+	"assets/startup/Suzanne.fbx",
+};
+
+/// <summary>
+/// Mimics an importer without vertex joining: triangles in random order, each with its own three vertices
+/// </summary>
+static ew::MeshData unweld(const ew::MeshData& meshData) {
+	std::vector<unsigned int> triangles(meshData.indices.size() / 3);
+	for (size_t i = 0; i < triangles.size(); i++) {
+		triangles[i] = (unsigned int)i;
+	}
+	std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+
+	ew::MeshData result;
+	for (unsigned int t : triangles) {
+		for (int i = 0; i < 3; i++) {
+			result.indices.push_back((unsigned int)result.vertices.size());
+			result.vertices.push_back(meshData.vertices[meshData.indices[t * 3 + i]]);
+		}
+	}
+	return result;
+}
+
+static void report(const char* label, const ew::MeshData& meshData) {
+	ew::VertexCacheStats stats = ew::analyzeVertexCache(meshData);
+	printf("    %-24s %8zu verts  ACMR %.3f  ATVR %.3f\n", label, meshData.vertices.size(), stats.acmr, stats.atvr);
+}
+
+static void optimizeAndReport(const char* name, const ew::MeshData& source) {
+	printf("  %s (%zu triangles)\n", name, source.indices.size() / 3);
+	ew::MeshData meshData = source;
+	report("input", meshData);
+
+	BenchTimer timer;
+	ew::weldVertices(meshData);
+	double weldMs = timer.elapsedMs();
+	report("weld", meshData);
+
+	timer = BenchTimer();
+	ew::optimizeVertexCache(meshData);
+	double cacheMs = timer.elapsedMs();
+	report("vertex cache", meshData);
+
+	timer = BenchTimer();
+	ew::optimizeOverdraw(meshData);
+	double overdrawMs = timer.elapsedMs();
+	report("overdraw", meshData);
+
+	timer = BenchTimer();
+	ew::optimizeVertexFetch(meshData);
+	double fetchMs = timer.elapsedMs();
+	report("vertex fetch", meshData);
+	printf("    time: weld %.2f ms, cache %.2f ms, overdraw %.2f ms, fetch %.2f ms\n", weldMs, cacheMs, overdrawMs, fetchMs);
+}
+
+/// <summary>
+/// Post-transform cache statistics (16 entry FIFO) after each mesh optimizer pass, for procedural meshes and
+/// for models as the importer hands them over
+/// </summary>
+void runMeshOptimizerBenchmark() {
+	printf("\nMesh optimizer\n");
+	optimizeAndReport("sphere, procGen order", ew::createSphere(1.0f, 256));
+	optimizeAndReport("sphere, unwelded + shuffled", unweld(ew::createSphere(1.0f, 256)));
+	optimizeAndReport("plane, procGen order", ew::createPlane(10.0f, 10.0f, 256));
+	optimizeAndReport("cylinder, unwelded + shuffled", unweld(ew::createCylinder(1.0f, 2.0f, 512)));
+	for (const char* path : IMPORTED_MODELS) {
+		std::vector<ew::MeshData> meshes = ew::importModelMeshData(path);
+		for (const ew::MeshData& meshData : meshes) {
+			optimizeAndReport(path, meshData);
+		}
+	}
+}
@@ -0,0 +1,102 @@
+#include <stdio.h>
+
+#include <ew/external/glad.h>
+#include <ew/shader.h>
+#include <ew/procGen.h>
+#include <ew/meshOptimizer.h>
+#include <ew/meshlets.h>
+#include <ew/meshletCuller.h>
+
+#include "benchmarks.h"
+
+static const int GRID_SIZE = 8;
+static const float GRID_SPACING = 5.0f;
+static const int FRAMES = 10;
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+
+/// <summary>
+/// Draws a grid of meshes from inside the grid, so some are behind the camera, either whole or through the culler
+/// </summary>
+/// <returns>Time until the draws finish in milliseconds, averaged over FRAMES</returns>
+static double drawGrid(const ew::Shader& shader, const ew::Mesh& mesh, const ew::Camera& camera, ew::MeshletCuller* culler, double* cullMs) {
+	double totalMs = 0.0;
+	*cullMs = 0.0;
+	for (int frame = 0; frame < FRAMES; frame++) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glFinish();
+		BenchTimer timer;
+		if (culler != nullptr) {
+			culler->begin(camera);
+		}
+		for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((i % GRID_SIZE) * GRID_SPACING, 0.0f, (i / GRID_SIZE) * GRID_SPACING));
+			shader.setMat4("_Model", model);
+			if (culler != nullptr) {
+				culler->draw(mesh, model);
+			}
+			else {
+				mesh.draw();
+			}
+		}
+		*cullMs += timer.elapsedMs();
+		glFinish();
+		totalMs += timer.elapsedMs();
+	}
+	*cullMs /= FRAMES;
+	return totalMs / FRAMES;
+}
+
+/// <summary>
+/// Meshlet build time, then clusters culled and frame time with frustum and cone culling against drawing every mesh whole
+/// </summary>
+void runMeshletBenchmark() {
+	printf("\nMeshlet culling\n");
+	ew::MeshData meshData = ew::createSphere(1.0f, 128);
+	ew::optimizeMesh(meshData);
+	BenchTimer buildTimer;
+	ew::buildMeshlets(meshData);
+	printf("  sphere: %zu meshlets from %zu triangles in %.2f ms\n", meshData.meshlets.size(), meshData.indices.size() / 3, buildTimer.elapsedMs());
+	ew::Mesh mesh = ew::Mesh(meshData);
+
+	//Cheap fragments so the difference is in vertex work
+	ew::Shader shader = ew::Shader("assets/uniformBench.vert", "assets/solid.frag");
+	shader.use();
+	ew::Camera camera;
+	camera.position = glm::vec3(GRID_SIZE * GRID_SPACING * 0.5f, 1.0f, GRID_SIZE * GRID_SPACING * 0.5f);
+	camera.target = camera.position + glm::vec3(1.0f, -0.2f, 0.3f);
+	camera.aspectRatio = (float)WIDTH / HEIGHT;
+	shader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+
+	unsigned int fbo, renderbuffers[2];
+	glCreateFramebuffers(1, &fbo);
+	glCreateRenderbuffers(2, renderbuffers);
+	glNamedRenderbufferStorage(renderbuffers[0], GL_RGBA8, WIDTH, HEIGHT);
+	glNamedRenderbufferStorage(renderbuffers[1], GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+	glNamedFramebufferRenderbuffer(fbo, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	glNamedFramebufferRenderbuffer(fbo, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+
+	double cullMs = 0.0;
+	double ms = drawGrid(shader, mesh, camera, nullptr, &cullMs);
+	printf("  %d spheres at %dx%d\n", GRID_SIZE * GRID_SIZE, WIDTH, HEIGHT);
+	printf("    %-24s %6.2f ms/frame\n", "no culling", ms);
+
+	const char* labels[] = { "frustum", "back-facing cones", "frustum + cones" };
+	for (int mode = 0; mode < 3; mode++) {
+		ew::MeshletCuller culler;
+		culler.frustumCulling = mode != 1;
+		culler.coneCulling = mode != 0;
+		ms = drawGrid(shader, mesh, camera, &culler, &cullMs);
+		printf("    %-24s %6.2f ms/frame  %u of %u meshlets culled  (submit %.3f ms)\n", labels[mode], ms, culler.getCulledCount(), culler.getMeshletCount(), cullMs);
+	}
+
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_DEPTH_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteRenderbuffers(2, renderbuffers);
+}
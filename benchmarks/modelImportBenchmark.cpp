@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/procGen.h>
+#include <ew/model.h>
+#include <ew/workerPool.h>
+#include <ew/uploadQueue.h>
+
+#include "benchmarks.h"
+
+static const char* SCENE_PATH = "assets/modelImportBench.obj";
+
+/// <summary>
+/// Writes objectCount copies of a mesh as separate OBJ objects, so the import produces one mesh per copy
+/// </summary>
+static bool writeObjScene(const char* path, const ew::MeshData& meshData, int objectCount) {
+	FILE* out = fopen(path, "w");
+	if (out == nullptr) {
+		return false;
+	}
+	for (int o = 0; o < objectCount; o++) {
+		fprintf(out, "o object%d\n", o);
+		for (const ew::Vertex& v : meshData.vertices) {
+			fprintf(out, "v %f %f %f\nvn %f %f %f\nvt %f %f\n", v.pos.x + o * 3.0f, v.pos.y, v.pos.z, v.normal.x, v.normal.y, v.normal.z, v.uv.x, v.uv.y);
+		}
+		//OBJ indices are global across objects
+		unsigned int base = (unsigned int)(o * meshData.vertices.size()) + 1;
+		for (size_t i = 0; i + 2 < meshData.indices.size(); i += 3) {
+			unsigned int a = meshData.indices[i] + base, b = meshData.indices[i + 1] + base, c = meshData.indices[i + 2] + base;
+			fprintf(out, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+		}
+	}
+	fclose(out);
+	return true;
+}
+
+/// <summary>
+/// Import time of a many mesh model against worker count, then an async load drained under per frame budgets
+/// to show how long the render loop is blocked each frame and how many frames the load spreads over.
+/// </summary>
+void runModelImportBenchmark() {
+	const int objectCount = 64;
+	const int numLods = 4;
+	ew::MeshData sphere = ew::createSphere(1.0f, 64);
+	printf("\nParallel model import (%d meshes, %zu triangles each)\n", objectCount, sphere.indices.size() / 3);
+	if (!writeObjScene(SCENE_PATH, sphere, objectCount)) {
+		printf("  Failed to write %s\n", SCENE_PATH);
+		return;
+	}
+
+	//parallelFor also runs on the calling thread, so n workers process on n + 1 threads
+	int maxWorkers = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+	std::vector<int> workerCounts;
+	for (int workers = 1; workers < maxWorkers; workers *= 2) {
+		workerCounts.push_back(workers);
+	}
+	workerCounts.push_back(maxWorkers);
+	double firstMs = 0.0;
+	for (int workers : workerCounts) {
+		ew::WorkerPool pool(workers);
+		BenchTimer timer;
+		std::vector<ew::MeshData> meshes = ew::loadModelMeshData(SCENE_PATH, numLods, &pool);
+		double ms = timer.elapsedMs();
+		if (firstMs == 0.0) {
+			firstMs = ms;
+		}
+		printf("  %2d workers %9.1f ms  %5.2fx\n", workers, ms, firstMs / ms);
+	}
+
+	ew::WorkerPool pool;
+	const double budgets[] = { 1.0, 4.0, 1e9 };
+	for (double budgetMs : budgets) {
+		ew::UploadQueue uploads;
+		ew::Model model;
+		BenchTimer timer;
+		model.loadAsync(SCENE_PATH, pool, uploads, ew::VertexFormat::PACKED_QUANTIZED, numLods);
+		int frames = 0;
+		double worstDrainMs = 0.0;
+		while (!model.isLoaded()) {
+			if (uploads.drain(budgetMs) > 0) {
+				frames++;
+				worstDrainMs = std::max(worstDrainMs, uploads.getLastDrainMs());
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		glFinish();
+		char label[32];
+		snprintf(label, sizeof(label), budgetMs > 1000.0 ? "async, no budget" : "async, %.0f ms budget", budgetMs);
+		printf("  %-22s %9.1f ms total, %3d upload frames, worst %.2f ms\n", label, timer.elapsedMs(), frames, worstDrainMs);
+	}
+	remove(SCENE_PATH);
+}
@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <string>
+
+#include <ew/external/glad.h>
+#include <ew/procGen.h>
+#include <ew/model.h>
+#include <ew/cookedModel.h>
+
+#include "benchmarks.h"
+
+static const char* SOURCE_PATH = "assets/modelLoadBench.obj";
+static const char* COOKED_PATH = "assets/modelLoadBench.obj.ewmesh";
+
+/// <summary>
+/// Writes a mesh as a Wavefront OBJ so the benchmark has a large import without shipping one
+/// </summary>
+static bool writeObj(const char* path, const ew::MeshData& meshData) {
+	FILE* out = fopen(path, "w");
+	if (out == nullptr) {
+		return false;
+	}
+	for (const ew::Vertex& v : meshData.vertices) {
+		fprintf(out, "v %f %f %f\nvn %f %f %f\nvt %f %f\n", v.pos.x, v.pos.y, v.pos.z, v.normal.x, v.normal.y, v.normal.z, v.uv.x, v.uv.y);
+	}
+	for (size_t i = 0; i + 2 < meshData.indices.size(); i += 3) {
+		unsigned int a = meshData.indices[i] + 1, b = meshData.indices[i + 1] + 1, c = meshData.indices[i + 2] + 1;
+		fprintf(out, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+	}
+	fclose(out);
+	return true;
+}
+
+/// <summary>
+/// Startup cost of a large model: Assimp import with the load time processing every launch, the one time cook,
+/// and mapping the cooked file. Each load ends with glFinish so uploads are included.
+/// </summary>
+void runModelLoadBenchmark() {
+	ew::MeshData sphere = ew::createSphere(1.0f, 384);
+	printf("\nModel startup (%zu vertices, %zu triangles)\n", sphere.vertices.size(), sphere.indices.size() / 3);
+	if (!writeObj(SOURCE_PATH, sphere)) {
+		printf("  Failed to write %s\n", SOURCE_PATH);
+		return;
+	}
+	const int numLods = 4;
+	{
+		BenchTimer timer;
+		ew::Model model = ew::Model(SOURCE_PATH, ew::VertexFormat::PACKED_QUANTIZED, numLods);
+		glFinish();
+		printf("  %-24s %9.1f ms\n", "Assimp import", timer.elapsedMs());
+	}
+	{
+		BenchTimer timer;
+		ew::cookModel(SOURCE_PATH, COOKED_PATH, ew::VertexFormat::PACKED_QUANTIZED, numLods);
+		printf("  %-24s %9.1f ms (once, offline)\n", "cook", timer.elapsedMs());
+	}
+	{
+		BenchTimer timer;
+		ew::Model model = ew::Model(COOKED_PATH);
+		glFinish();
+		printf("  %-24s %9.1f ms\n", "mapped .ewmesh", timer.elapsedMs());
+	}
+	remove(SOURCE_PATH);
+	remove(COOKED_PATH);
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/shader.h>
+#include <ew/procGen.h>
+#include <ew/geometryArena.h>
+#include <ew/drawList.h>
+#include <ew/streamBuffer.h>
+
+#include "benchmarks.h"
+
+static const int NUM_MESHES = 64;
+static const int NUM_DRAWS = 4096;
+static const int FRAMES = 20;
+
+static glm::mat4 drawTransform(int i) {
+	return glm::translate(glm::mat4(1.0f), glm::vec3((i % 64) - 32.0f, ((i / 64) % 64) - 32.0f, -80.0f));
+}
+
+/// <summary>
+/// Many small distinct meshes: one VAO bind and glDrawElements each against one glMultiDrawElementsIndirect over a
+/// geometry arena. Measures CPU time to submit and the time until the GPU finishes.
+/// </summary>
+void runMultiDrawBenchmark() {
+	printf("\nMulti-draw indirect (%d draws of %d meshes)\n", NUM_DRAWS, NUM_MESHES);
+	std::vector<ew::MeshData> meshData;
+	for (int i = 0; i < NUM_MESHES; i++) {
+		meshData.push_back(ew::createSphere(0.4f, 4 + i % 8));
+	}
+
+	ew::Camera camera;
+	camera.position = glm::vec3(0.0f);
+	camera.target = glm::vec3(0.0f, 0.0f, -1.0f);
+	camera.farPlane = 200.0f;
+	glm::mat4 viewProjection = camera.projectionMatrix() * camera.viewMatrix();
+
+	{
+		std::vector<ew::Mesh> meshes(NUM_MESHES);
+		for (int i = 0; i < NUM_MESHES; i++) {
+			meshes[i].load(meshData[i]);
+		}
+		ew::Shader shader = ew::Shader("assets/multiDraw.vert", "assets/solid.frag");
+		shader.use();
+		shader.setMat4("_ViewProjection", viewProjection);
+		constexpr unsigned int MODEL_UNIFORM = ew::uniformHash("_Model");
+		ew::UniformLocation modelUniform = shader.getUniformLocation(MODEL_UNIFORM);
+
+		double submitMs = 0.0;
+		double totalMs = 0.0;
+		for (int frame = 0; frame < FRAMES; frame++) {
+			glFinish();
+			BenchTimer timer;
+			for (int i = 0; i < NUM_DRAWS; i++) {
+				shader.setMat4(modelUniform, drawTransform(i));
+				meshes[i % NUM_MESHES].draw();
+			}
+			submitMs += timer.elapsedMs();
+			glFinish();
+			totalMs += timer.elapsedMs();
+		}
+		printf("  %-28s submit %7.3f ms  total %7.3f ms\n", "glDrawElements per mesh", submitMs / FRAMES, totalMs / FRAMES);
+	}
+	{
+		ew::GeometryArena arena(1 << 16, 1 << 18);
+		std::vector<int> handles;
+		for (const ew::MeshData& data : meshData) {
+			handles.push_back(arena.add(data));
+		}
+		ew::Shader shader = ew::Shader("assets/multiDraw.vert", "assets/solid.frag", { { "MULTI_DRAW", "1" } });
+		shader.use();
+		shader.setMat4("_ViewProjection", viewProjection);
+		ew::DrawList drawList(arena);
+		drawList.frustumCulling = false;
+
+		double submitMs = 0.0;
+		double totalMs = 0.0;
+		for (int frame = 0; frame < FRAMES; frame++) {
+			glFinish();
+			BenchTimer timer;
+			drawList.begin(camera);
+			for (int i = 0; i < NUM_DRAWS; i++) {
+				drawList.add(handles[i % NUM_MESHES], drawTransform(i));
+			}
+			drawList.draw();
+			submitMs += timer.elapsedMs();
+			glFinish();
+			totalMs += timer.elapsedMs();
+		}
+		printf("  %-28s submit %7.3f ms  total %7.3f ms\n", "glMultiDrawElementsIndirect", submitMs / FRAMES, totalMs / FRAMES);
+
+		// Same draws written into a persistently mapped ring instead of respecified buffers. Frames are not
+		// finished here so the CPU can run ahead until the ring's fences stop it.
+		ew::StreamBuffer stream(NUM_DRAWS * (sizeof(ew::DrawData) + 32));
+		ew::DrawList streamDrawList(arena, &stream);
+		streamDrawList.frustumCulling = false;
+		glFinish();
+		BenchTimer timer;
+		for (int frame = 0; frame < FRAMES; frame++) {
+			stream.beginFrame();
+			streamDrawList.begin(camera);
+			for (int i = 0; i < NUM_DRAWS; i++) {
+				streamDrawList.add(handles[i % NUM_MESHES], drawTransform(i));
+			}
+			streamDrawList.draw();
+			stream.endFrame();
+		}
+		submitMs = timer.elapsedMs();
+		glFinish();
+		totalMs = timer.elapsedMs();
+		printf("  %-28s submit %7.3f ms  total %7.3f ms  %u stalls over %d frames\n", "... with StreamBuffer", submitMs / FRAMES, totalMs / FRAMES, stream.getStallCount(), FRAMES);
+	}
+}
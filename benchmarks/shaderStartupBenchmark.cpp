@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/shader.h>
+#include <ew/shaderCache.h>
+#include <ew/shaderBatch.h>
+#include <GLFW/glfw3.h>
+
+#include "benchmarks.h"
+
+//The assignment5 startup shader set, copied from its asset folder at build time
+static const char* STARTUP_PROGRAMS[][2] = {
+	{ "assets/startup/deferredLit.vert", "assets/startup/deferredLit.frag" },
+	{ "assets/startup/deferredLit.vert", "assets/startup/tiledDeferredLit.frag" },
+	{ "assets/startup/edge.vert", "assets/startup/edge.frag" },
+	{ "assets/startup/depthOnly.vert", "assets/startup/depthOnly.frag" },
+	{ "assets/startup/lit.vert", "assets/startup/geometryPass.frag" },
+	{ "assets/startup/lightOrb.vert", "assets/startup/lightOrb.frag" },
+};
+static const char* STARTUP_COMPUTE = "assets/startup/lightCulling.comp";
+static const char* BENCH_CACHE_DIRECTORY = "shadercache_bench";
+
+static double createStartupShaders() {
+	BenchTimer timer;
+	for (auto& program : STARTUP_PROGRAMS) {
+		ew::Shader shader = ew::Shader(program[0], program[1]);
+		glDeleteProgram(shader.getId());
+	}
+	ew::Shader compute = ew::Shader(STARTUP_COMPUTE);
+	glDeleteProgram(compute.getId());
+	glFinish();
+	return timer.elapsedMs();
+}
+
+/// <summary>
+/// Startup shader creation time without the program binary cache, with an empty cache, and with a warm cache.
+/// Note that some drivers (e.g. Mesa) keep their own disk cache, which also speeds up the uncached path.
+/// </summary>
+void runShaderCacheBenchmark() {
+	printf("Startup shader creation (%d programs)\n", (int)(sizeof(STARTUP_PROGRAMS) / sizeof(STARTUP_PROGRAMS[0])) + 1);
+
+	ew::setShaderCacheDirectory("");
+	printf("  %-48s %8.2f ms\n", "no program cache", createStartupShaders());
+
+	ew::setShaderCacheDirectory(BENCH_CACHE_DIRECTORY);
+	if (!ew::isShaderCacheEnabled()) {
+		printf("  program binaries unsupported by this driver\n\n");
+		return;
+	}
+	//Emptied first so the cold pass is guaranteed to miss, and again after so no binaries are left behind
+	ew::clearShaderCache();
+	printf("  %-48s %8.2f ms\n", "cold program cache (compile + store)", createStartupShaders());
+	printf("  %-48s %8.2f ms\n", "warm program cache (glProgramBinary)", createStartupShaders());
+	ew::clearShaderCache();
+	ew::setShaderCacheDirectory("");
+	printf("\n");
+}
+
+static void timeShaderBatch(const char* label, GLFWwindow* sharedWindow) {
+	BenchTimer timer;
+	std::vector<ew::ShaderFuture> futures;
+	{
+		ew::ShaderBatch batch(sharedWindow);
+		for (auto& program : STARTUP_PROGRAMS) {
+			futures.push_back(batch.add(program[0], program[1]));
+		}
+		futures.push_back(batch.add(STARTUP_COMPUTE));
+		double submitMs = timer.elapsedMs();
+		batch.wait();
+		glFinish();
+		printf("  %-34s submit %8.2f ms, ready %8.2f ms\n", label, submitMs, timer.elapsedMs());
+	}
+	for (const ew::ShaderFuture& future : futures) {
+		glDeleteProgram(future.get().getId());
+	}
+}
+
+/// <summary>
+/// Startup shader creation one program at a time versus submitting the whole set through ew::ShaderBatch.
+/// "submit" is how long the main thread is blocked before it can go load other assets.
+/// </summary>
+void runShaderBatchBenchmark(GLFWwindow* window) {
+	printf("Parallel shader compilation (program cache off)\n");
+	ew::setShaderCacheDirectory("");
+
+	printf("  %-48s %8.2f ms\n", "sequential ew::Shader", createStartupShaders());
+	timeShaderBatch("ShaderBatch (driver threads)", nullptr);
+	timeShaderBatch("ShaderBatch (background context)", window);
+	printf("\n");
+}
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/texture.h>
+#include <ew/textureData.h>
+#include <ew/textureCompression.h>
+#include <ew/workerPool.h>
+
+#include "benchmarks.h"
+
+static const char* COMPRESSED_PATH = "assets/textureCompressionBench.dds";
+
+/// <summary>
+/// Smooth gradients with some detail, closer to a real albedo than noise, which no block format handles well
+/// </summary>
+static void makeImage(ew::TextureData& textureData, int size) {
+	textureData.width = size;
+	textureData.height = size;
+	textureData.numComponents = 4;
+	textureData.pixels.resize((size_t)size * size * 4);
+	textureData.levelOffsets.assign(1, 0);
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++) {
+			unsigned char* p = &textureData.pixels[((size_t)y * size + x) * 4];
+			p[0] = (unsigned char)(x * 255 / size);
+			p[1] = (unsigned char)(y * 255 / size);
+			p[2] = (unsigned char)(128 + 127 * sinf(x * 0.05f) * cosf(y * 0.03f));
+			p[3] = 255;
+		}
+	}
+}
+
+/// <summary>
+/// Encoding is offline (tools/texCompress), reported for reference. Load is reading the DDS, upload is the GL thread.
+/// Error is the RMS of the top level read back from the driver against the source.
+/// </summary>
+void runTextureCompressionBenchmark() {
+	const int size = 2048;
+	printf("\nBlock compressed textures (%dx%d RGBA with mips)\n", size, size);
+	ew::WorkerPool pool;
+	ew::TextureData source;
+	makeImage(source, size);
+	ew::generateMips(source, &pool);
+	{
+		BenchTimer timer;
+		unsigned int texture = ew::createTexture(source, GL_REPEAT, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+		glFinish();
+		printf("  %-6s encode %8s  load %8s  upload %7.1f ms  VRAM %7zu KB\n", "RGBA8", "-", "-", timer.elapsedMs(), source.pixels.size() / 1024);
+		glDeleteTextures(1, &texture);
+	}
+	const char* names[] = { "BC1", "BC3", "BC5", "BC7" };
+	const ew::BlockFormat formats[] = { ew::BlockFormat::BC1, ew::BlockFormat::BC3, ew::BlockFormat::BC5, ew::BlockFormat::BC7 };
+	std::vector<unsigned char> readback((size_t)size * size * 4);
+	for (int i = 0; i < 4; i++) {
+		BenchTimer encodeTimer;
+		ew::TextureData compressed;
+		ew::compressTexture(source, formats[i], compressed, &pool);
+		double encodeMs = encodeTimer.elapsedMs();
+		if (!ew::writeDds(COMPRESSED_PATH, compressed)) {
+			return;
+		}
+		BenchTimer loadTimer;
+		ew::TextureData loaded;
+		ew::loadTextureData(COMPRESSED_PATH, loaded, true);
+		double loadMs = loadTimer.elapsedMs();
+		BenchTimer uploadTimer;
+		unsigned int texture = ew::createTexture(loaded, GL_REPEAT, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+		glFinish();
+		double uploadMs = uploadTimer.elapsedMs();
+
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTextureImage(texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, (int)readback.size(), readback.data());
+		const int channels = formats[i] == ew::BlockFormat::BC5 ? 2 : 3;
+		double error = 0.0;
+		for (size_t p = 0; p < (size_t)size * size; p++) {
+			for (int c = 0; c < channels; c++) {
+				double d = (double)readback[p * 4 + c] - source.pixels[p * 4 + c];
+				error += d * d;
+			}
+		}
+		printf("  %-6s encode %5.0f ms  load %5.1f ms  upload %7.1f ms  VRAM %7zu KB  RMS error %.2f\n", names[i], encodeMs, loadMs, uploadMs,
+			loaded.pixels.size() / 1024, sqrt(error / ((double)size * size * channels)));
+		glDeleteTextures(1, &texture);
+	}
+	remove(COMPRESSED_PATH);
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/texture.h>
+#include <ew/textureRegistry.h>
+
+#include "benchmarks.h"
+
+static const char* TEXTURE_PATH = "assets/textureRegistryBench.ppm";
+
+/// <summary>
+/// Writes a binary PPM so the benchmark has an image to decode without shipping one
+/// </summary>
+static bool writePpm(const char* path, int size) {
+	FILE* out = fopen(path, "wb");
+	if (out == nullptr) {
+		return false;
+	}
+	fprintf(out, "P6\n%d %d\n255\n", size, size);
+	std::vector<unsigned char> pixels((size_t)size * size * 3);
+	for (size_t i = 0; i < pixels.size(); i++) {
+		pixels[i] = (unsigned char)(i * 31);
+	}
+	fwrite(pixels.data(), 1, pixels.size(), out);
+	fclose(out);
+	return true;
+}
+
+/// <summary>
+/// Several materials sharing one texture: loadTexture decodes and uploads it for each, the registry once.
+/// </summary>
+void runTextureRegistryBenchmark() {
+	const int size = 1024;
+	const int materialCount = 8;
+	printf("\nTexture registry (%d materials sharing a %dx%d texture)\n", materialCount, size, size);
+	if (!writePpm(TEXTURE_PATH, size)) {
+		printf("  Failed to write %s\n", TEXTURE_PATH);
+		return;
+	}
+	//RGB is stored as RGBA, plus a full mip chain
+	size_t textureBytes = (size_t)size * size * 4;
+	textureBytes += textureBytes / 3;
+	{
+		BenchTimer timer;
+		std::vector<unsigned int> textures;
+		for (int i = 0; i < materialCount; i++) {
+			textures.push_back(ew::loadTexture(TEXTURE_PATH));
+		}
+		glFinish();
+		printf("  %-14s %9.1f ms  %6.1f MB\n", "loadTexture", timer.elapsedMs(), textures.size() * textureBytes / (1024.0 * 1024.0));
+		glDeleteTextures((int)textures.size(), textures.data());
+	}
+	{
+		ew::TextureRegistry registry;
+		BenchTimer timer;
+		std::vector<ew::TextureRef> textures;
+		for (int i = 0; i < materialCount; i++) {
+			textures.push_back(registry.load(TEXTURE_PATH));
+		}
+		glFinish();
+		printf("  %-14s %9.1f ms  %6.1f MB, %u decodes\n", "registry", timer.elapsedMs(), registry.getResidentBytes() / (1024.0 * 1024.0), registry.getMissCount());
+	}
+	remove(TEXTURE_PATH);
+}
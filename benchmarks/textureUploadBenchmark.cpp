@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/texture.h>
+#include <ew/textureData.h>
+#include <ew/workerPool.h>
+
+#include "benchmarks.h"
+
+static const char* TEXTURE_PATH = "assets/textureUploadBench.ppm";
+
+/// <summary>
+/// Writes a binary PPM so the benchmark has an image to decode without shipping one
+/// </summary>
+static bool writePpm(const char* path, int size) {
+	FILE* out = fopen(path, "wb");
+	if (out == nullptr) {
+		return false;
+	}
+	fprintf(out, "P6\n%d %d\n255\n", size, size);
+	std::vector<unsigned char> pixels((size_t)size * size * 3);
+	for (size_t i = 0; i < pixels.size(); i++) {
+		pixels[i] = (unsigned char)((i * 7) ^ (i >> 11));
+	}
+	fwrite(pixels.data(), 1, pixels.size(), out);
+	fclose(out);
+	return true;
+}
+
+/// <summary>
+/// 4K texture load with mips: loadTexture decodes, uploads and runs glGenerateMipmap on the GL thread, against
+/// decoding and box filtering on the CPU (off the GL thread in practice) followed by an immutable upload.
+/// GL thread is the time the render loop would be blocked.
+/// </summary>
+void runTextureUploadBenchmark() {
+	const int size = 4096;
+	printf("\nTexture load with mips (%dx%d RGB)\n", size, size);
+	if (!writePpm(TEXTURE_PATH, size)) {
+		printf("  Failed to write %s\n", TEXTURE_PATH);
+		return;
+	}
+	{
+		BenchTimer timer;
+		unsigned int texture = ew::loadTexture(TEXTURE_PATH);
+		glFinish();
+		double ms = timer.elapsedMs();
+		printf("  %-30s total %8.1f ms  GL thread %8.1f ms\n", "loadTexture + glGenerateMipmap", ms, ms);
+		glDeleteTextures(1, &texture);
+	}
+	ew::WorkerPool pool;
+	ew::WorkerPool* pools[] = { nullptr, &pool };
+	for (ew::WorkerPool* mipPool : pools) {
+		BenchTimer timer;
+		ew::TextureData textureData;
+		ew::loadTextureData(TEXTURE_PATH, textureData, true, false, mipPool);
+		double decodeMs = timer.elapsedMs();
+		BenchTimer uploadTimer;
+		unsigned int texture = ew::createTexture(textureData, GL_REPEAT, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+		glFinish();
+		double uploadMs = uploadTimer.elapsedMs();
+		char label[48];
+		snprintf(label, sizeof(label), "CPU mips, %d threads", mipPool != nullptr ? mipPool->getWorkerCount() + 1 : 1);
+		printf("  %-30s total %8.1f ms  GL thread %8.1f ms (decode + mips %.1f ms)\n", label, decodeMs + uploadMs, uploadMs, decodeMs);
+		glDeleteTextures(1, &texture);
+	}
+	remove(TEXTURE_PATH);
+}
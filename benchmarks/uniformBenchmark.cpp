@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <string>
+
+#include <ew/external/glad.h>
+#include <ew/shader.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "benchmarks.h"
+
+static const int ITERATIONS = 200000;
+
+static void report(const char* label, double ms) {
+	printf("  %-48s %8.1f ns/call\n", label, ms * 1000000.0 / ITERATIONS);
+}
+
+/// <summary>
+/// Per call cost of setting a uniform: driver lookups (the old ew::Shader setters),
+/// the cached name table, and pre-resolved handles.
+/// </summary>
+void runUniformBenchmark() {
+	printf("Uniform set cost (%d calls each)\n", ITERATIONS);
+
+	ew::Shader shader = ew::Shader("assets/uniformBench.vert", "assets/uniformBench.frag");
+	shader.use();
+	glm::mat4 model = glm::mat4(1.0f);
+	glm::vec3 position = glm::vec3(1.0f);
+
+	{
+		BenchTimer timer;
+		for (int i = 0; i < ITERATIONS; i++) {
+			glUniformMatrix4fv(glGetUniformLocation(shader.getId(), "_Model"), 1, GL_FALSE, glm::value_ptr(model));
+		}
+		report("before: glGetUniformLocation(\"_Model\")", timer.elapsedMs());
+	}
+	{
+		BenchTimer timer;
+		for (int i = 0; i < ITERATIONS; i++) {
+			std::string prefix = "_PointLights[" + std::to_string(i % 64) + "].";
+			glUniform3fv(glGetUniformLocation(shader.getId(), (prefix + "position").c_str()), 1, glm::value_ptr(position));
+		}
+		report("before: glGetUniformLocation(built array name)", timer.elapsedMs());
+	}
+	{
+		BenchTimer timer;
+		for (int i = 0; i < ITERATIONS; i++) {
+			shader.setMat4("_Model", model);
+		}
+		report("after: setMat4(\"_Model\") cached table", timer.elapsedMs());
+	}
+	{
+		BenchTimer timer;
+		for (int i = 0; i < ITERATIONS; i++) {
+			std::string prefix = "_PointLights[" + std::to_string(i % 64) + "].";
+			shader.setVec3(prefix + "position", position);
+		}
+		report("after: setVec3(built array name) cached table", timer.elapsedMs());
+	}
+	{
+		constexpr unsigned int MODEL_UNIFORM = ew::uniformHash("_Model");
+		BenchTimer timer;
+		for (int i = 0; i < ITERATIONS; i++) {
+			shader.setMat4(shader.getUniformLocation(MODEL_UNIFORM), model);
+		}
+		report("after: setMat4(compile time hash)", timer.elapsedMs());
+	}
+	{
+		ew::UniformLocation modelUniform = shader.getUniformLocation("_Model");
+		BenchTimer timer;
+		for (int i = 0; i < ITERATIONS; i++) {
+			shader.setMat4(modelUniform, model);
+		}
+		report("after: setMat4(pre-resolved handle)", timer.elapsedMs());
+	}
+	printf("\n");
+}
@@ -0,0 +1,310 @@
+#include "assetStreamer.h"
+#include "cookedModel.h"
+#include "procGen.h"
+#include "texture.h"
+#include "external/glad.h"
+#include <algorithm>
+#include <chrono>
+
+namespace ew {
+	struct AssetStreamer::Request {
+		bool isModel = false;
+		std::string filePath;
+		glm::vec3 position = glm::vec3(0);
+		float distance = 0.0f; //Squared, to the camera of the last update
+		AssetState state = AssetState::QUEUED;
+
+		//Texture
+		int wrapMode = 0;
+		int magFilter = 0;
+		int minFilter = 0;
+		bool mipmap = false;
+		bool srgb = false;
+		bool decoded = false;
+		TextureData textureData; //Freed once uploaded
+		unsigned int texture = 0;
+		TextureRef textureRef; //Holds the texture when it came from a registry
+
+		//Model
+		VertexFormat format = VertexFormat::FLOAT;
+		int numLods = 1;
+		bool cook = false; //Cook filePath into cookedPath on the worker if the copy is out of date
+		bool cooked = false; //Upload maps cookedPath. Set by the worker for cook requests.
+		std::string cookedPath;
+		std::vector<MeshData> meshes;
+		Model model;
+	};
+
+	static bool isCookedPath(const std::string& filePath) {
+		const std::string cookedExtension = ".ewmesh";
+		return filePath.size() >= cookedExtension.size() && filePath.compare(filePath.size() - cookedExtension.size(), cookedExtension.size(), cookedExtension) == 0;
+	}
+
+	AssetStreamer::AssetStreamer(WorkerPool& pool, int maxInFlight, TextureRegistry* textures)
+		: m_pool(pool), m_textures(textures)
+	{
+		m_maxInFlight = maxInFlight > 0 ? maxInFlight : std::max(pool.getWorkerCount(), 1);
+		const unsigned char grey[4] = { 128, 128, 128, 255 };
+		m_placeholderTexture = createTexture(grey, 1, 1, 4, GL_REPEAT, GL_NEAREST, GL_NEAREST, false);
+		m_placeholderModel = Model(std::vector<MeshData>{ createCube(1.0f) });
+	}
+
+	AssetStreamer::~AssetStreamer()
+	{
+		//Workers write into the requests, so none may be running
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_decodedCondition.wait(lock, [this] { return m_decoding == 0; });
+		}
+		for (const std::unique_ptr<Request>& request : m_requests) {
+			if (request->texture != 0 && !request->textureRef.valid()) {
+				glDeleteTextures(1, &request->texture);
+			}
+		}
+		glDeleteTextures(1, &m_placeholderTexture);
+	}
+
+	TextureHandle AssetStreamer::requestTexture(const std::string& filePath, const glm::vec3& position)
+	{
+		return requestTexture(filePath, position, GL_REPEAT, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR, true);
+	}
+
+	TextureHandle AssetStreamer::requestTexture(const std::string& filePath, const glm::vec3& position, int wrapMode, int magFilter, int minFilter, bool mipmap, bool srgb)
+	{
+		TextureHandle handle;
+		for (size_t i = 0; i < m_requests.size(); i++) {
+			const Request& other = *m_requests[i];
+			if (!other.isModel && other.filePath == filePath && other.wrapMode == wrapMode && other.magFilter == magFilter && other.minFilter == minFilter && other.mipmap == mipmap && other.srgb == srgb) {
+				handle.index = (int)i;
+				return handle;
+			}
+		}
+		std::unique_ptr<Request> request(new Request());
+		request->filePath = filePath;
+		request->position = position;
+		request->wrapMode = wrapMode;
+		request->magFilter = magFilter;
+		request->minFilter = minFilter;
+		request->mipmap = mipmap;
+		request->srgb = srgb;
+		handle.index = addRequest(std::move(request));
+		return handle;
+	}
+
+	ModelHandle AssetStreamer::requestModel(const std::string& filePath, const glm::vec3& position, VertexFormat format, int numLods)
+	{
+		return addModelRequest(filePath, position, format, numLods, false);
+	}
+
+	ModelHandle AssetStreamer::requestCookedModel(const std::string& sourcePath, const glm::vec3& position, VertexFormat format, int numLods)
+	{
+		return addModelRequest(sourcePath, position, format, numLods, true);
+	}
+
+	ModelHandle AssetStreamer::addModelRequest(const std::string& filePath, const glm::vec3& position, VertexFormat format, int numLods, bool cook)
+	{
+		ModelHandle handle;
+		for (size_t i = 0; i < m_requests.size(); i++) {
+			const Request& other = *m_requests[i];
+			if (other.isModel && other.filePath == filePath && other.format == format && other.numLods == numLods && other.cook == cook) {
+				handle.index = (int)i;
+				return handle;
+			}
+		}
+		std::unique_ptr<Request> request(new Request());
+		request->isModel = true;
+		request->filePath = filePath;
+		request->position = position;
+		request->format = format;
+		request->numLods = numLods;
+		request->cook = cook;
+		if (cook) {
+			request->cookedPath = getCookedPath(filePath);
+		}
+		else if (isCookedPath(filePath)) {
+			request->cooked = true;
+			request->cookedPath = filePath;
+		}
+		handle.index = addRequest(std::move(request));
+		return handle;
+	}
+
+	int AssetStreamer::addRequest(std::unique_ptr<Request> request)
+	{
+		m_queued.push_back(request.get());
+		m_requests.push_back(std::move(request));
+		m_pendingCount++;
+		return (int)m_requests.size() - 1;
+	}
+
+	void AssetStreamer::setPosition(TextureHandle handle, const glm::vec3& position)
+	{
+		m_requests[handle.index]->position = position;
+	}
+
+	void AssetStreamer::setPosition(ModelHandle handle, const glm::vec3& position)
+	{
+		m_requests[handle.index]->position = position;
+	}
+
+	/// <summary>
+	/// Distances are refreshed every call, so priorities follow the camera. Only a limited number of requests decode
+	/// at a time; the rest wait here rather than in the pool, where they could no longer be reordered.
+	/// </summary>
+	/// <param name="budgetMs">Milliseconds this frame may spend on uploads. A single upload may overrun it.</param>
+	void AssetStreamer::update(const glm::vec3& cameraPosition, double budgetMs)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_decoded.insert(m_decoded.end(), m_workerDecoded.begin(), m_workerDecoded.end());
+			m_workerDecoded.clear();
+		}
+		//Nearest last, so the next one to start or upload can be popped off the back
+		auto sortFarthestFirst = [&cameraPosition](std::vector<Request*>& requests) {
+			for (Request* request : requests) {
+				glm::vec3 toCamera = request->position - cameraPosition;
+				request->distance = glm::dot(toCamera, toCamera);
+			}
+			std::sort(requests.begin(), requests.end(), [](const Request* a, const Request* b) {
+				return a->distance > b->distance;
+			});
+		};
+
+		sortFarthestFirst(m_queued);
+		while (m_inFlight < m_maxInFlight && !m_queued.empty()) {
+			Request* request = m_queued.back();
+			m_queued.pop_back();
+			startDecode(request);
+		}
+
+		sortFarthestFirst(m_decoded);
+		double elapsedMs = 0.0;
+		int count = 0;
+		while (!m_decoded.empty() && (count == 0 || elapsedMs < budgetMs)) {
+			Request* request = m_decoded.back();
+			m_decoded.pop_back();
+			upload(request);
+			count++;
+			elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+		m_lastUploadCount = count;
+		m_lastUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	void AssetStreamer::finishAll()
+	{
+		while (m_pendingCount > 0) {
+			{
+				//Nothing to upload and nothing to start, so sleep until a worker finishes
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (m_decoded.empty() && m_queued.empty()) {
+					m_decodedCondition.wait(lock, [this] { return !m_workerDecoded.empty() || m_decoding == 0; });
+				}
+			}
+			update(glm::vec3(0), 1e9);
+		}
+	}
+
+	void AssetStreamer::startDecode(Request* request)
+	{
+		request->state = AssetState::LOADING;
+		m_inFlight++;
+		//Mapping a cooked file is cheap and needs the context anyway
+		if (request->cooked) {
+			m_decoded.push_back(request);
+			return;
+		}
+		if (!request->isModel && m_textures != nullptr) {
+			request->textureRef = m_textures->find(request->filePath, request->wrapMode, request->magFilter, request->minFilter, request->mipmap, request->srgb);
+			if (request->textureRef.valid()) {
+				m_decoded.push_back(request);
+				return;
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_decoding++;
+		}
+		WorkerPool* pool = &m_pool;
+		m_pool.submit([this, request, pool]() {
+			if (request->isModel && request->cook && isCookedModelCurrent(request->filePath, request->format, request->numLods)) {
+				request->cooked = true;
+			}
+			else if (request->isModel) {
+				request->meshes = loadModelMeshData(request->filePath, request->numLods, pool);
+				//The upload still uses the meshes in memory, the cooked copy is for the next launch
+				if (request->cook && !request->meshes.empty()) {
+					writeCookedModel(request->cookedPath, request->meshes, request->format, request->numLods);
+				}
+			}
+			else {
+				//Mips are built here too, so the upload is only a copy
+				request->decoded = loadTextureData(request->filePath.c_str(), request->textureData, request->mipmap, request->srgb, pool);
+			}
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_workerDecoded.push_back(request);
+			m_decoding--;
+			m_decodedCondition.notify_all();
+		});
+	}
+
+	void AssetStreamer::upload(Request* request)
+	{
+		m_inFlight--;
+		m_pendingCount--;
+		request->state = AssetState::FAILED;
+		if (request->isModel) {
+			if (request->cooked) {
+				request->model = Model(request->cookedPath);
+			}
+			else if (!request->meshes.empty()) {
+				request->model = Model(request->meshes, request->format);
+			}
+			std::vector<MeshData>().swap(request->meshes);
+			if (!request->model.getMeshes().empty()) {
+				request->state = AssetState::READY;
+			}
+			return;
+		}
+		if (request->textureRef.valid()) {
+			request->texture = request->textureRef.get();
+			request->state = AssetState::READY;
+			return;
+		}
+		if (!request->decoded) {
+			return;
+		}
+		if (m_textures != nullptr) {
+			request->textureRef = m_textures->add(request->filePath, request->wrapMode, request->magFilter, request->minFilter, request->mipmap, request->srgb, request->textureData);
+			request->texture = request->textureRef.get();
+		}
+		else {
+			request->texture = createTexture(request->textureData, request->wrapMode, request->magFilter, request->minFilter);
+		}
+		request->textureData = TextureData();
+		request->state = AssetState::READY;
+	}
+
+	unsigned int AssetStreamer::getTexture(TextureHandle handle)const
+	{
+		const Request& request = *m_requests[handle.index];
+		return request.state == AssetState::READY ? request.texture : m_placeholderTexture;
+	}
+
+	Model& AssetStreamer::getModel(ModelHandle handle)
+	{
+		Request& request = *m_requests[handle.index];
+		return request.state == AssetState::READY ? request.model : m_placeholderModel;
+	}
+
+	AssetState AssetStreamer::getState(TextureHandle handle)const
+	{
+		return m_requests[handle.index]->state;
+	}
+
+	AssetState AssetStreamer::getState(ModelHandle handle)const
+	{
+		return m_requests[handle.index]->state;
+	}
+}
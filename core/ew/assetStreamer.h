@@ -0,0 +1,101 @@
+#pragma once
+#include "model.h"
+#include "textureRegistry.h"
+#include "workerPool.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ew {
+	enum class AssetState {
+		QUEUED, //Waiting for a worker
+		LOADING, //Decoding on a worker or waiting for its upload
+		READY,
+		FAILED //Keeps drawing the placeholder
+	};
+
+	//Returned immediately by AssetStreamer. Valid for the lifetime of the streamer that made it.
+	struct TextureHandle {
+		int index = -1;
+	};
+	struct ModelHandle {
+		int index = -1;
+	};
+
+	/// <summary>
+	/// Loads models and textures in the background while the scene renders with placeholders. Requests closest to the
+	/// camera are decoded first and uploaded first, so large scenes open immediately and fill in from the viewer outwards.
+	/// Everything except the decoding happens in update, on the thread that owns the context.
+	/// </summary>
+	class AssetStreamer {
+	public:
+		//maxInFlight limits how many requests decode at once so a far request never delays a near one for long.
+		//0 uses the pool's worker count. With a registry, resident textures skip the decode and new ones are added
+		//to it; the registry must outlive the streamer.
+		AssetStreamer(WorkerPool& pool, int maxInFlight = 0, TextureRegistry* textures = nullptr);
+		//Waits for running decodes, then deletes every texture it created outside a registry
+		~AssetStreamer();
+		AssetStreamer(const AssetStreamer&) = delete;
+		AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+		//position is where the asset will be drawn, used for priority. Repeated requests return the same handle.
+		//Sampling defaults match loadTexture.
+		TextureHandle requestTexture(const std::string& filePath, const glm::vec3& position = glm::vec3(0));
+		//Decoded and mipmapped on a worker into immutable storage. srgb averages color in linear space, see TextureData.
+		TextureHandle requestTexture(const std::string& filePath, const glm::vec3& position, int wrapMode, int magFilter, int minFilter, bool mipmap, bool srgb = false);
+		//Cooked .ewmesh files skip the decode and are mapped during the upload
+		ModelHandle requestModel(const std::string& filePath, const glm::vec3& position = glm::vec3(0), VertexFormat format = VertexFormat::FLOAT, int numLods = 1);
+		//Source model that is cooked on first use, like getCookedModelPath but off the calling thread. A worker checks
+		//the cooked copy and, if it is missing or stale, imports the source and writes the copy for the next launch.
+		ModelHandle requestCookedModel(const std::string& sourcePath, const glm::vec3& position = glm::vec3(0), VertexFormat format = VertexFormat::FLOAT, int numLods = 1);
+		//For assets that move, or to raise a request's priority by pretending it is closer
+		void setPosition(TextureHandle handle, const glm::vec3& position);
+		void setPosition(ModelHandle handle, const glm::vec3& position);
+
+		//Starts decodes for the nearest queued requests and uploads finished ones, nearest first, until budgetMs has
+		//passed. At least one upload runs per call so loading always progresses.
+		void update(const glm::vec3& cameraPosition, double budgetMs);
+		//Blocks until every request is ready or failed. For loading screens and tests.
+		void finishAll();
+
+		//The placeholder until the texture is ready
+		unsigned int getTexture(TextureHandle handle)const;
+		//A unit cube until the model is ready
+		Model& getModel(ModelHandle handle);
+		AssetState getState(TextureHandle handle)const;
+		AssetState getState(ModelHandle handle)const;
+		//Requests not yet ready or failed
+		inline int getPendingCount()const { return m_pendingCount; }
+		inline double getLastUpdateMs()const { return m_lastUpdateMs; }
+		inline int getLastUploadCount()const { return m_lastUploadCount; }
+	private:
+		struct Request;
+
+		ModelHandle addModelRequest(const std::string& filePath, const glm::vec3& position, VertexFormat format, int numLods, bool cook);
+		int addRequest(std::unique_ptr<Request> request);
+		void startDecode(Request* request);
+		void upload(Request* request);
+
+		WorkerPool& m_pool;
+		TextureRegistry* m_textures;
+		int m_maxInFlight;
+		std::vector<std::unique_ptr<Request>> m_requests;
+		std::vector<Request*> m_queued; //Not started
+		std::vector<Request*> m_decoded; //Decoded, waiting for upload. Only touched in update.
+		int m_inFlight = 0; //Started and not yet uploaded
+
+		//Filled by workers, moved into m_decoded each update
+		std::mutex m_mutex;
+		std::condition_variable m_decodedCondition;
+		std::vector<Request*> m_workerDecoded;
+		int m_decoding = 0;
+
+		unsigned int m_placeholderTexture = 0;
+		Model m_placeholderModel;
+		int m_pendingCount = 0;
+		double m_lastUpdateMs = 0.0;
+		int m_lastUploadCount = 0;
+	};
+}
@@ -0,0 +1,203 @@
+#include "cookedModel.h"
+#include "mappedFile.h"
+#include "model.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+namespace ew {
+	static const char COOKED_MAGIC[4] = { 'E', 'W', 'M', 'S' };
+	static const size_t COOKED_ALIGNMENT = 16;
+
+	static size_t alignUp(size_t value) {
+		return (value + COOKED_ALIGNMENT - 1) / COOKED_ALIGNMENT * COOKED_ALIGNMENT;
+	}
+
+	/// <summary>
+	/// Appends a blob at the next aligned offset and returns that offset
+	/// </summary>
+	static unsigned long long appendBlob(std::vector<unsigned char>& file, const void* data, size_t size) {
+		size_t offset = alignUp(file.size());
+		file.resize(offset + size);
+		if (size > 0) {
+			memcpy(file.data() + offset, data, size);
+		}
+		return offset;
+	}
+
+	/// <summary>
+	/// Vertices are packed and indices narrowed exactly as Mesh::load would, so loading is a straight copy.
+	/// The whole file is built in memory and written with one call.
+	/// </summary>
+	/// <param name="numLods">Recorded so getCookedModelPath can tell when the settings changed</param>
+	bool writeCookedModel(const std::string& filePath, const std::vector<MeshData>& meshes, VertexFormat format, int numLods)
+	{
+		CookedModelHeader header = {};
+		memcpy(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC));
+		header.version = COOKED_MODEL_VERSION;
+		header.format = (unsigned int)format;
+		header.numLods = (unsigned int)numLods;
+		header.meshCount = (unsigned int)meshes.size();
+
+		std::vector<unsigned char> file(sizeof(CookedModelHeader) + sizeof(CookedMeshEntry) * meshes.size());
+		std::vector<CookedMeshEntry> entries(meshes.size());
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			const MeshData& meshData = meshes[i];
+			CookedMeshEntry& entry = entries[i];
+			entry = CookedMeshEntry();
+			glm::vec3 boundsMin = glm::vec3(0);
+			glm::vec3 boundsMax = glm::vec3(0);
+			if (!meshData.vertices.empty()) {
+				boundsMin = boundsMax = meshData.vertices[0].pos;
+			}
+			for (const Vertex& v : meshData.vertices) {
+				boundsMin = glm::min(boundsMin, v.pos);
+				boundsMax = glm::max(boundsMax, v.pos);
+			}
+			std::vector<unsigned char> packed = packVertices(meshData.vertices, format, boundsMin, boundsMax);
+			entry.vertexOffset = appendBlob(file, packed.data(), packed.size());
+			entry.vertexCount = (unsigned int)meshData.vertices.size();
+			entry.indexCount = (unsigned int)meshData.indices.size();
+			if (meshData.vertices.size() <= 65536) {
+				std::vector<unsigned short> shortIndices(meshData.indices.begin(), meshData.indices.end());
+				entry.indexSize = sizeof(unsigned short);
+				entry.indexOffset = appendBlob(file, shortIndices.data(), shortIndices.size() * sizeof(unsigned short));
+			}
+			else {
+				entry.indexSize = sizeof(unsigned int);
+				entry.indexOffset = appendBlob(file, meshData.indices.data(), meshData.indices.size() * sizeof(unsigned int));
+			}
+			entry.lodCount = (unsigned int)meshData.lods.size();
+			entry.lodOffset = appendBlob(file, meshData.lods.data(), meshData.lods.size() * sizeof(MeshLod));
+			entry.meshletCount = (unsigned int)meshData.meshlets.size();
+			entry.meshletOffset = appendBlob(file, meshData.meshlets.data(), meshData.meshlets.size() * sizeof(Meshlet));
+			memcpy(entry.boundsMin, &boundsMin, sizeof(entry.boundsMin));
+			memcpy(entry.boundsMax, &boundsMax, sizeof(entry.boundsMax));
+		}
+		memcpy(file.data(), &header, sizeof(header));
+		if (!entries.empty()) {
+			memcpy(file.data() + sizeof(header), entries.data(), sizeof(CookedMeshEntry) * entries.size());
+		}
+
+		FILE* out = fopen(filePath.c_str(), "wb");
+		if (out == nullptr) {
+			printf("Failed to write cooked model %s\n", filePath.c_str());
+			return false;
+		}
+		bool written = fwrite(file.data(), 1, file.size(), out) == file.size();
+		written = fclose(out) == 0 && written;
+		if (!written) {
+			printf("Failed to write cooked model %s\n", filePath.c_str());
+			remove(filePath.c_str());
+		}
+		return written;
+	}
+
+	bool cookModel(const std::string& sourcePath, const std::string& cookedPath, VertexFormat format, int numLods)
+	{
+		std::vector<MeshData> meshes = loadModelMeshData(sourcePath, numLods);
+		if (meshes.empty()) {
+			return false;
+		}
+		return writeCookedModel(cookedPath, meshes, format, numLods);
+	}
+
+	/// <summary>
+	/// Reads the header and mesh table from the mapping, then hands each blob to Mesh::load without touching vertices.
+	/// Meshes are appended to the output, and only once the whole table has been validated.
+	/// </summary>
+	bool loadCookedModel(const std::string& filePath, std::vector<Mesh>& meshes)
+	{
+		MappedFile file;
+		if (!file.open(filePath)) {
+			return false;
+		}
+		const unsigned char* data = file.getData();
+		size_t size = file.getSize();
+		CookedModelHeader header;
+		if (size < sizeof(header)) {
+			printf("Cooked model %s is truncated\n", filePath.c_str());
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+		if (memcmp(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) != 0 || header.version != COOKED_MODEL_VERSION) {
+			printf("Cooked model %s has version %u, expected %u. Cook it again.\n", filePath.c_str(), header.version, COOKED_MODEL_VERSION);
+			return false;
+		}
+		if (sizeof(header) + sizeof(CookedMeshEntry) * (size_t)header.meshCount > size) {
+			printf("Cooked model %s is truncated\n", filePath.c_str());
+			return false;
+		}
+		const CookedMeshEntry* entries = (const CookedMeshEntry*)(data + sizeof(header));
+		VertexFormat format = (VertexFormat)header.format;
+		for (unsigned int i = 0; i < header.meshCount; i++)
+		{
+			const CookedMeshEntry& entry = entries[i];
+			if (entry.vertexOffset + (unsigned long long)entry.vertexCount * getVertexStride(format) > size
+				|| entry.indexOffset + (unsigned long long)entry.indexCount * entry.indexSize > size
+				|| entry.lodOffset + (unsigned long long)entry.lodCount * sizeof(MeshLod) > size
+				|| entry.meshletOffset + (unsigned long long)entry.meshletCount * sizeof(Meshlet) > size) {
+				printf("Cooked model %s is truncated\n", filePath.c_str());
+				return false;
+			}
+		}
+		for (unsigned int i = 0; i < header.meshCount; i++)
+		{
+			const CookedMeshEntry& entry = entries[i];
+			PackedMeshView view;
+			view.format = format;
+			view.vertices = data + entry.vertexOffset;
+			view.vertexCount = entry.vertexCount;
+			view.indices = data + entry.indexOffset;
+			view.indexCount = entry.indexCount;
+			view.indexSize = entry.indexSize;
+			view.boundsMin = glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+			view.boundsMax = glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+			view.lods = (const MeshLod*)(data + entry.lodOffset);
+			view.lodCount = entry.lodCount;
+			view.meshlets = (const Meshlet*)(data + entry.meshletOffset);
+			view.meshletCount = entry.meshletCount;
+			meshes.push_back(Mesh());
+			meshes.back().load(view);
+		}
+		return true;
+	}
+
+	std::string getCookedPath(const std::string& sourcePath)
+	{
+		return sourcePath + ".ewmesh";
+	}
+
+	/// <summary>
+	/// Only the header is read to check the settings, so an up to date cooked file costs one small read
+	/// </summary>
+	bool isCookedModelCurrent(const std::string& sourcePath, VertexFormat format, int numLods)
+	{
+		std::string cookedPath = getCookedPath(sourcePath);
+		struct stat sourceInfo;
+		struct stat cookedInfo;
+		bool fresh = stat(cookedPath.c_str(), &cookedInfo) == 0
+			&& (stat(sourcePath.c_str(), &sourceInfo) != 0 || cookedInfo.st_mtime >= sourceInfo.st_mtime);
+		if (fresh) {
+			CookedModelHeader header = {};
+			FILE* in = fopen(cookedPath.c_str(), "rb");
+			fresh = in != nullptr && fread(&header, sizeof(header), 1, in) == 1;
+			if (in != nullptr) {
+				fclose(in);
+			}
+			fresh = fresh && memcmp(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) == 0 && header.version == COOKED_MODEL_VERSION
+				&& header.format == (unsigned int)format && header.numLods == (unsigned int)numLods;
+		}
+		return fresh;
+	}
+
+	std::string getCookedModelPath(const std::string& sourcePath, VertexFormat format, int numLods)
+	{
+		std::string cookedPath = getCookedPath(sourcePath);
+		if (isCookedModelCurrent(sourcePath, format, numLods) || cookModel(sourcePath, cookedPath, format, numLods)) {
+			return cookedPath;
+		}
+		return sourcePath;
+	}
+}
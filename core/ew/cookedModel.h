@@ -0,0 +1,48 @@
+#pragma once
+#include "mesh.h"
+#include <string>
+#include <vector>
+
+namespace ew {
+	//Bump when the layout of .ewmesh files or of the structs they store changes
+	const unsigned int COOKED_MODEL_VERSION = 1;
+
+	//Header of a .ewmesh file, followed by one CookedMeshEntry per mesh. Offsets are from the start of the file.
+	struct CookedModelHeader {
+		char magic[4]; //"EWMS"
+		unsigned int version;
+		unsigned int format; //VertexFormat of every vertex blob
+		unsigned int numLods; //Levels requested when cooking
+		unsigned int meshCount;
+		unsigned int reserved;
+	};
+
+	struct CookedMeshEntry {
+		unsigned long long vertexOffset; //vertexCount * getVertexStride(format) bytes, ready for glBufferData
+		unsigned long long indexOffset; //indexCount * indexSize bytes
+		unsigned long long lodOffset; //lodCount MeshLod
+		unsigned long long meshletOffset; //meshletCount Meshlet
+		unsigned int vertexCount;
+		unsigned int indexCount;
+		unsigned int indexSize;
+		unsigned int lodCount;
+		unsigned int meshletCount;
+		unsigned int reserved;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	//Writes processed meshes as GPU ready blobs with bounds, LOD and meshlet tables
+	bool writeCookedModel(const std::string& filePath, const std::vector<MeshData>& meshes, VertexFormat format, int numLods = 1);
+	//Imports sourcePath with Assimp, processes it like Model does and writes the result
+	bool cookModel(const std::string& sourcePath, const std::string& cookedPath, VertexFormat format, int numLods = 1);
+	//Maps a .ewmesh file and uploads every mesh straight from the mapping
+	bool loadCookedModel(const std::string& filePath, std::vector<Mesh>& meshes);
+	//Where getCookedModelPath and AssetStreamer::requestCookedModel keep the cooked copy of sourcePath
+	std::string getCookedPath(const std::string& sourcePath);
+	//True if the cooked copy exists, is not older than the source and was cooked with these settings
+	bool isCookedModelCurrent(const std::string& sourcePath, VertexFormat format, int numLods = 1);
+	//Path of an up to date cooked copy of sourcePath (sourcePath + ".ewmesh"), cooking it when it is missing,
+	//older than the source or was cooked with other settings. Returns sourcePath if cooking fails.
+	std::string getCookedModelPath(const std::string& sourcePath, VertexFormat format, int numLods = 1);
+}
@@ -0,0 +1,87 @@
+#include "drawList.h"
+#include "external/glad.h"
+#include <algorithm>
+
+namespace ew {
+	DrawList::DrawList(const GeometryArena& arena, StreamBuffer* stream)
+		: m_arena(&arena), m_stream(stream)
+	{
+		glCreateBuffers(1, &m_commandBuffer);
+		glCreateBuffers(1, &m_drawDataBuffer);
+	}
+
+	DrawList::~DrawList()
+	{
+		glDeleteBuffers(1, &m_commandBuffer);
+		glDeleteBuffers(1, &m_drawDataBuffer);
+	}
+
+	void DrawList::begin(const Camera& camera)
+	{
+		m_frustum = Frustum(camera.projectionMatrix() * camera.viewMatrix());
+		m_commands.clear();
+		m_drawData.clear();
+		m_culledCount = 0;
+		m_uploaded = false;
+	}
+
+	/// <param name="mesh">Handle returned by GeometryArena::add</param>
+	/// <param name="lod">Level of detail, clamped to the coarsest level</param>
+	void DrawList::add(int mesh, const glm::mat4& modelMatrix, int lod)
+	{
+		const ArenaMesh& arenaMesh = m_arena->getMesh(mesh);
+		if (!arenaMesh.live || arenaMesh.lods.empty()) {
+			return;
+		}
+		if (frustumCulling) {
+			glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((arenaMesh.boundsMin + arenaMesh.boundsMax) * 0.5f, 1.0f));
+			float scale = std::max(glm::length(glm::vec3(modelMatrix[0])), std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+			if (m_frustum.sphereOutside(center, glm::length(arenaMesh.boundsMax - arenaMesh.boundsMin) * 0.5f * scale)) {
+				m_culledCount++;
+				return;
+			}
+		}
+		const MeshLod& level = arenaMesh.lods[glm::clamp(lod, 0, (int)arenaMesh.lods.size() - 1)];
+		DrawCommand command = { level.indexCount, 1, arenaMesh.firstIndex + level.indexOffset, (int)arenaMesh.baseVertex, 0 };
+		m_commands.push_back(command);
+		DrawData data = { modelMatrix, glm::vec4(arenaMesh.positionScale, 0.0f), glm::vec4(arenaMesh.positionOffset, 0.0f) };
+		m_drawData.push_back(data);
+		m_uploaded = false;
+	}
+
+	/// <summary>
+	/// Without a StreamBuffer, or when its region is full, the list's own buffers are respecified on upload so the driver
+	/// can hand out fresh storage while earlier draws still read the old one
+	/// </summary>
+	void DrawList::draw()
+	{
+		if (m_commands.empty()) {
+			return;
+		}
+		if (!m_uploaded) {
+			size_t commandBytes = sizeof(DrawCommand) * m_commands.size();
+			size_t drawDataBytes = sizeof(DrawData) * m_drawData.size();
+			m_commandSlice = StreamSlice();
+			m_drawDataSlice = StreamSlice();
+			if (m_stream != nullptr) {
+				m_commandSlice = m_stream->write(m_commands.data(), commandBytes);
+				m_drawDataSlice = m_stream->write(m_drawData.data(), drawDataBytes);
+			}
+			if (m_commandSlice.data == nullptr || m_drawDataSlice.data == nullptr) {
+				glNamedBufferData(m_commandBuffer, commandBytes, m_commands.data(), GL_STREAM_DRAW);
+				glNamedBufferData(m_drawDataBuffer, drawDataBytes, m_drawData.data(), GL_STREAM_DRAW);
+				m_commandSlice.buffer = m_commandBuffer;
+				m_commandSlice.offset = 0;
+				m_drawDataSlice.buffer = m_drawDataBuffer;
+				m_drawDataSlice.offset = 0;
+				m_drawDataSlice.size = drawDataBytes;
+			}
+			m_uploaded = true;
+		}
+		glBindVertexArray(m_arena->getVao());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandSlice.buffer);
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, m_drawDataSlice.buffer, m_drawDataSlice.offset, m_drawDataSlice.size);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)m_commandSlice.offset, (GLsizei)m_commands.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "camera.h"
+#include "frustum.h"
+#include "geometryArena.h"
+#include "streamBuffer.h"
+#include <vector>
+
+namespace ew {
+	//Shader storage binding of the DrawData array. 0 and 1 are used by the tiled lighting buffers.
+	const unsigned int DRAW_DATA_BINDING = 2;
+
+	//Per draw values read by shaders as _Draws[gl_DrawID], std430 layout
+	struct DrawData {
+		glm::mat4 model;
+		glm::vec4 positionScale; //xyz, dequantizes PACKED_QUANTIZED positions
+		glm::vec4 positionOffset;
+	};
+
+	/// <summary>
+	/// Collects draws of GeometryArena meshes for one view and submits them with a single glMultiDrawElementsIndirect.
+	/// Shaders must be compiled with MULTI_DRAW 1 to read their model matrix from the DrawData buffer.
+	/// With a StreamBuffer, commands and draw data are written into the current frame's region instead of own buffers.
+	/// </summary>
+	class DrawList {
+	public:
+		bool frustumCulling = true;
+
+		DrawList(const GeometryArena& arena, StreamBuffer* stream = nullptr);
+		~DrawList();
+		DrawList(const DrawList&) = delete;
+		DrawList& operator=(const DrawList&) = delete;
+
+		//Clears the list and sets the view meshes are culled against
+		void begin(const Camera& camera);
+		//Queues one level of detail of an arena mesh. Meshes outside the frustum are skipped.
+		void add(int mesh, const glm::mat4& modelMatrix, int lod = 0);
+		//Uploads the queued draws and issues them. The list can be drawn again until the next begin(), and with a
+		//StreamBuffer only until its next beginFrame().
+		void draw();
+		inline unsigned int getDrawCount()const { return (unsigned int)m_commands.size(); }
+		inline unsigned int getCulledCount()const { return m_culledCount; }
+	private:
+		//Layout defined by glMultiDrawElementsIndirect
+		struct DrawCommand {
+			unsigned int count;
+			unsigned int instanceCount;
+			unsigned int firstIndex;
+			int baseVertex;
+			unsigned int baseInstance;
+		};
+
+		const GeometryArena* m_arena;
+		StreamBuffer* m_stream;
+		StreamSlice m_commandSlice;
+		StreamSlice m_drawDataSlice;
+		Frustum m_frustum;
+		std::vector<DrawCommand> m_commands;
+		std::vector<DrawData> m_drawData;
+		unsigned int m_culledCount = 0;
+		bool m_uploaded = false;
+		unsigned int m_commandBuffer = 0;
+		unsigned int m_drawDataBuffer = 0;
+	};
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <glm/glm.hpp>
+
+namespace ew {
+	//World space view volume for culling bounding spheres
+	struct Frustum {
+		glm::vec4 planes[6]; //xyz normalized and pointing inwards
+
+		Frustum() {};
+		//Gribb and Hartmann: each plane is the last row of the matrix plus or minus one of the others
+		inline Frustum(const glm::mat4& viewProjection) {
+			glm::vec4 rows[4];
+			for (int i = 0; i < 4; i++)
+			{
+				rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+			}
+			for (int i = 0; i < 3; i++)
+			{
+				planes[i * 2] = rows[3] + rows[i];
+				planes[i * 2 + 1] = rows[3] - rows[i];
+			}
+			for (glm::vec4& plane : planes) {
+				plane /= glm::length(glm::vec3(plane));
+			}
+		}
+		inline bool sphereOutside(const glm::vec3& center, float radius)const {
+			for (const glm::vec4& plane : planes) {
+				if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+}
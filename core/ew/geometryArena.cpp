@@ -0,0 +1,216 @@
+#include "geometryArena.h"
+#include "external/glad.h"
+#include <algorithm>
+#include <limits.h>
+#include <stdio.h>
+
+namespace ew {
+	/// <param name="vertexCapacity">Vertices the arena can hold</param>
+	/// <param name="indexCapacity">Indices the arena can hold, always stored as 32 bit</param>
+	/// <param name="format">GPU vertex layout of every mesh in the arena</param>
+	GeometryArena::GeometryArena(unsigned int vertexCapacity, unsigned int indexCapacity, VertexFormat format)
+		: m_format(format), m_vertexStride(getVertexStride(format)), m_vertexCapacity(vertexCapacity), m_indexCapacity(indexCapacity)
+	{
+		createBuffers(&m_vbo, &m_ebo);
+		glCreateVertexArrays(1, &m_vao);
+		VertexAttribute attributes[3];
+		getVertexAttributes(format, attributes);
+		for (int i = 0; i < 3; i++)
+		{
+			glEnableVertexArrayAttrib(m_vao, i);
+			glVertexArrayAttribFormat(m_vao, i, attributes[i].size, attributes[i].type, attributes[i].normalized, attributes[i].offset);
+			glVertexArrayAttribBinding(m_vao, i, 0);
+		}
+		glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, m_vertexStride);
+		glVertexArrayElementBuffer(m_vao, m_ebo);
+
+		if (vertexCapacity > 0) {
+			m_freeVertices[0] = vertexCapacity;
+		}
+		if (indexCapacity > 0) {
+			m_freeIndices[0] = indexCapacity;
+		}
+	}
+
+	GeometryArena::~GeometryArena()
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+	}
+
+	void GeometryArena::createBuffers(unsigned int* vbo, unsigned int* ebo)
+	{
+		glCreateBuffers(1, vbo);
+		glNamedBufferStorage(*vbo, (GLsizeiptr)m_vertexCapacity * m_vertexStride, NULL, GL_DYNAMIC_STORAGE_BIT);
+		glCreateBuffers(1, ebo);
+		glNamedBufferStorage(*ebo, (GLsizeiptr)m_indexCapacity * sizeof(unsigned int), NULL, GL_DYNAMIC_STORAGE_BIT);
+	}
+
+	unsigned int GeometryArena::allocate(FreeList& freeList, unsigned int count)
+	{
+		for (FreeList::iterator it = freeList.begin(); it != freeList.end(); ++it) {
+			if (it->second < count) {
+				continue;
+			}
+			unsigned int offset = it->first;
+			unsigned int remaining = it->second - count;
+			freeList.erase(it);
+			if (remaining > 0) {
+				freeList[offset + count] = remaining;
+			}
+			return offset;
+		}
+		return UINT_MAX;
+	}
+
+	void GeometryArena::release(FreeList& freeList, unsigned int offset, unsigned int count)
+	{
+		if (count == 0) {
+			return;
+		}
+		FreeList::iterator it = freeList.insert(std::make_pair(offset, count)).first;
+		FreeList::iterator next = std::next(it);
+		if (next != freeList.end() && it->first + it->second == next->first) {
+			it->second += next->second;
+			freeList.erase(next);
+		}
+		if (it != freeList.begin()) {
+			FreeList::iterator prev = std::prev(it);
+			if (prev->first + prev->second == it->first) {
+				prev->second += it->second;
+				freeList.erase(it);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Packs the vertices into the arena's format and uploads them with the indices. Compacts once if no free block is
+	/// large enough.
+	/// </summary>
+	int GeometryArena::add(const MeshData& meshData)
+	{
+		unsigned int vertexCount = (unsigned int)meshData.vertices.size();
+		unsigned int indexCount = (unsigned int)meshData.indices.size();
+		unsigned int baseVertex = allocate(m_freeVertices, vertexCount);
+		unsigned int firstIndex = baseVertex == UINT_MAX ? UINT_MAX : allocate(m_freeIndices, indexCount);
+		if (firstIndex == UINT_MAX) {
+			if (baseVertex != UINT_MAX) {
+				release(m_freeVertices, baseVertex, vertexCount);
+			}
+			if (m_usedVertices + vertexCount > m_vertexCapacity || m_usedIndices + indexCount > m_indexCapacity) {
+				printf("Geometry arena full: %u vertices and %u indices do not fit\n", vertexCount, indexCount);
+				return -1;
+			}
+			//Enough space in total, just fragmented
+			compact();
+			baseVertex = allocate(m_freeVertices, vertexCount);
+			firstIndex = allocate(m_freeIndices, indexCount);
+		}
+
+		int handle;
+		if (!m_freeHandles.empty()) {
+			handle = m_freeHandles.back();
+			m_freeHandles.pop_back();
+		}
+		else {
+			handle = (int)m_meshes.size();
+			m_meshes.push_back(ArenaMesh());
+		}
+		ArenaMesh& mesh = m_meshes[handle];
+		mesh = ArenaMesh();
+		mesh.baseVertex = baseVertex;
+		mesh.vertexCount = vertexCount;
+		mesh.firstIndex = firstIndex;
+		mesh.indexCount = indexCount;
+		mesh.live = true;
+		mesh.lods = meshData.lods;
+		if (mesh.lods.empty()) {
+			MeshLod lod = { 0, indexCount, 0.0f, 0, 0 };
+			mesh.lods.push_back(lod);
+		}
+		if (vertexCount > 0) {
+			mesh.boundsMin = mesh.boundsMax = meshData.vertices[0].pos;
+		}
+		for (const Vertex& v : meshData.vertices) {
+			mesh.boundsMin = glm::min(mesh.boundsMin, v.pos);
+			mesh.boundsMax = glm::max(mesh.boundsMax, v.pos);
+		}
+		if (m_format == VertexFormat::PACKED_QUANTIZED) {
+			mesh.positionOffset = mesh.boundsMin;
+			mesh.positionScale = mesh.boundsMax - mesh.boundsMin;
+		}
+
+		if (vertexCount > 0) {
+			std::vector<unsigned char> packed = packVertices(meshData.vertices, m_format, mesh.boundsMin, mesh.boundsMax);
+			glNamedBufferSubData(m_vbo, (GLintptr)baseVertex * m_vertexStride, packed.size(), packed.data());
+		}
+		if (indexCount > 0) {
+			glNamedBufferSubData(m_ebo, (GLintptr)firstIndex * sizeof(unsigned int), (GLsizeiptr)indexCount * sizeof(unsigned int), meshData.indices.data());
+		}
+		m_usedVertices += vertexCount;
+		m_usedIndices += indexCount;
+		return handle;
+	}
+
+	void GeometryArena::remove(int handle)
+	{
+		if (handle < 0 || handle >= (int)m_meshes.size() || !m_meshes[handle].live) {
+			return;
+		}
+		ArenaMesh& mesh = m_meshes[handle];
+		release(m_freeVertices, mesh.baseVertex, mesh.vertexCount);
+		release(m_freeIndices, mesh.firstIndex, mesh.indexCount);
+		m_usedVertices -= mesh.vertexCount;
+		m_usedIndices -= mesh.indexCount;
+		mesh.live = false;
+		m_freeHandles.push_back(handle);
+	}
+
+	/// <summary>
+	/// Copies live meshes into fresh buffers back to back, in their current order. Ranges can't be moved within one
+	/// buffer because overlapping copies are not allowed.
+	/// </summary>
+	void GeometryArena::compact()
+	{
+		std::vector<int> order;
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			if (m_meshes[i].live) {
+				order.push_back((int)i);
+			}
+		}
+		std::sort(order.begin(), order.end(), [this](int a, int b) {
+			return m_meshes[a].baseVertex < m_meshes[b].baseVertex;
+		});
+
+		unsigned int vbo, ebo;
+		createBuffers(&vbo, &ebo);
+		unsigned int vertexEnd = 0;
+		unsigned int indexEnd = 0;
+		for (int handle : order) {
+			ArenaMesh& mesh = m_meshes[handle];
+			if (mesh.vertexCount > 0) {
+				glCopyNamedBufferSubData(m_vbo, vbo, (GLintptr)mesh.baseVertex * m_vertexStride, (GLintptr)vertexEnd * m_vertexStride, (GLsizeiptr)mesh.vertexCount * m_vertexStride);
+			}
+			if (mesh.indexCount > 0) {
+				glCopyNamedBufferSubData(m_ebo, ebo, (GLintptr)mesh.firstIndex * sizeof(unsigned int), (GLintptr)indexEnd * sizeof(unsigned int), (GLsizeiptr)mesh.indexCount * sizeof(unsigned int));
+			}
+			mesh.baseVertex = vertexEnd;
+			mesh.firstIndex = indexEnd;
+			vertexEnd += mesh.vertexCount;
+			indexEnd += mesh.indexCount;
+		}
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+		m_vbo = vbo;
+		m_ebo = ebo;
+		glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, m_vertexStride);
+		glVertexArrayElementBuffer(m_vao, m_ebo);
+
+		m_freeVertices.clear();
+		m_freeIndices.clear();
+		release(m_freeVertices, vertexEnd, m_vertexCapacity - vertexEnd);
+		release(m_freeIndices, indexEnd, m_indexCapacity - indexEnd);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "mesh.h"
+#include <map>
+#include <vector>
+
+namespace ew {
+	//Where one mesh lives inside a GeometryArena
+	struct ArenaMesh {
+		unsigned int baseVertex = 0;
+		unsigned int vertexCount = 0;
+		unsigned int firstIndex = 0;
+		unsigned int indexCount = 0;
+		std::vector<MeshLod> lods; //Index offsets are relative to firstIndex
+		glm::vec3 boundsMin = glm::vec3(0);
+		glm::vec3 boundsMax = glm::vec3(0);
+		glm::vec3 positionScale = glm::vec3(1); //Dequantization transform, identity unless quantized
+		glm::vec3 positionOffset = glm::vec3(0);
+		bool live = false;
+	};
+
+	/// <summary>
+	/// One vertex buffer, one index buffer and one VAO shared by many meshes, so they can be drawn together with
+	/// multi-draw indirect (see DrawList). Meshes are sub-allocated as vertex and index ranges and addressed by handle.
+	/// Indices stay relative to the mesh and are offset by baseVertex when drawn.
+	/// </summary>
+	class GeometryArena {
+	public:
+		GeometryArena(unsigned int vertexCapacity, unsigned int indexCapacity, VertexFormat format = VertexFormat::FLOAT);
+		~GeometryArena();
+		GeometryArena(const GeometryArena&) = delete;
+		GeometryArena& operator=(const GeometryArena&) = delete;
+
+		//Returns a handle, or -1 if the mesh does not fit even after compacting
+		int add(const MeshData& meshData);
+		//Frees the mesh's ranges for reuse. The handle may be returned again by a later add.
+		void remove(int handle);
+		//Moves every mesh to the front of the buffers so all free space is one block. Handles stay valid.
+		void compact();
+
+		inline const ArenaMesh& getMesh(int handle)const { return m_meshes[handle]; }
+		inline unsigned int getVao()const { return m_vao; }
+		inline VertexFormat getFormat()const { return m_format; }
+		inline unsigned int getVertexCapacity()const { return m_vertexCapacity; }
+		inline unsigned int getIndexCapacity()const { return m_indexCapacity; }
+		inline unsigned int getUsedVertices()const { return m_usedVertices; }
+		inline unsigned int getUsedIndices()const { return m_usedIndices; }
+		//Separate free blocks across both buffers, 2 when fully compacted
+		inline unsigned int getFreeBlockCount()const { return (unsigned int)(m_freeVertices.size() + m_freeIndices.size()); }
+	private:
+		//First fit over free blocks keyed by offset, merging neighbors on release
+		typedef std::map<unsigned int, unsigned int> FreeList;
+		static unsigned int allocate(FreeList& freeList, unsigned int count);
+		static void release(FreeList& freeList, unsigned int offset, unsigned int count);
+		void createBuffers(unsigned int* vbo, unsigned int* ebo);
+
+		VertexFormat m_format;
+		unsigned int m_vertexStride;
+		unsigned int m_vertexCapacity;
+		unsigned int m_indexCapacity;
+		unsigned int m_usedVertices = 0;
+		unsigned int m_usedIndices = 0;
+		unsigned int m_vao = 0;
+		unsigned int m_vbo = 0;
+		unsigned int m_ebo = 0;
+		FreeList m_freeVertices;
+		FreeList m_freeIndices;
+		std::vector<ArenaMesh> m_meshes;
+		std::vector<int> m_freeHandles;
+	};
+}
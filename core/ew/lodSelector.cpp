@@ -0,0 +1,95 @@
+#include "lodSelector.h"
+#include <algorithm>
+
+namespace ew {
+	/// <param name="viewportHeight">Height in pixels of the target the camera renders to</param>
+	void LodSelector::begin(const Camera& camera, float viewportHeight)
+	{
+		m_cameraPosition = camera.position;
+		m_nearPlane = camera.nearPlane;
+		m_orthographic = camera.orthographic;
+		if (m_orthographic) {
+			m_projectionScale = viewportHeight / camera.orthoHeight;
+		}
+		else {
+			m_projectionScale = viewportHeight / (2.0f * tanf(glm::radians(camera.fov) * 0.5f));
+		}
+		m_triangleCount = 0;
+	}
+
+	int LodSelector::select(const Mesh& mesh, const glm::mat4& modelMatrix, int* lodState)
+	{
+		return selectLevel(mesh, modelMatrix, lodState);
+	}
+
+	int LodSelector::select(const Model& model, const glm::mat4& modelMatrix, int* lodState)
+	{
+		return selectLevel(model, modelMatrix, lodState);
+	}
+
+	/// <summary>
+	/// Multiplicative feedback: the threshold grows quickly while over budget and relaxes slowly once well under it
+	/// </summary>
+	void LodSelector::end()
+	{
+		if (triangleBudget == 0) {
+			m_budgetScale = 1.0f;
+			return;
+		}
+		if (m_triangleCount > triangleBudget) {
+			m_budgetScale = std::min(m_budgetScale * 1.25f, 1024.0f);
+		}
+		else if (m_triangleCount < triangleBudget * 0.8f) {
+			m_budgetScale = std::max(m_budgetScale / 1.05f, 1.0f);
+		}
+	}
+
+	/// <summary>
+	/// Error on screen is the object space error scaled by the model matrix, projected at the closest point of the
+	/// bounding sphere. Levels are ordered finest first with non-decreasing error.
+	/// </summary>
+	template<typename T>
+	int LodSelector::selectLevel(const T& drawable, const glm::mat4& modelMatrix, int* lodState)
+	{
+		const int numLods = drawable.getNumLods();
+		if (numLods == 0) {
+			return 0;
+		}
+		glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((drawable.getBoundsMin() + drawable.getBoundsMax()) * 0.5f, 1.0f));
+		float scale = std::max(glm::length(glm::vec3(modelMatrix[0])), std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+		float radius = glm::length(drawable.getBoundsMax() - drawable.getBoundsMin()) * 0.5f * scale;
+
+		float pixelsPerUnit = m_projectionScale * scale;
+		if (!m_orthographic) {
+			pixelsPerUnit /= std::max(glm::length(center - m_cameraPosition) - radius, m_nearPlane);
+		}
+		const float threshold = pixelError * m_budgetScale;
+		auto screenError = [&](int lod) { return drawable.getLodError(lod) * pixelsPerUnit; };
+
+		int level = 0;
+		if (*lodState < 0) {
+			while (level + 1 < numLods && screenError(level + 1) <= threshold) {
+				level++;
+			}
+		}
+		else {
+			level = std::min(*lodState, numLods - 1);
+			while (level > 0 && screenError(level) > threshold * (1.0f + hysteresis)) {
+				level--;
+			}
+			while (level + 1 < numLods && screenError(level + 1) <= threshold * (1.0f - hysteresis)) {
+				level++;
+			}
+		}
+		//Hard cap for the frames before the feedback catches up
+		if (triangleBudget > 0) {
+			while (level + 1 < numLods && m_triangleCount + drawable.getLodTriangleCount(level) > triangleBudget) {
+				level++;
+			}
+		}
+
+		*lodState = level;
+		m_triangleCount += drawable.getLodTriangleCount(level);
+		return level;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "camera.h"
+#include "mesh.h"
+#include "model.h"
+
+namespace ew {
+	/// <summary>
+	/// Picks a level of detail per draw from the projected size of its simplification error. Call begin() once per
+	/// view per frame, select() for each draw, then end(). Each draw keeps a lodState int between frames for hysteresis.
+	/// </summary>
+	class LodSelector {
+	public:
+		float pixelError = 1.0f; //Largest allowed error on screen, in pixels
+		float hysteresis = 0.25f; //Coarsen below pixelError * (1 - hysteresis), refine above pixelError * (1 + hysteresis)
+		unsigned int triangleBudget = 0; //Triangles per frame, 0 for unlimited
+
+		void begin(const Camera& camera, float viewportHeight);
+		//lodState starts at -1 and is updated with the returned level
+		int select(const Mesh& mesh, const glm::mat4& modelMatrix, int* lodState);
+		int select(const Model& model, const glm::mat4& modelMatrix, int* lodState);
+		//Adjusts the error scale used next frame to stay within triangleBudget
+		void end();
+		//Triangles selected since begin()
+		inline unsigned int getTriangleCount()const { return m_triangleCount; }
+		//Multiplier on pixelError from the triangle budget, 1 when under budget
+		inline float getBudgetScale()const { return m_budgetScale; }
+	private:
+		template<typename T>
+		int selectLevel(const T& drawable, const glm::mat4& modelMatrix, int* lodState);
+
+		glm::vec3 m_cameraPosition = glm::vec3(0);
+		float m_nearPlane = 0.0f;
+		bool m_orthographic = false;
+		float m_projectionScale = 1.0f; //Pixels per world unit at distance 1 (perspective) or any distance (orthographic)
+		float m_budgetScale = 1.0f;
+		unsigned int m_triangleCount = 0;
+	};
+}
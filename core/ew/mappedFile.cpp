@@ -0,0 +1,90 @@
+#include "mappedFile.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ew {
+	MappedFile::MappedFile(const std::string& filePath)
+	{
+		open(filePath);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const std::string& filePath)
+	{
+		close();
+#ifdef _WIN32
+		m_file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (m_file == INVALID_HANDLE_VALUE) {
+			m_file = nullptr;
+			printf("Failed to open %s\n", filePath.c_str());
+			return false;
+		}
+		LARGE_INTEGER size;
+		GetFileSizeEx(m_file, &size);
+		m_size = (size_t)size.QuadPart;
+		m_mapping = m_size > 0 ? CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+		if (m_mapping != NULL) {
+			m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+		}
+#else
+		int file = ::open(filePath.c_str(), O_RDONLY);
+		if (file < 0) {
+			printf("Failed to open %s\n", filePath.c_str());
+			return false;
+		}
+		struct stat info;
+		if (fstat(file, &info) == 0 && info.st_size > 0) {
+			m_size = (size_t)info.st_size;
+			void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data != MAP_FAILED) {
+				m_data = (const unsigned char*)data;
+			}
+		}
+		//The mapping keeps its own reference to the file
+		::close(file);
+#endif
+		if (m_data == nullptr) {
+			printf("Failed to map %s\n", filePath.c_str());
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+#ifdef _WIN32
+		if (m_data != nullptr) {
+			UnmapViewOfFile(m_data);
+		}
+		if (m_mapping != nullptr) {
+			CloseHandle(m_mapping);
+		}
+		if (m_file != nullptr) {
+			CloseHandle(m_file);
+		}
+		m_mapping = nullptr;
+		m_file = nullptr;
+#else
+		if (m_data != nullptr) {
+			munmap((void*)m_data, m_size);
+		}
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+}
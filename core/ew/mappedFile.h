@@ -0,0 +1,31 @@
+#pragma once
+#include <stddef.h>
+#include <string>
+
+namespace ew {
+	/// <summary>
+	/// Read only memory mapping of a whole file. Pages are loaded by the OS on first touch instead of copied up front.
+	/// </summary>
+	class MappedFile {
+	public:
+		MappedFile() {};
+		MappedFile(const std::string& filePath);
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		//Returns false and prints an error if the file can't be mapped. Empty files can't be mapped.
+		bool open(const std::string& filePath);
+		void close();
+		inline bool isOpen()const { return m_data != nullptr; }
+		inline const unsigned char* getData()const { return m_data; }
+		inline size_t getSize()const { return m_size; }
+	private:
+		const unsigned char* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+}
@@ -1,70 +1,452 @@
-/*
-	Author: Eric Winebrenner
-*/
 /*
 *	Author: Eric Winebrenner
 */
 
 #include "mesh.h"
 #include "external/glad.h"
+#include <glm/packing.hpp>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
 
 namespace ew {
-	Mesh::Mesh(const MeshData& meshData)
+	//GPU layout of VertexFormat::PACKED
+	struct PackedVertex {
+		glm::vec3 pos;
+		unsigned int normal; //2x snorm16, octahedral
+		unsigned int uv; //2x half float
+	};
+
+	//GPU layout of VertexFormat::PACKED_QUANTIZED
+	struct QuantizedVertex {
+		unsigned short pos[4]; //unorm16 within the mesh bounds, w is padding
+		unsigned int normal;
+		unsigned int uv;
+	};
+
+	//Per instance attributes read by instanced shader variants: model matrix columns at locations 5-8,
+	//normal matrix columns at 9-11
+	struct InstanceData {
+		glm::mat4 model;
+		glm::mat3 normal;
+	};
+	const unsigned int INSTANCE_BINDING = 5; //Vertex buffer binding of the instance buffer in every Mesh VAO
+
+	/// <summary>
+	/// One stream buffer shared by every mesh, respecified on each upload. Created with the first mesh and
+	/// holding an identity instance so the always enabled instance attributes never read an empty buffer.
+	/// </summary>
+	static unsigned int instanceBuffer() {
+		static unsigned int buffer = 0;
+		if (buffer == 0) {
+			InstanceData identity = { glm::mat4(1.0f), glm::mat3(1.0f) };
+			glCreateBuffers(1, &buffer);
+			glNamedBufferData(buffer, sizeof(InstanceData), &identity, GL_STREAM_DRAW);
+		}
+		return buffer;
+	}
+
+	/// <summary>
+	/// Maps a unit vector onto the octahedron and unfolds it into [-1,1]^2, packed as 2x snorm16
+	/// </summary>
+	static unsigned int packOctahedralNormal(const glm::vec3& normal) {
+		float l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+		if (l1 == 0.0f) {
+			return glm::packSnorm2x16(glm::vec2(0));
+		}
+		glm::vec2 p = glm::vec2(normal.x, normal.y) / l1;
+		if (normal.z < 0.0f) {
+			//Fold the lower hemisphere over the diagonals
+			glm::vec2 folded = glm::vec2(1.0f - fabsf(p.y), 1.0f - fabsf(p.x));
+			p.x = p.x >= 0.0f ? folded.x : -folded.x;
+			p.y = p.y >= 0.0f ? folded.y : -folded.y;
+		}
+		return glm::packSnorm2x16(p);
+	}
+
+	unsigned int getVertexStride(VertexFormat format)
 	{
-		load(meshData);
+		switch (format) {
+		case VertexFormat::PACKED:
+			return sizeof(PackedVertex);
+		case VertexFormat::PACKED_QUANTIZED:
+			return sizeof(QuantizedVertex);
+		default:
+			return sizeof(Vertex);
+		}
 	}
-	void Mesh::load(const MeshData& meshData)
+
+	/// <summary>
+	/// Position, normal and UV (attributes 0-2) of each layout
+	/// </summary>
+	void getVertexAttributes(VertexFormat format, VertexAttribute attributes[3])
 	{
-		if (!m_initialized) {
-			glGenVertexArrays(1, &m_vao);
-			glBindVertexArray(m_vao);
+		if (format == VertexFormat::FLOAT) {
+			attributes[0] = { 3, GL_FLOAT, false, (unsigned int)offsetof(Vertex, pos) };
+			attributes[1] = { 3, GL_FLOAT, false, (unsigned int)offsetof(Vertex, normal) };
+			attributes[2] = { 2, GL_FLOAT, false, (unsigned int)offsetof(Vertex, uv) };
+		}
+		else if (format == VertexFormat::PACKED) {
+			attributes[0] = { 3, GL_FLOAT, false, (unsigned int)offsetof(PackedVertex, pos) };
+			attributes[1] = { 2, GL_SHORT, true, (unsigned int)offsetof(PackedVertex, normal) };
+			attributes[2] = { 2, GL_HALF_FLOAT, false, (unsigned int)offsetof(PackedVertex, uv) };
+		}
+		else {
+			attributes[0] = { 3, GL_UNSIGNED_SHORT, true, (unsigned int)offsetof(QuantizedVertex, pos) };
+			attributes[1] = { 2, GL_SHORT, true, (unsigned int)offsetof(QuantizedVertex, normal) };
+			attributes[2] = { 2, GL_HALF_FLOAT, false, (unsigned int)offsetof(QuantizedVertex, uv) };
+		}
+	}
 
-			glGenBuffers(1, &m_vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	/// <param name="boundsMin">Quantization range, usually the bounding box of the vertices</param>
+	std::vector<unsigned char> packVertices(const std::vector<Vertex>& vertices, VertexFormat format, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		std::vector<unsigned char> data(vertices.size() * getVertexStride(format));
+		packVertices(vertices.data(), vertices.size(), format, boundsMin, boundsMax, data.data());
+		return data;
+	}
+
+	/// <param name="out">Receives count * getVertexStride(format) bytes</param>
+	void packVertices(const Vertex* vertices, size_t count, VertexFormat format, const glm::vec3& boundsMin, const glm::vec3& boundsMax, unsigned char* out)
+	{
+		if (format == VertexFormat::FLOAT) {
+			if (count > 0) {
+				memcpy(out, vertices, count * sizeof(Vertex));
+			}
+		}
+		else if (format == VertexFormat::PACKED) {
+			PackedVertex* packed = (PackedVertex*)out;
+			for (size_t i = 0; i < count; i++)
+			{
+				const Vertex& v = vertices[i];
+				packed[i].pos = v.pos;
+				packed[i].normal = packOctahedralNormal(v.normal);
+				packed[i].uv = glm::packHalf2x16(v.uv);
+			}
+		}
+		else {
+			glm::vec3 scale = boundsMax - boundsMin;
+			glm::vec3 invScale = glm::vec3(
+				scale.x > 0.0f ? 1.0f / scale.x : 0.0f,
+				scale.y > 0.0f ? 1.0f / scale.y : 0.0f,
+				scale.z > 0.0f ? 1.0f / scale.z : 0.0f);
+			QuantizedVertex* packed = (QuantizedVertex*)out;
+			for (size_t i = 0; i < count; i++)
+			{
+				const Vertex& v = vertices[i];
+				glm::vec3 t = glm::clamp((v.pos - boundsMin) * invScale, 0.0f, 1.0f);
+				packed[i].pos[0] = (unsigned short)(t.x * 65535.0f + 0.5f);
+				packed[i].pos[1] = (unsigned short)(t.y * 65535.0f + 0.5f);
+				packed[i].pos[2] = (unsigned short)(t.z * 65535.0f + 0.5f);
+				packed[i].pos[3] = 0;
+				packed[i].normal = packOctahedralNormal(v.normal);
+				packed[i].uv = glm::packHalf2x16(v.uv);
+			}
+		}
+	}
+
+	Mesh::Mesh(const MeshData& meshData, VertexFormat format, MeshUsage usage)
+	{
+		load(meshData, format, usage);
+	}
 
-			glGenBuffers(1, &m_ebo);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-			//Position attribute
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
-			glEnableVertexAttribArray(0);
+	/// <summary>
+	/// Replaces a buffer with immutable storage of at least size bytes, with headroom for later growth
+	/// </summary>
+	static void allocateDynamicStorage(unsigned int* buffer, size_t* capacity, size_t size) {
+		glDeleteBuffers(1, buffer);
+		glCreateBuffers(1, buffer);
+		*capacity = std::max(size + size / 2, (size_t)256);
+		glNamedBufferStorage(*buffer, (GLsizeiptr)*capacity, NULL, GL_DYNAMIC_STORAGE_BIT);
+	}
 
-			//Normal attribute
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
-			glEnableVertexAttribArray(1);
+	/// <summary>
+	/// Uploads vertices in the requested layout. Indices are stored as 16 bit when the vertex count allows.
+	/// Dynamic meshes write into their existing storage and only reallocate when the data outgrows it.
+	/// </summary>
+	/// <param name="meshData">Vertices and triangle indices</param>
+	/// <param name="format">GPU vertex layout</param>
+	/// <param name="usage">Static meshes respecify their buffers on every load</param>
+	void Mesh::load(const MeshData& meshData, VertexFormat format, MeshUsage usage)
+	{
+		PackedMeshView view;
+		view.format = format;
+		view.boundsMin = view.boundsMax = glm::vec3(0);
+		if (meshData.vertices.size() > 0) {
+			view.boundsMin = view.boundsMax = meshData.vertices[0].pos;
+		}
+		for (size_t i = 1; i < meshData.vertices.size(); i++)
+		{
+			view.boundsMin = glm::min(view.boundsMin, meshData.vertices[i].pos);
+			view.boundsMax = glm::max(view.boundsMax, meshData.vertices[i].pos);
+		}
+		std::vector<unsigned char> packed = packVertices(meshData.vertices, format, view.boundsMin, view.boundsMax);
+		view.vertices = packed.data();
+		view.vertexCount = (unsigned int)meshData.vertices.size();
 
-			//UV attribute
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)(offsetof(Vertex, uv)));
-			glEnableVertexAttribArray(2);
+		//16 bit indices halve index fetch whenever every vertex is addressable
+		std::vector<unsigned short> shortIndices;
+		view.indices = meshData.indices.data();
+		view.indexCount = (unsigned int)meshData.indices.size();
+		view.indexSize = sizeof(unsigned int);
+		if (meshData.vertices.size() <= 65536) {
+			shortIndices.assign(meshData.indices.begin(), meshData.indices.end());
+			view.indices = shortIndices.data();
+			view.indexSize = sizeof(unsigned short);
+		}
+		view.lods = meshData.lods.data();
+		view.lodCount = (unsigned int)meshData.lods.size();
+		view.meshlets = meshData.meshlets.data();
+		view.meshletCount = (unsigned int)meshData.meshlets.size();
+		load(view, usage);
+	}
 
+	/// <summary>
+	/// Uploads data that is already in its GPU layout, such as a cooked model mapped from disk
+	/// </summary>
+	/// <param name="packed">Vertex and index blobs, copied before returning</param>
+	/// <param name="usage">Static meshes respecify their buffers on every load</param>
+	void Mesh::load(const PackedMeshView& packed, MeshUsage usage)
+	{
+		if (!m_initialized) {
+			glGenVertexArrays(1, &m_vao);
+			glCreateBuffers(1, &m_vbo);
+			glCreateBuffers(1, &m_ebo);
 			m_initialized = true;
 		}
 
+		m_format = packed.format;
+		m_vertexStride = getVertexStride(packed.format);
+		m_boundsMin = packed.boundsMin;
+		m_boundsMax = packed.boundsMax;
+		m_positionScale = glm::vec3(1);
+		m_positionOffset = glm::vec3(0);
+		if (packed.format == VertexFormat::PACKED_QUANTIZED) {
+			//Positions are stored relative to the bounding box, the shader applies pos * scale + offset
+			m_positionOffset = m_boundsMin;
+			m_positionScale = m_boundsMax - m_boundsMin;
+		}
+		m_indexSize = packed.indexSize;
+		m_indexType = packed.indexSize == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		size_t vertexBytes = (size_t)m_vertexStride * packed.vertexCount;
+		size_t indexBytes = (size_t)m_indexSize * packed.indexCount;
+
+		if (usage == MeshUsage::DYNAMIC) {
+			//Immutable storage can't be resized, so outgrowing it (or leaving static mode) takes a new buffer
+			bool grew = false;
+			if (m_usage != MeshUsage::DYNAMIC || vertexBytes > m_vertexCapacity) {
+				grew = m_usage == MeshUsage::DYNAMIC;
+				allocateDynamicStorage(&m_vbo, &m_vertexCapacity, vertexBytes);
+			}
+			if (m_usage != MeshUsage::DYNAMIC || indexBytes > m_indexCapacity) {
+				grew = grew || m_usage == MeshUsage::DYNAMIC;
+				allocateDynamicStorage(&m_ebo, &m_indexCapacity, indexBytes);
+			}
+			if (grew) {
+				m_growCount++;
+			}
+			if (vertexBytes > 0) {
+				glNamedBufferSubData(m_vbo, 0, vertexBytes, packed.vertices);
+			}
+			if (indexBytes > 0) {
+				glNamedBufferSubData(m_ebo, 0, indexBytes, packed.indices);
+			}
+		}
+		else {
+			if (m_usage == MeshUsage::DYNAMIC) {
+				//Immutable storage can't be respecified
+				glDeleteBuffers(1, &m_vbo);
+				glDeleteBuffers(1, &m_ebo);
+				glCreateBuffers(1, &m_vbo);
+				glCreateBuffers(1, &m_ebo);
+				m_vertexCapacity = m_indexCapacity = 0;
+			}
+			if (vertexBytes > 0) {
+				glNamedBufferData(m_vbo, vertexBytes, packed.vertices, GL_STATIC_DRAW);
+			}
+			if (indexBytes > 0) {
+				glNamedBufferData(m_ebo, indexBytes, packed.indices, GL_STATIC_DRAW);
+			}
+		}
+		m_usage = usage;
+		setVertexAttributes();
+
+		m_numVertices = packed.vertexCount;
+		m_numIndices = packed.indexCount;
+		m_lods.assign(packed.lods, packed.lods + packed.lodCount);
+		if (m_lods.empty()) {
+			MeshLod lod = { 0, m_numIndices, 0.0f, 0, packed.meshletCount };
+			m_lods.push_back(lod);
+		}
+		m_meshlets.assign(packed.meshlets, packed.meshlets + packed.meshletCount);
+	}
+
+	/// <summary>
+	/// Points the VAO at the current vertex, index and shared instance buffers
+	/// </summary>
+	void Mesh::setVertexAttributes()
+	{
 		glBindVertexArray(m_vao);
 		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
 
-		if (meshData.vertices.size() > 0) {
-			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * meshData.vertices.size(), meshData.vertices.data(), GL_STATIC_DRAW);
+		VertexAttribute attributes[3];
+		getVertexAttributes(m_format, attributes);
+		for (int i = 0; i < 3; i++)
+		{
+			glVertexAttribPointer(i, attributes[i].size, attributes[i].type, attributes[i].normalized, m_vertexStride, (const void*)(size_t)attributes[i].offset);
 		}
-		if (meshData.indices.size() > 0) {
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * meshData.indices.size(), meshData.indices.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+
+		//Instance attributes, one value per instance from the shared instance buffer
+		for (int i = 0; i < 4; i++)
+		{
+			glVertexAttribFormat(5 + i, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, model) + sizeof(glm::vec4) * i);
+			glVertexAttribBinding(5 + i, INSTANCE_BINDING);
+			glEnableVertexAttribArray(5 + i);
 		}
-		m_numVertices = meshData.vertices.size();
-		m_numIndices = meshData.indices.size();
+		for (int i = 0; i < 3; i++)
+		{
+			glVertexAttribFormat(9 + i, 3, GL_FLOAT, GL_FALSE, offsetof(InstanceData, normal) + sizeof(glm::vec3) * i);
+			glVertexAttribBinding(9 + i, INSTANCE_BINDING);
+			glEnableVertexAttribArray(9 + i);
+		}
+		glBindVertexBuffer(INSTANCE_BINDING, instanceBuffer(), 0, sizeof(InstanceData));
+		glVertexBindingDivisor(INSTANCE_BINDING, 1);
 
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
-	void Mesh::draw(ew::DrawMode drawMode) const
+
+	/// <summary>
+	/// Packs and uploads only the changed range with glBufferSubData. Bounds only ever grow here.
+	/// </summary>
+	/// <param name="vertices">Every vertex of the mesh, in the order they were loaded</param>
+	/// <param name="first">First changed vertex</param>
+	/// <param name="count">Number of changed vertices</param>
+	void Mesh::updateVertices(const std::vector<Vertex>& vertices, unsigned int first, unsigned int count)
+	{
+		if (!m_initialized || count == 0) {
+			return;
+		}
+		if ((size_t)first + count > m_numVertices || (size_t)first + count > vertices.size()) {
+			printf("Vertex update %u-%u is outside the mesh's %u vertices\n", first, first + count, m_numVertices);
+			return;
+		}
+		glm::vec3 rangeMin = vertices[first].pos;
+		glm::vec3 rangeMax = vertices[first].pos;
+		for (unsigned int i = first + 1; i < first + count; i++)
+		{
+			rangeMin = glm::min(rangeMin, vertices[i].pos);
+			rangeMax = glm::max(rangeMax, vertices[i].pos);
+		}
+		m_boundsMin = glm::min(m_boundsMin, rangeMin);
+		m_boundsMax = glm::max(m_boundsMax, rangeMax);
+		if (m_format == VertexFormat::PACKED_QUANTIZED) {
+			glm::vec3 boxMin = m_positionOffset;
+			glm::vec3 boxMax = m_positionOffset + m_positionScale;
+			if (glm::min(rangeMin, boxMin) != boxMin || glm::max(rangeMax, boxMax) != boxMax) {
+				//Every stored position is relative to the box, so a new box means repacking everything.
+				//Headroom keeps a deforming mesh from doing this every frame.
+				glm::vec3 extent = m_boundsMax - m_boundsMin;
+				glm::vec3 margin = glm::vec3(std::max(extent.x, std::max(extent.y, extent.z)) * 0.125f);
+				boxMin = glm::min(boxMin, m_boundsMin - margin);
+				boxMax = glm::max(boxMax, m_boundsMax + margin);
+				m_positionOffset = boxMin;
+				m_positionScale = boxMax - boxMin;
+				first = 0;
+				count = m_numVertices;
+			}
+		}
+		static std::vector<unsigned char> packed;
+		packed.resize((size_t)count * m_vertexStride);
+		packVertices(&vertices[first], count, m_format, m_positionOffset, m_positionOffset + m_positionScale, packed.data());
+		glNamedBufferSubData(m_vbo, (GLintptr)first * m_vertexStride, packed.size(), packed.data());
+	}
+
+	/// <summary>
+	/// Draws the mesh. The dequantization transform is passed as constant attributes 3 (scale) and 4 (offset),
+	/// identity for unquantized layouts, so shaders compiled with QUANTIZED_POSITIONS work with every format.
+	/// Packed normals need shaders compiled with PACKED_NORMALS.
+	/// </summary>
+	/// <param name="drawMode">Triangles or points</param>
+	/// <param name="lod">Level of detail, clamped to the coarsest level</param>
+	void Mesh::draw(ew::DrawMode drawMode, int lod) const
 	{
 		glBindVertexArray(m_vao);
+		glVertexAttrib3f(3, m_positionScale.x, m_positionScale.y, m_positionScale.z);
+		glVertexAttrib3f(4, m_positionOffset.x, m_positionOffset.y, m_positionOffset.z);
 		if (drawMode == DrawMode::TRIANGLES) {
-			glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, NULL);
+			if (m_lods.empty()) {
+				return;
+			}
+			const MeshLod& level = m_lods[glm::clamp(lod, 0, (int)m_lods.size() - 1)];
+			glDrawElements(GL_TRIANGLES, level.indexCount, m_indexType, (const void*)((size_t)level.indexOffset * m_indexSize));
 		}
 		else {
 			glDrawArrays(GL_POINTS, 0, m_numVertices);
 		}
 		
 	}
+
+	/// <summary>
+	/// Computes each normal matrix on the CPU and streams the instances into the shared instance buffer
+	/// </summary>
+	/// <param name="transforms">Model matrix of each instance</param>
+	/// <param name="count">Number of instances</param>
+	void Mesh::uploadInstances(const glm::mat4* transforms, int count)
+	{
+		static std::vector<InstanceData> instances;
+		instances.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			instances[i].model = transforms[i];
+			instances[i].normal = glm::transpose(glm::inverse(glm::mat3(transforms[i])));
+		}
+		glNamedBufferData(instanceBuffer(), sizeof(InstanceData) * count, instances.data(), GL_STREAM_DRAW);
+	}
+
+	/// <summary>
+	/// Draws count instances from the last uploadInstances with one call. Shaders need the INSTANCED variant.
+	/// </summary>
+	/// <param name="count">Number of instances, at most the number uploaded</param>
+	/// <param name="lod">Level of detail of every instance</param>
+	void Mesh::drawInstances(int count, int lod) const
+	{
+		if (m_lods.empty() || count <= 0) {
+			return;
+		}
+		glBindVertexArray(m_vao);
+		glVertexAttrib3f(3, m_positionScale.x, m_positionScale.y, m_positionScale.z);
+		glVertexAttrib3f(4, m_positionOffset.x, m_positionOffset.y, m_positionOffset.z);
+		const MeshLod& level = m_lods[glm::clamp(lod, 0, (int)m_lods.size() - 1)];
+		glDrawElementsInstanced(GL_TRIANGLES, level.indexCount, m_indexType, (const void*)((size_t)level.indexOffset * m_indexSize), count);
+	}
+
+	void Mesh::drawInstanced(const glm::mat4* transforms, int count, int lod) const
+	{
+		if (count <= 0) {
+			return;
+		}
+		uploadInstances(transforms, count);
+		drawInstances(count, lod);
+	}
+
+	/// <param name="counts">Index count of each range</param>
+	/// <param name="offsets">Byte offset of each range into the index buffer</param>
+	/// <param name="drawCount">Number of ranges</param>
+	void Mesh::multiDraw(const int* counts, const void* const* offsets, int drawCount) const
+	{
+		if (drawCount <= 0) {
+			return;
+		}
+		glBindVertexArray(m_vao);
+		glVertexAttrib3f(3, m_positionScale.x, m_positionScale.y, m_positionScale.z);
+		glVertexAttrib3f(4, m_positionOffset.x, m_positionOffset.y, m_positionOffset.z);
+		glMultiDrawElements(GL_TRIANGLES, counts, m_indexType, offsets, drawCount);
+	}
 }
\ No newline at end of file
@@ -13,9 +13,77 @@ namespace ew {
 		glm::vec2 uv;
 	};
 
+	//Range of MeshData::indices drawn for one level of detail
+	struct MeshLod {
+		unsigned int indexOffset;
+		unsigned int indexCount;
+		float error; //Largest deviation from the full mesh in object space units
+		unsigned int meshletOffset; //Range of MeshData::meshlets covering the same indices, empty until buildMeshlets
+		unsigned int meshletCount;
+	};
+
+	//Cluster of nearby triangles with bounds for culling, see buildMeshlets
+	struct Meshlet {
+		unsigned int indexOffset; //Contiguous range of MeshData::indices
+		unsigned int indexCount;
+		unsigned int vertexCount; //Unique vertices referenced
+		glm::vec3 center; //Object space bounding sphere
+		float radius;
+		glm::vec3 coneApex; //Back-facing from every point p where dot(normalize(coneApex - p), coneAxis) >= coneCutoff
+		glm::vec3 coneAxis;
+		float coneCutoff; //1 when the normals are too spread out to ever cull
+	};
+
 	struct MeshData {
 		std::vector<Vertex> vertices;
 		std::vector<unsigned int> indices;
+		std::vector<MeshLod> lods; //Finest first, all levels share the vertices. Empty means a single level using every index.
+		std::vector<Meshlet> meshlets;
+	};
+
+	//Vertex layout in GPU memory. Packed layouts need the matching shader variant, see Mesh::draw.
+	enum class VertexFormat {
+		FLOAT = 0,			//32 bytes: float position, normal and UV
+		PACKED = 1,			//20 bytes: float position, octahedral snorm16 normal, half float UV
+		PACKED_QUANTIZED = 2	//16 bytes: PACKED with unorm16 positions inside the mesh bounds
+	};
+
+	//One vertex attribute of a VertexFormat, in the terms of glVertexAttribPointer
+	struct VertexAttribute {
+		int size;
+		unsigned int type;
+		bool normalized;
+		unsigned int offset;
+	};
+
+	unsigned int getVertexStride(VertexFormat format);
+	//Position, normal and UV layout (attributes 0, 1 and 2)
+	void getVertexAttributes(VertexFormat format, VertexAttribute attributes[3]);
+	//Converts vertices to the GPU layout. PACKED_QUANTIZED positions are stored relative to boundsMin..boundsMax.
+	std::vector<unsigned char> packVertices(const std::vector<Vertex>& vertices, VertexFormat format, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	void packVertices(const Vertex* vertices, size_t count, VertexFormat format, const glm::vec3& boundsMin, const glm::vec3& boundsMax, unsigned char* out);
+
+	//How Mesh::load stores data. Dynamic meshes keep immutable buffers sized to a capacity and overwrite them in place
+	//on reload, growing only when the data no longer fits. Use for geometry that changes every frame.
+	enum class MeshUsage {
+		STATIC = 0,
+		DYNAMIC = 1
+	};
+
+	//Mesh data already in its GPU layout: vertices packed in format's layout, indices 16 or 32 bit. Nothing is owned.
+	struct PackedMeshView {
+		VertexFormat format = VertexFormat::FLOAT;
+		const void* vertices = nullptr;
+		unsigned int vertexCount = 0;
+		const void* indices = nullptr;
+		unsigned int indexCount = 0;
+		unsigned int indexSize = sizeof(unsigned int); //2 or 4 bytes
+		glm::vec3 boundsMin = glm::vec3(0); //Also the quantization range of PACKED_QUANTIZED positions
+		glm::vec3 boundsMax = glm::vec3(0);
+		const MeshLod* lods = nullptr;
+		unsigned int lodCount = 0;
+		const Meshlet* meshlets = nullptr;
+		unsigned int meshletCount = 0;
 	};
 
 	enum class DrawMode {
@@ -26,17 +94,62 @@ namespace ew {
 	class Mesh {
 	public:
 		Mesh() {};
-		Mesh(const MeshData& meshData);
-		void load(const MeshData& meshData);
-		void draw(DrawMode drawMode = DrawMode::TRIANGLES)const;
+		Mesh(const MeshData& meshData, VertexFormat format = VertexFormat::FLOAT, MeshUsage usage = MeshUsage::STATIC);
+		void load(const MeshData& meshData, VertexFormat format = VertexFormat::FLOAT, MeshUsage usage = MeshUsage::STATIC);
+		void load(const PackedMeshView& packed, MeshUsage usage = MeshUsage::STATIC);
+		//Re-uploads vertices [first, first + count) of the full vertex array without touching indices or storage.
+		//PACKED_QUANTIZED meshes repack every vertex when the range leaves the quantization box.
+		void updateVertices(const std::vector<Vertex>& vertices, unsigned int first, unsigned int count);
+		inline void updateVertices(const std::vector<Vertex>& vertices) { updateVertices(vertices, 0, (unsigned int)vertices.size()); }
+		void draw(DrawMode drawMode = DrawMode::TRIANGLES, int lod = 0)const;
+		//One draw of count instances, see uploadInstances for the attributes
+		void drawInstanced(const glm::mat4* transforms, int count, int lod = 0)const;
+		inline void drawInstanced(const std::vector<glm::mat4>& transforms, int lod = 0)const { drawInstanced(transforms.data(), (int)transforms.size(), lod); }
+		//Streams model and normal matrices into the instance buffer shared by every mesh (attributes 5-8 and 9-11)
+		static void uploadInstances(const glm::mat4* transforms, int count);
+		//Draws the first count instances of the last upload, so several meshes can share one upload
+		void drawInstances(int count, int lod = 0)const;
+		//Draws several ranges of the index buffer in one call. Offsets are in bytes, see getIndexSize.
+		void multiDraw(const int* counts, const void* const* offsets, int drawCount)const;
 		inline int getNumVertices()const { return m_numVertices; }
 		inline int getNumIndices()const { return m_numIndices; }
+		inline int getNumLods()const { return (int)m_lods.size(); }
+		inline const MeshLod& getLod(int lod)const { return m_lods[lod]; }
+		inline float getLodError(int lod)const { return m_lods[lod].error; }
+		inline unsigned int getLodTriangleCount(int lod)const { return m_lods[lod].indexCount / 3; }
+		inline const std::vector<Meshlet>& getMeshlets()const { return m_meshlets; }
+		inline unsigned int getIndexSize()const { return m_indexSize; }
+		//Object space bounding box
+		inline const glm::vec3& getBoundsMin()const { return m_boundsMin; }
+		inline const glm::vec3& getBoundsMax()const { return m_boundsMax; }
+		inline VertexFormat getVertexFormat()const { return m_format; }
+		//Bytes of vertex and index data in GPU memory
+		inline unsigned int getBufferSize()const { return m_numVertices * m_vertexStride + m_numIndices * m_indexSize; }
+		inline MeshUsage getUsage()const { return m_usage; }
+		//Times a dynamic mesh had to reallocate its buffers
+		inline unsigned int getGrowCount()const { return m_growCount; }
 	private:
+		void setVertexAttributes();
+
 		bool m_initialized = false;
 		unsigned int m_vao = 0;
 		unsigned int m_vbo = 0;
 		unsigned int m_ebo = 0;
+		MeshUsage m_usage = MeshUsage::STATIC;
+		size_t m_vertexCapacity = 0; //Bytes of immutable storage, dynamic meshes only
+		size_t m_indexCapacity = 0;
+		unsigned int m_growCount = 0;
 		unsigned int m_numVertices = 0;
 		unsigned int m_numIndices = 0;
+		VertexFormat m_format = VertexFormat::FLOAT;
+		unsigned int m_vertexStride = 0;
+		unsigned int m_indexType = 0; //GL_UNSIGNED_SHORT when every index fits, otherwise GL_UNSIGNED_INT
+		unsigned int m_indexSize = 0;
+		glm::vec3 m_positionScale = glm::vec3(1); //Dequantization transform, identity unless quantized
+		glm::vec3 m_positionOffset = glm::vec3(0);
+		glm::vec3 m_boundsMin = glm::vec3(0);
+		glm::vec3 m_boundsMax = glm::vec3(0);
+		std::vector<MeshLod> m_lods;
+		std::vector<Meshlet> m_meshlets;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,378 @@
+#include "meshOptimizer.h"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unordered_map>
+
+namespace ew {
+	struct VertexBytesHash {
+		size_t operator()(const Vertex& v) const {
+			const unsigned char* bytes = (const unsigned char*)&v;
+			size_t hash = 2166136261u;
+			for (size_t i = 0; i < sizeof(Vertex); i++)
+			{
+				hash = (hash ^ bytes[i]) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	struct VertexBytesEqual {
+		bool operator()(const Vertex& a, const Vertex& b) const {
+			return memcmp(&a, &b, sizeof(Vertex)) == 0;
+		}
+	};
+
+	/// <summary>
+	/// Reordering treats the indices as one triangle list, which would mix the LOD ranges together and leave meshlets
+	/// covering the wrong triangles. Welding and vertex fetch only renumber vertices, so they are safe either way.
+	/// </summary>
+	static bool canReorderTriangles(const MeshData& meshData, const char* operation) {
+		if (!meshData.lods.empty() || !meshData.meshlets.empty()) {
+			printf("%s skipped: the mesh already has LODs or meshlets, optimize before generateLods and buildMeshlets\n", operation);
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Importers emit one vertex per face corner. Merging exact duplicates restores sharing so the cache has something to reuse.
+	/// </summary>
+	void weldVertices(MeshData& meshData)
+	{
+		if (meshData.indices.empty()) {
+			return;
+		}
+		std::unordered_map<Vertex, unsigned int, VertexBytesHash, VertexBytesEqual> unique;
+		unique.reserve(meshData.vertices.size());
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> remap(meshData.vertices.size());
+		for (size_t i = 0; i < meshData.vertices.size(); i++)
+		{
+			auto result = unique.insert(std::make_pair(meshData.vertices[i], (unsigned int)vertices.size()));
+			if (result.second) {
+				vertices.push_back(meshData.vertices[i]);
+			}
+			remap[i] = result.first->second;
+		}
+		for (unsigned int& index : meshData.indices) {
+			index = remap[index];
+		}
+		meshData.vertices.swap(vertices);
+	}
+
+	/// <summary>
+	/// Forsyth's vertex score. Recently used vertices score higher, as do vertices with few triangles left so they
+	/// are finished off instead of leaving isolated triangles behind.
+	/// </summary>
+	static float forsythVertexScore(int cachePosition, int remainingTriangles, int cacheSize) {
+		if (remainingTriangles == 0) {
+			return -1.0f;
+		}
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			//The last triangle's vertices get a fixed score so the next pick isn't biased toward reusing the same edge
+			if (cachePosition < 3) {
+				score = 0.75f;
+			}
+			else {
+				score = powf(1.0f - (float)(cachePosition - 3) / (cacheSize - 3), 1.5f);
+			}
+		}
+		return score + 2.0f * powf((float)remainingTriangles, -0.5f);
+	}
+
+	/// <summary>
+	/// Greedily emits the triangle with the best summed vertex score, simulating an LRU cache of cacheSize entries.
+	/// Only triangles touching the cache are rescored each step, so the cost is linear in triangle count.
+	/// </summary>
+	void optimizeVertexCache(MeshData& meshData, int cacheSize)
+	{
+		if (!canReorderTriangles(meshData, "optimizeVertexCache")) {
+			return;
+		}
+		const size_t numTriangles = meshData.indices.size() / 3;
+		const size_t numVertices = meshData.vertices.size();
+		if (numTriangles == 0 || cacheSize <= 3) {
+			return;
+		}
+		const std::vector<unsigned int>& indices = meshData.indices;
+
+		//Triangles using each vertex, the first remaining[v] entries are the ones not emitted yet
+		std::vector<int> remaining(numVertices, 0);
+		for (unsigned int index : indices) {
+			remaining[index]++;
+		}
+		std::vector<unsigned int> adjacencyOffset(numVertices + 1, 0);
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+		}
+		std::vector<unsigned int> adjacency(indices.size());
+		std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+		}
+
+		std::vector<int> cachePosition(numVertices, -1);
+		std::vector<float> vertexScore(numVertices);
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			vertexScore[v] = forsythVertexScore(-1, remaining[v], cacheSize);
+		}
+		std::vector<bool> emitted(numTriangles, false);
+		int best = 0;
+		float bestScore = -1.0f;
+		for (size_t t = 0; t < numTriangles; t++)
+		{
+			float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+			if (score > bestScore) {
+				bestScore = score;
+				best = (int)t;
+			}
+		}
+
+		std::vector<unsigned int> cache;
+		std::vector<unsigned int> newCache;
+		cache.reserve(cacheSize + 3);
+		newCache.reserve(cacheSize + 3);
+		std::vector<unsigned int> newIndices;
+		newIndices.reserve(indices.size());
+		size_t scanCursor = 0;
+
+		for (size_t count = 0; count < numTriangles; count++)
+		{
+			//Nothing in the cache has triangles left, continue with the next unemitted triangle
+			if (best < 0) {
+				while (emitted[scanCursor]) {
+					scanCursor++;
+				}
+				best = (int)scanCursor;
+			}
+			const unsigned int* triangle = &indices[best * 3];
+			emitted[best] = true;
+			newIndices.insert(newIndices.end(), triangle, triangle + 3);
+
+			for (int i = 0; i < 3; i++)
+			{
+				unsigned int v = triangle[i];
+				unsigned int* live = &adjacency[adjacencyOffset[v]];
+				int last = --remaining[v];
+				for (int j = 0; j <= last; j++)
+				{
+					if (live[j] == (unsigned int)best) {
+						std::swap(live[j], live[last]);
+						break;
+					}
+				}
+			}
+
+			//Move the triangle's vertices to the front of the LRU
+			newCache.assign(triangle, triangle + 3);
+			for (unsigned int v : cache) {
+				if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+					newCache.push_back(v);
+				}
+			}
+			for (size_t i = 0; i < newCache.size(); i++)
+			{
+				unsigned int v = newCache[i];
+				cachePosition[v] = i < (size_t)cacheSize ? (int)i : -1;
+				vertexScore[v] = forsythVertexScore(cachePosition[v], remaining[v], cacheSize);
+			}
+
+			//Rescore triangles around every vertex whose score changed, evicted ones included
+			best = -1;
+			bestScore = -1.0f;
+			for (unsigned int v : newCache) {
+				const unsigned int* live = &adjacency[adjacencyOffset[v]];
+				for (int j = 0; j < remaining[v]; j++)
+				{
+					unsigned int t = live[j];
+					float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+					if (score > bestScore) {
+						bestScore = score;
+						best = (int)t;
+					}
+				}
+			}
+			if (newCache.size() > (size_t)cacheSize) {
+				newCache.resize(cacheSize);
+			}
+			cache.swap(newCache);
+		}
+		meshData.indices.swap(newIndices);
+	}
+
+	/// <summary>
+	/// Simulates a FIFO cache over triangles [start, end) and returns the miss count. stamps/time carry the cache
+	/// state between calls, advancing time by cacheSize flushes it.
+	/// </summary>
+	static unsigned int simulateFifo(const std::vector<unsigned int>& indices, size_t start, size_t end, int cacheSize, std::vector<unsigned int>& stamps, unsigned int& time) {
+		unsigned int misses = 0;
+		for (size_t i = start * 3; i < end * 3; i++)
+		{
+			unsigned int v = indices[i];
+			if (stamps[v] + cacheSize < time) {
+				stamps[v] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	/// <summary>
+	/// Splits the cache optimized order into clusters and sorts them by how much they face away from the mesh center
+	/// (Sander et al. 2007). Clusters start where every vertex misses the cache, so reordering them costs little
+	/// vertex reuse, and are split further while their ACMR stays within threshold of the unsplit cluster.
+	/// </summary>
+	void optimizeOverdraw(MeshData& meshData, float threshold)
+	{
+		if (!canReorderTriangles(meshData, "optimizeOverdraw")) {
+			return;
+		}
+		const size_t numTriangles = meshData.indices.size() / 3;
+		if (numTriangles < 2) {
+			return;
+		}
+		const std::vector<unsigned int>& indices = meshData.indices;
+		const int cacheSize = 16;
+		std::vector<unsigned int> stamps(meshData.vertices.size(), 0);
+		unsigned int time = cacheSize + 1;
+
+		//Hard boundaries, the cache would be cold here anyway
+		std::vector<size_t> hardStarts;
+		for (size_t t = 0; t < numTriangles; t++)
+		{
+			if (simulateFifo(indices, t, t + 1, cacheSize, stamps, time) == 3) {
+				hardStarts.push_back(t);
+			}
+		}
+		hardStarts.push_back(numTriangles);
+
+		//Soft boundaries inside each hard cluster
+		std::vector<size_t> clusterStarts;
+		for (size_t c = 0; c + 1 < hardStarts.size(); c++)
+		{
+			size_t start = hardStarts[c];
+			size_t end = hardStarts[c + 1];
+			time += cacheSize + 1;
+			float clusterAcmr = (float)simulateFifo(indices, start, end, cacheSize, stamps, time) / (end - start);
+
+			time += cacheSize + 1;
+			clusterStarts.push_back(start);
+			size_t segmentStart = start;
+			unsigned int segmentMisses = 0;
+			for (size_t t = start; t < end - 1; t++)
+			{
+				segmentMisses += simulateFifo(indices, t, t + 1, cacheSize, stamps, time);
+				if (segmentMisses <= clusterAcmr * threshold * (t - segmentStart + 1)) {
+					clusterStarts.push_back(t + 1);
+					segmentStart = t + 1;
+					segmentMisses = 0;
+					time += cacheSize + 1;
+				}
+			}
+		}
+		clusterStarts.push_back(numTriangles);
+
+		//Area weighted centroids and normals
+		glm::vec3 meshCentroid = glm::vec3(0);
+		float meshArea = 0.0f;
+		const size_t numClusters = clusterStarts.size() - 1;
+		std::vector<glm::vec3> clusterCentroids(numClusters, glm::vec3(0));
+		std::vector<glm::vec3> clusterNormals(numClusters, glm::vec3(0));
+		for (size_t c = 0; c < numClusters; c++)
+		{
+			float clusterArea = 0.0f;
+			for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+			{
+				const glm::vec3& a = meshData.vertices[indices[t * 3]].pos;
+				const glm::vec3& b = meshData.vertices[indices[t * 3 + 1]].pos;
+				const glm::vec3& d = meshData.vertices[indices[t * 3 + 2]].pos;
+				glm::vec3 normal = glm::cross(b - a, d - a);
+				float area = glm::length(normal);
+				clusterCentroids[c] += (a + b + d) * (area / 3.0f);
+				clusterNormals[c] += normal;
+				clusterArea += area;
+			}
+			meshCentroid += clusterCentroids[c];
+			meshArea += clusterArea;
+			clusterCentroids[c] = clusterArea > 0.0f ? clusterCentroids[c] / clusterArea : glm::vec3(0);
+		}
+		meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0);
+
+		std::vector<float> sortKey(numClusters, 0.0f);
+		for (size_t c = 0; c < numClusters; c++)
+		{
+			float normalLength = glm::length(clusterNormals[c]);
+			if (normalLength > 0.0f) {
+				sortKey[c] = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / normalLength);
+			}
+		}
+		std::vector<size_t> order(numClusters);
+		for (size_t c = 0; c < numClusters; c++)
+		{
+			order[c] = c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) {
+			return sortKey[a] > sortKey[b];
+		});
+
+		std::vector<unsigned int> newIndices;
+		newIndices.reserve(indices.size());
+		for (size_t c : order) {
+			newIndices.insert(newIndices.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+		}
+		meshData.indices.swap(newIndices);
+	}
+
+	void optimizeVertexFetch(MeshData& meshData)
+	{
+		if (meshData.indices.empty()) {
+			return;
+		}
+		const unsigned int UNUSED = 0xFFFFFFFF;
+		std::vector<unsigned int> remap(meshData.vertices.size(), UNUSED);
+		std::vector<Vertex> vertices;
+		vertices.reserve(meshData.vertices.size());
+		for (unsigned int& index : meshData.indices) {
+			if (remap[index] == UNUSED) {
+				remap[index] = (unsigned int)vertices.size();
+				vertices.push_back(meshData.vertices[index]);
+			}
+			index = remap[index];
+		}
+		meshData.vertices.swap(vertices);
+	}
+
+	void optimizeMesh(MeshData& meshData, bool reduceOverdraw)
+	{
+		if (!canReorderTriangles(meshData, "optimizeMesh")) {
+			return;
+		}
+		weldVertices(meshData);
+		optimizeVertexCache(meshData);
+		if (reduceOverdraw) {
+			optimizeOverdraw(meshData);
+		}
+		optimizeVertexFetch(meshData);
+	}
+
+	VertexCacheStats analyzeVertexCache(const MeshData& meshData, int cacheSize)
+	{
+		VertexCacheStats stats;
+		const size_t numTriangles = meshData.indices.size() / 3;
+		if (numTriangles == 0 || meshData.vertices.empty()) {
+			return stats;
+		}
+		std::vector<unsigned int> stamps(meshData.vertices.size(), 0);
+		unsigned int time = cacheSize + 1;
+		unsigned int misses = simulateFifo(meshData.indices, 0, numTriangles, cacheSize, stamps, time);
+		stats.acmr = (float)misses / numTriangles;
+		stats.atvr = (float)misses / meshData.vertices.size();
+		return stats;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "mesh.h"
+
+namespace ew {
+	//Post-transform cache efficiency of an index buffer, from simulating a FIFO cache
+	struct VertexCacheStats {
+		float acmr = 0.0f; //Average cache miss ratio: vertex shader invocations per triangle. ~0.5 is ideal for grids, 3 is the worst case.
+		float atvr = 0.0f; //Average transformed vertex ratio: vertex shader invocations per vertex. 1 is ideal.
+	};
+
+	//Merges bitwise identical vertices and rewrites the indices to match
+	void weldVertices(MeshData& meshData);
+	//Reorders triangles so vertices are reused while still in the post-transform cache (Forsyth's linear speed optimizer).
+	//The triangle reordering passes skip meshes that already have LODs or meshlets.
+	void optimizeVertexCache(MeshData& meshData, int cacheSize = 32);
+	//Reorders clusters of triangles so outward facing ones draw first and later fragments fail the depth test.
+	//Run after optimizeVertexCache. threshold is how much worse ACMR may get to allow smaller clusters (1.05 = 5%).
+	void optimizeOverdraw(MeshData& meshData, float threshold = 1.05f);
+	//Renumbers vertices in the order they are first used so vertex fetch walks memory sequentially. Unused vertices are dropped.
+	void optimizeVertexFetch(MeshData& meshData);
+	//Runs weld, vertex cache, optionally overdraw, then vertex fetch. Does nothing to a mesh with LODs or meshlets.
+	void optimizeMesh(MeshData& meshData, bool reduceOverdraw = true);
+	VertexCacheStats analyzeVertexCache(const MeshData& meshData, int cacheSize = 16);
+}
@@ -0,0 +1,383 @@
+#include "meshSimplifier.h"
+#include "meshOptimizer.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <unordered_map>
+
+namespace ew {
+	//Sum of squared distances to a set of planes, stored as the upper triangle of a symmetric 4x4 matrix
+	struct Quadric {
+		double a2 = 0, b2 = 0, c2 = 0, d2 = 0;
+		double ab = 0, ac = 0, ad = 0, bc = 0, bd = 0, cd = 0;
+		double weight = 0; //Face area, the error is averaged over it
+
+		void addPlane(const glm::vec3& normal, float distance, double w) {
+			double a = normal.x, b = normal.y, c = normal.z, d = distance;
+			a2 += w * a * a; b2 += w * b * b; c2 += w * c * c; d2 += w * d * d;
+			ab += w * a * b; ac += w * a * c; ad += w * a * d;
+			bc += w * b * c; bd += w * b * d; cd += w * c * d;
+		}
+		void add(const Quadric& q) {
+			a2 += q.a2; b2 += q.b2; c2 += q.c2; d2 += q.d2;
+			ab += q.ab; ac += q.ac; ad += q.ad;
+			bc += q.bc; bd += q.bd; cd += q.cd;
+			weight += q.weight;
+		}
+		//Area weighted mean squared distance of p to the planes
+		double error(const glm::vec3& p) const {
+			double x = p.x, y = p.y, z = p.z;
+			double e = a2 * x * x + b2 * y * y + c2 * z * z + d2
+				+ 2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z);
+			return weight > 0.0 ? fabs(e) / weight : 0.0;
+		}
+	};
+
+	enum class VertexKind {
+		MANIFOLD,	//Interior, can collapse onto any neighbor
+		BORDER,		//On an open edge, can only collapse along the border
+		LOCKED		//Seam or non-manifold, never moves
+	};
+
+	struct Collapse {
+		unsigned int from; //Position ids
+		unsigned int to;
+		unsigned int toVertex; //Vertex used in place of from's vertex
+		float cost;
+	};
+
+	struct PositionHash {
+		size_t operator()(const glm::vec3& p) const {
+			unsigned int bits[3];
+			memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	static unsigned long long edgeKey(unsigned int a, unsigned int b) {
+		return ((unsigned long long)a << 32) | b;
+	}
+
+	/// <summary>
+	/// Edge collapse state that can be resumed with a lower target, so a LOD chain is built in one run with quadrics
+	/// and errors accumulated against the original surface. Works on position ids so wedges that share a position
+	/// (UV or normal seams) stay together.
+	/// </summary>
+	class Simplifier {
+	public:
+		Simplifier(const MeshData& meshData);
+		//Simplifies the current indices further. Returns the largest collapse error so far.
+		float run(size_t targetIndexCount, float targetError);
+		const std::vector<unsigned int>& getIndices() const { return m_indices; }
+	private:
+		void buildAdjacency();
+		bool hasHalfEdge(unsigned int a, unsigned int b) const;
+		bool collapseFlipsTriangle(unsigned int from, unsigned int to) const;
+
+		std::vector<unsigned int> m_indices;
+		std::vector<unsigned int> m_positionId; //Per vertex
+		std::vector<glm::vec3> m_positions;
+		std::vector<VertexKind> m_kind; //Per position
+		std::vector<Quadric> m_quadrics;
+		std::vector<unsigned int> m_triPositions; //m_indices as position ids
+		std::vector<unsigned int> m_adjacencyOffset; //Triangles around each position
+		std::vector<unsigned int> m_adjacency;
+		float m_maxError = 0.0f;
+	};
+
+	Simplifier::Simplifier(const MeshData& meshData)
+	{
+		m_indices = meshData.indices;
+
+		const size_t numVertices = meshData.vertices.size();
+		m_positionId.resize(numVertices);
+		{
+			std::unordered_map<glm::vec3, unsigned int, PositionHash> ids;
+			ids.reserve(numVertices);
+			for (size_t v = 0; v < numVertices; v++)
+			{
+				auto result = ids.insert(std::make_pair(meshData.vertices[v].pos, (unsigned int)m_positions.size()));
+				if (result.second) {
+					m_positions.push_back(meshData.vertices[v].pos);
+				}
+				m_positionId[v] = result.first->second;
+			}
+		}
+		const size_t numPositions = m_positions.size();
+		m_kind.assign(numPositions, VertexKind::MANIFOLD);
+		m_quadrics.assign(numPositions, Quadric());
+
+		//Positions used by more than one referenced vertex are on a seam
+		std::vector<unsigned char> counted(numVertices, 0);
+		std::vector<unsigned int> wedgeCount(numPositions, 0);
+		for (unsigned int index : m_indices) {
+			if (!counted[index]) {
+				counted[index] = 1;
+				if (++wedgeCount[m_positionId[index]] > 1) {
+					m_kind[m_positionId[index]] = VertexKind::LOCKED;
+				}
+			}
+		}
+
+		//Half edges used more than once are non-manifold
+		std::vector<unsigned long long> halfEdges;
+		halfEdges.reserve(m_indices.size());
+		for (size_t t = 0; t < m_indices.size() / 3; t++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				halfEdges.push_back(edgeKey(m_positionId[m_indices[t * 3 + k]], m_positionId[m_indices[t * 3 + (k + 1) % 3]]));
+			}
+		}
+		std::sort(halfEdges.begin(), halfEdges.end());
+		for (size_t i = 1; i < halfEdges.size(); i++)
+		{
+			if (halfEdges[i] == halfEdges[i - 1]) {
+				m_kind[halfEdges[i] >> 32] = VertexKind::LOCKED;
+				m_kind[halfEdges[i] & 0xFFFFFFFF] = VertexKind::LOCKED;
+			}
+		}
+
+		buildAdjacency();
+		for (size_t t = 0; t < m_indices.size() / 3; t++)
+		{
+			const unsigned int* tri = &m_triPositions[t * 3];
+			glm::vec3 normal = glm::cross(m_positions[tri[1]] - m_positions[tri[0]], m_positions[tri[2]] - m_positions[tri[0]]);
+			float doubleArea = glm::length(normal);
+			if (doubleArea == 0.0f) {
+				continue;
+			}
+			normal /= doubleArea;
+			for (int k = 0; k < 3; k++)
+			{
+				m_quadrics[tri[k]].addPlane(normal, -glm::dot(normal, m_positions[tri[0]]), doubleArea * 0.5);
+				m_quadrics[tri[k]].weight += doubleArea * 0.5;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int a = tri[k];
+				unsigned int b = tri[(k + 1) % 3];
+				if (hasHalfEdge(b, a)) {
+					continue;
+				}
+				//Open edge. A plane through it, perpendicular to the face, keeps the outline in place.
+				if (m_kind[a] != VertexKind::LOCKED) m_kind[a] = VertexKind::BORDER;
+				if (m_kind[b] != VertexKind::LOCKED) m_kind[b] = VertexKind::BORDER;
+				glm::vec3 edge = m_positions[b] - m_positions[a];
+				glm::vec3 borderNormal = glm::cross(edge, normal);
+				float borderLength = glm::length(borderNormal);
+				if (borderLength > 0.0f) {
+					borderNormal /= borderLength;
+					double w = 10.0 * glm::dot(edge, edge);
+					m_quadrics[a].addPlane(borderNormal, -glm::dot(borderNormal, m_positions[a]), w);
+					m_quadrics[b].addPlane(borderNormal, -glm::dot(borderNormal, m_positions[a]), w);
+				}
+			}
+		}
+	}
+
+	void Simplifier::buildAdjacency()
+	{
+		m_triPositions.resize(m_indices.size());
+		for (size_t i = 0; i < m_indices.size(); i++)
+		{
+			m_triPositions[i] = m_positionId[m_indices[i]];
+		}
+		m_adjacencyOffset.assign(m_positions.size() + 1, 0);
+		for (unsigned int p : m_triPositions) {
+			m_adjacencyOffset[p + 1]++;
+		}
+		for (size_t p = 0; p < m_positions.size(); p++)
+		{
+			m_adjacencyOffset[p + 1] += m_adjacencyOffset[p];
+		}
+		m_adjacency.resize(m_triPositions.size());
+		std::vector<unsigned int> fill(m_adjacencyOffset.begin(), m_adjacencyOffset.end() - 1);
+		for (size_t i = 0; i < m_triPositions.size(); i++)
+		{
+			m_adjacency[fill[m_triPositions[i]]++] = (unsigned int)(i / 3);
+		}
+	}
+
+	bool Simplifier::hasHalfEdge(unsigned int a, unsigned int b) const
+	{
+		for (unsigned int i = m_adjacencyOffset[a]; i < m_adjacencyOffset[a + 1]; i++)
+		{
+			const unsigned int* tri = &m_triPositions[m_adjacency[i] * 3];
+			if ((tri[0] == a && tri[1] == b) || (tri[1] == a && tri[2] == b) || (tri[2] == a && tri[0] == b)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// True if moving position from onto position to turns any remaining triangle around it over
+	/// </summary>
+	bool Simplifier::collapseFlipsTriangle(unsigned int from, unsigned int to) const
+	{
+		for (unsigned int i = m_adjacencyOffset[from]; i < m_adjacencyOffset[from + 1]; i++)
+		{
+			const unsigned int* tri = &m_triPositions[m_adjacency[i] * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to) {
+				continue; //Removed by the collapse
+			}
+			glm::vec3 p[3];
+			glm::vec3 q[3];
+			for (int k = 0; k < 3; k++)
+			{
+				p[k] = m_positions[tri[k]];
+				q[k] = tri[k] == from ? m_positions[to] : p[k];
+			}
+			glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+			if (glm::dot(before, after) <= 0.0f) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// Each pass sorts every allowed collapse by error and applies the cheapest ones that don't share a position
+	/// </summary>
+	float Simplifier::run(size_t targetIndexCount, float targetError)
+	{
+		std::vector<Collapse> collapses;
+		std::vector<unsigned char> passLocked(m_positions.size());
+		std::vector<unsigned int> vertexRemap(m_positionId.size());
+
+		while (m_indices.size() > targetIndexCount) {
+			const size_t numTriangles = m_indices.size() / 3;
+
+			//One candidate per direction for every edge. Interior edges are seen twice, keep the a < b half.
+			collapses.clear();
+			for (size_t t = 0; t < numTriangles; t++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int va = m_indices[t * 3 + k];
+					unsigned int vb = m_indices[t * 3 + (k + 1) % 3];
+					unsigned int a = m_positionId[va];
+					unsigned int b = m_positionId[vb];
+					bool border = !hasHalfEdge(b, a);
+					if (a > b && !border) {
+						continue;
+					}
+					bool aMovable = m_kind[a] == VertexKind::MANIFOLD || (m_kind[a] == VertexKind::BORDER && border);
+					bool bMovable = m_kind[b] == VertexKind::MANIFOLD || (m_kind[b] == VertexKind::BORDER && border);
+					if (!aMovable && !bMovable) {
+						continue;
+					}
+					Quadric q = m_quadrics[a];
+					q.add(m_quadrics[b]);
+					if (aMovable) {
+						collapses.push_back({ a, b, vb, (float)sqrt(q.error(m_positions[b])) });
+					}
+					if (bMovable) {
+						collapses.push_back({ b, a, va, (float)sqrt(q.error(m_positions[a])) });
+					}
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+				return x.cost < y.cost;
+			});
+
+			//Each manifold collapse removes about two triangles, don't overshoot the target by much
+			size_t collapseLimit = (numTriangles - targetIndexCount / 3) / 2 + 1;
+			size_t applied = 0;
+			std::fill(passLocked.begin(), passLocked.end(), 0);
+			for (size_t v = 0; v < vertexRemap.size(); v++)
+			{
+				vertexRemap[v] = (unsigned int)v;
+			}
+			for (const Collapse& collapse : collapses) {
+				if (applied >= collapseLimit || collapse.cost > targetError) {
+					break;
+				}
+				if (passLocked[collapse.from] || passLocked[collapse.to] || collapseFlipsTriangle(collapse.from, collapse.to)) {
+					continue;
+				}
+				passLocked[collapse.from] = passLocked[collapse.to] = 1;
+				//Movable positions have a single wedge, every corner of it goes to the target's wedge on this side
+				for (unsigned int i = m_adjacencyOffset[collapse.from]; i < m_adjacencyOffset[collapse.from + 1]; i++)
+				{
+					unsigned int t = m_adjacency[i];
+					for (int k = 0; k < 3; k++)
+					{
+						if (m_triPositions[t * 3 + k] == collapse.from) {
+							vertexRemap[m_indices[t * 3 + k]] = collapse.toVertex;
+						}
+					}
+				}
+				m_quadrics[collapse.to].add(m_quadrics[collapse.from]);
+				m_maxError = std::max(m_maxError, collapse.cost);
+				applied++;
+			}
+			if (applied == 0) {
+				break;
+			}
+
+			//Drop triangles that became degenerate
+			size_t write = 0;
+			for (size_t t = 0; t < numTriangles; t++)
+			{
+				unsigned int v0 = vertexRemap[m_indices[t * 3]];
+				unsigned int v1 = vertexRemap[m_indices[t * 3 + 1]];
+				unsigned int v2 = vertexRemap[m_indices[t * 3 + 2]];
+				unsigned int p0 = m_positionId[v0], p1 = m_positionId[v1], p2 = m_positionId[v2];
+				if (p0 == p1 || p1 == p2 || p0 == p2) {
+					continue;
+				}
+				m_indices[write++] = v0;
+				m_indices[write++] = v1;
+				m_indices[write++] = v2;
+			}
+			m_indices.resize(write);
+			buildAdjacency();
+		}
+		return m_maxError;
+	}
+
+	std::vector<unsigned int> simplifyMesh(const MeshData& meshData, size_t targetIndexCount, float targetError, float* resultError)
+	{
+		Simplifier simplifier(meshData);
+		float error = simplifier.run(targetIndexCount, targetError);
+		if (resultError != nullptr) {
+			*resultError = error;
+		}
+		return simplifier.getIndices();
+	}
+
+	void generateLods(MeshData& meshData, int maxLods, float reduction)
+	{
+		MeshLod full = { 0, (unsigned int)meshData.indices.size(), 0.0f, 0, 0 };
+		meshData.lods.clear();
+		meshData.lods.push_back(full);
+
+		//Each level continues from the previous one, so errors are measured against the original surface
+		Simplifier simplifier(meshData);
+		MeshData level;
+		size_t previousCount = meshData.indices.size();
+		for (int i = 1; i < maxLods; i++)
+		{
+			size_t target = (size_t)(previousCount / 3 * reduction) * 3;
+			float error = simplifier.run(target, FLT_MAX);
+			level.indices = simplifier.getIndices();
+			//Stop once a level no longer removes a meaningful number of triangles
+			if (level.indices.empty() || level.indices.size() > previousCount * 0.9f) {
+				break;
+			}
+			//Only the vertex count is read, borrow the vertices instead of copying them
+			level.vertices.swap(meshData.vertices);
+			optimizeVertexCache(level);
+			level.vertices.swap(meshData.vertices);
+
+			MeshLod lod = { (unsigned int)meshData.indices.size(), (unsigned int)level.indices.size(), error, 0, 0 };
+			meshData.indices.insert(meshData.indices.end(), level.indices.begin(), level.indices.end());
+			meshData.lods.push_back(lod);
+			previousCount = level.indices.size();
+		}
+	}
+}
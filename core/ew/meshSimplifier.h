@@ -0,0 +1,13 @@
+#pragma once
+#include "mesh.h"
+
+namespace ew {
+	//Collapses edges in order of quadric error (Garland & Heckbert) until the index count reaches targetIndexCount or
+	//the next collapse would deviate more than targetError object space units. Vertices are never moved or added, so
+	//the result indexes the original vertices. Open borders only collapse along themselves and UV/normal seams are kept.
+	std::vector<unsigned int> simplifyMesh(const MeshData& meshData, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+	//Appends up to maxLods - 1 simplified levels, each with about reduction times the triangles of the previous one,
+	//and fills meshData.lods. Stops early once simplification stalls. Run after optimizeMesh.
+	void generateLods(MeshData& meshData, int maxLods, float reduction = 0.5f);
+}
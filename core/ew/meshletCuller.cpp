@@ -0,0 +1,83 @@
+#include "meshletCuller.h"
+#include <algorithm>
+
+namespace ew {
+	void MeshletCuller::begin(const Camera& camera)
+	{
+		m_frustum = Frustum(camera.projectionMatrix() * camera.viewMatrix());
+		m_cameraPosition = camera.position;
+		m_viewDirection = glm::normalize(camera.target - camera.position);
+		m_orthographic = camera.orthographic;
+		m_meshletCount = m_frustumCulledCount = m_backfaceCulledCount = 0;
+	}
+
+	/// <summary>
+	/// Spheres are tested in world space. Cones are tested in object space against the camera moved into object space,
+	/// which stays exact under non-uniform scale.
+	/// </summary>
+	void MeshletCuller::draw(const Mesh& mesh, const glm::mat4& modelMatrix, int lod)
+	{
+		const std::vector<Meshlet>& meshlets = mesh.getMeshlets();
+		if (mesh.getNumLods() == 0) {
+			return;
+		}
+		const MeshLod& level = mesh.getLod(glm::clamp(lod, 0, mesh.getNumLods() - 1));
+		if (level.meshletCount == 0) {
+			mesh.draw(DrawMode::TRIANGLES, lod);
+			return;
+		}
+		m_meshletCount += level.meshletCount;
+
+		float scale = std::max(glm::length(glm::vec3(modelMatrix[0])), std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+		if (frustumCulling) {
+			glm::vec3 boundsCenter = glm::vec3(modelMatrix * glm::vec4((mesh.getBoundsMin() + mesh.getBoundsMax()) * 0.5f, 1.0f));
+			float boundsRadius = glm::length(mesh.getBoundsMax() - mesh.getBoundsMin()) * 0.5f * scale;
+			if (m_frustum.sphereOutside(boundsCenter, boundsRadius)) {
+				m_frustumCulledCount += level.meshletCount;
+				return;
+			}
+		}
+
+		//Mirroring transforms swap which side is front, skip cone culling for them
+		bool testCones = coneCulling && glm::determinant(glm::mat3(modelMatrix)) > 0.0f;
+		glm::mat4 invModel = glm::inverse(modelMatrix);
+		glm::vec3 objectCamera = glm::vec3(invModel * glm::vec4(m_cameraPosition, 1.0f));
+		glm::vec3 objectViewDirection = glm::normalize(glm::vec3(invModel * glm::vec4(m_viewDirection, 0.0f)));
+
+		m_counts.clear();
+		m_offsets.clear();
+		const unsigned int indexSize = mesh.getIndexSize();
+		for (unsigned int i = level.meshletOffset; i < level.meshletOffset + level.meshletCount; i++)
+		{
+			const Meshlet& meshlet = meshlets[i];
+			if (frustumCulling && m_frustum.sphereOutside(glm::vec3(modelMatrix * glm::vec4(meshlet.center, 1.0f)), meshlet.radius * scale)) {
+				m_frustumCulledCount++;
+				continue;
+			}
+			if (testCones && meshlet.coneCutoff < 1.0f) {
+				glm::vec3 toApex = m_orthographic ? objectViewDirection : glm::normalize(meshlet.coneApex - objectCamera);
+				if (glm::dot(toApex, meshlet.coneAxis) >= meshlet.coneCutoff) {
+					m_backfaceCulledCount++;
+					continue;
+				}
+			}
+			//Neighboring visible meshlets are contiguous in the index buffer, merge them into one range
+			const void* offset = (const void*)((size_t)meshlet.indexOffset * indexSize);
+			if (!m_counts.empty() && (const char*)m_offsets.back() + (size_t)m_counts.back() * indexSize == offset) {
+				m_counts.back() += meshlet.indexCount;
+			}
+			else {
+				m_counts.push_back(meshlet.indexCount);
+				m_offsets.push_back(offset);
+			}
+		}
+		mesh.multiDraw(m_counts.data(), m_offsets.data(), (int)m_counts.size());
+	}
+
+	void MeshletCuller::draw(const Model& model, const glm::mat4& modelMatrix, int lod)
+	{
+		for (const Mesh& mesh : model.getMeshes()) {
+			draw(mesh, modelMatrix, lod);
+		}
+	}
+}
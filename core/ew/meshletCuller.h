@@ -0,0 +1,37 @@
+#pragma once
+#include "camera.h"
+#include "frustum.h"
+#include "mesh.h"
+#include "model.h"
+#include <vector>
+
+namespace ew {
+	/// <summary>
+	/// Drops meshlets outside the view frustum or facing away from the camera, then draws the rest of a mesh with one
+	/// glMultiDrawElements. Call begin() once per view per frame. Counters cover every draw since begin().
+	/// </summary>
+	class MeshletCuller {
+	public:
+		bool frustumCulling = true;
+		bool coneCulling = true;
+
+		void begin(const Camera& camera);
+		//Meshes without meshlets draw whole
+		void draw(const Mesh& mesh, const glm::mat4& modelMatrix, int lod = 0);
+		void draw(const Model& model, const glm::mat4& modelMatrix, int lod = 0);
+		inline unsigned int getMeshletCount()const { return m_meshletCount; }
+		inline unsigned int getFrustumCulledCount()const { return m_frustumCulledCount; }
+		inline unsigned int getBackfaceCulledCount()const { return m_backfaceCulledCount; }
+		inline unsigned int getCulledCount()const { return m_frustumCulledCount + m_backfaceCulledCount; }
+	private:
+		Frustum m_frustum;
+		glm::vec3 m_cameraPosition = glm::vec3(0);
+		glm::vec3 m_viewDirection = glm::vec3(0, 0, -1);
+		bool m_orthographic = false;
+		unsigned int m_meshletCount = 0;
+		unsigned int m_frustumCulledCount = 0;
+		unsigned int m_backfaceCulledCount = 0;
+		std::vector<int> m_counts; //Reused glMultiDrawElements arguments
+		std::vector<const void*> m_offsets;
+	};
+}
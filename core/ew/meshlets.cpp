@@ -0,0 +1,224 @@
+#include "meshlets.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+namespace ew {
+	/// <summary>
+	/// Grows clusters greedily over shared vertices, preferring triangles that add the fewest new vertices and then
+	/// those facing the same way as the cluster so far, which keeps the normal cones narrow. Triangles of one level
+	/// are written back in cluster order.
+	/// </summary>
+	static void buildLevelMeshlets(MeshData& meshData, unsigned int indexOffset, unsigned int indexCount, unsigned int maxVertices, unsigned int maxTriangles) {
+		const unsigned int* indices = &meshData.indices[indexOffset];
+		const unsigned int numTriangles = indexCount / 3;
+		const size_t numVertices = meshData.vertices.size();
+
+		//Triangles around each vertex
+		std::vector<unsigned int> adjacencyOffset(numVertices + 1, 0);
+		for (unsigned int i = 0; i < numTriangles * 3; i++)
+		{
+			adjacencyOffset[indices[i] + 1]++;
+		}
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			adjacencyOffset[v + 1] += adjacencyOffset[v];
+		}
+		std::vector<unsigned int> adjacency(numTriangles * 3);
+		{
+			std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+			for (unsigned int i = 0; i < numTriangles * 3; i++)
+			{
+				adjacency[fill[indices[i]]++] = i / 3;
+			}
+		}
+
+		std::vector<glm::vec3> triangleNormals(numTriangles);
+		for (unsigned int t = 0; t < numTriangles; t++)
+		{
+			const glm::vec3& p0 = meshData.vertices[indices[t * 3]].pos;
+			glm::vec3 normal = glm::cross(meshData.vertices[indices[t * 3 + 1]].pos - p0, meshData.vertices[indices[t * 3 + 2]].pos - p0);
+			float length = glm::length(normal);
+			triangleNormals[t] = length > 0.0f ? normal / length : glm::vec3(0);
+		}
+
+		std::vector<unsigned char> emitted(numTriangles, 0);
+		std::vector<int> vertexSlot(numVertices, -1); //Position in the current cluster's vertex list
+		std::vector<unsigned int> clusterVertices;
+		std::vector<unsigned int> clusterTriangles;
+		std::vector<unsigned int> output;
+		output.reserve(indexCount);
+		unsigned int nextSeed = 0;
+
+		while (true) {
+			while (nextSeed < numTriangles && emitted[nextSeed]) {
+				nextSeed++;
+			}
+			if (nextSeed == numTriangles) {
+				break;
+			}
+
+			glm::vec3 normalSum = glm::vec3(0);
+			unsigned int triangle = nextSeed;
+			while (true) {
+				emitted[triangle] = 1;
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int v = indices[triangle * 3 + k];
+					if (vertexSlot[v] < 0) {
+						vertexSlot[v] = (int)clusterVertices.size();
+						clusterVertices.push_back(v);
+					}
+				}
+				clusterTriangles.push_back(triangle);
+				normalSum += triangleNormals[triangle];
+				if (clusterTriangles.size() == maxTriangles) {
+					break;
+				}
+
+				//Best unemitted triangle touching the cluster
+				glm::vec3 clusterNormal = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3(0);
+				unsigned int best = ~0u;
+				int bestNewVertices = 3;
+				float bestAlignment = -FLT_MAX;
+				for (unsigned int v : clusterVertices) {
+					for (unsigned int i = adjacencyOffset[v]; i < adjacencyOffset[v + 1]; i++)
+					{
+						unsigned int t = adjacency[i];
+						if (emitted[t]) {
+							continue;
+						}
+						int newVertices = (vertexSlot[indices[t * 3]] < 0) + (vertexSlot[indices[t * 3 + 1]] < 0) + (vertexSlot[indices[t * 3 + 2]] < 0);
+						if (clusterVertices.size() + newVertices > maxVertices) {
+							continue;
+						}
+						float alignment = glm::dot(triangleNormals[t], clusterNormal);
+						if (newVertices < bestNewVertices || (newVertices == bestNewVertices && alignment > bestAlignment)) {
+							best = t;
+							bestNewVertices = newVertices;
+							bestAlignment = alignment;
+						}
+					}
+				}
+				if (best == ~0u) {
+					break;
+				}
+				triangle = best;
+			}
+
+			//Keep the incoming order within the cluster, it is already tuned for the vertex cache
+			std::sort(clusterTriangles.begin(), clusterTriangles.end());
+			Meshlet meshlet;
+			meshlet.indexOffset = indexOffset + (unsigned int)output.size();
+			meshlet.indexCount = (unsigned int)clusterTriangles.size() * 3;
+			meshlet.vertexCount = (unsigned int)clusterVertices.size();
+			meshData.meshlets.push_back(meshlet);
+			for (unsigned int t : clusterTriangles) {
+				output.insert(output.end(), indices + t * 3, indices + t * 3 + 3);
+			}
+			for (unsigned int v : clusterVertices) {
+				vertexSlot[v] = -1;
+			}
+			clusterVertices.clear();
+			clusterTriangles.clear();
+		}
+		std::copy(output.begin(), output.end(), meshData.indices.begin() + indexOffset);
+	}
+
+	void buildMeshlets(MeshData& meshData, unsigned int maxVertices, unsigned int maxTriangles)
+	{
+		meshData.meshlets.clear();
+		if (meshData.lods.empty()) {
+			MeshLod full = { 0, (unsigned int)meshData.indices.size(), 0.0f, 0, 0 };
+			meshData.lods.push_back(full);
+		}
+		maxVertices = std::max(maxVertices, 3u);
+		maxTriangles = std::max(maxTriangles, 1u);
+		for (MeshLod& lod : meshData.lods) {
+			lod.meshletOffset = (unsigned int)meshData.meshlets.size();
+			buildLevelMeshlets(meshData, lod.indexOffset, lod.indexCount, maxVertices, maxTriangles);
+			lod.meshletCount = (unsigned int)meshData.meshlets.size() - lod.meshletOffset;
+		}
+		for (Meshlet& meshlet : meshData.meshlets) {
+			Meshlet bounds = computeMeshletBounds(meshData, meshlet.indexOffset, meshlet.indexCount);
+			bounds.vertexCount = meshlet.vertexCount;
+			meshlet = bounds;
+		}
+	}
+
+	/// <summary>
+	/// The sphere is centered on the bounding box. The cone axis is the mean triangle normal and the apex is moved back
+	/// along it until every triangle plane lies in front of it, so the back-face test is conservative for any viewer.
+	/// </summary>
+	Meshlet computeMeshletBounds(const MeshData& meshData, unsigned int indexOffset, unsigned int indexCount)
+	{
+		Meshlet meshlet = Meshlet();
+		meshlet.indexOffset = indexOffset;
+		meshlet.indexCount = indexCount;
+		meshlet.coneAxis = glm::vec3(0, 0, 1);
+		meshlet.coneCutoff = 1.0f;
+		if (indexCount == 0) {
+			return meshlet;
+		}
+		const unsigned int* indices = &meshData.indices[indexOffset];
+
+		glm::vec3 boundsMin = meshData.vertices[indices[0]].pos;
+		glm::vec3 boundsMax = boundsMin;
+		for (unsigned int i = 1; i < indexCount; i++)
+		{
+			boundsMin = glm::min(boundsMin, meshData.vertices[indices[i]].pos);
+			boundsMax = glm::max(boundsMax, meshData.vertices[indices[i]].pos);
+		}
+		meshlet.center = (boundsMin + boundsMax) * 0.5f;
+		float radiusSquared = 0.0f;
+		for (unsigned int i = 0; i < indexCount; i++)
+		{
+			glm::vec3 d = meshData.vertices[indices[i]].pos - meshlet.center;
+			radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+		}
+		meshlet.radius = sqrtf(radiusSquared);
+		meshlet.coneApex = meshlet.center;
+
+		glm::vec3 normalSum = glm::vec3(0);
+		for (unsigned int i = 0; i < indexCount; i += 3)
+		{
+			const glm::vec3& p0 = meshData.vertices[indices[i]].pos;
+			glm::vec3 normal = glm::cross(meshData.vertices[indices[i + 1]].pos - p0, meshData.vertices[indices[i + 2]].pos - p0);
+			float length = glm::length(normal);
+			if (length > 0.0f) {
+				normalSum += normal / length;
+			}
+		}
+		if (glm::length(normalSum) == 0.0f) {
+			return meshlet;
+		}
+		glm::vec3 axis = glm::normalize(normalSum);
+
+		float minDot = 1.0f;
+		float maxT = 0.0f;
+		for (unsigned int i = 0; i < indexCount; i += 3)
+		{
+			const glm::vec3& p0 = meshData.vertices[indices[i]].pos;
+			glm::vec3 normal = glm::cross(meshData.vertices[indices[i + 1]].pos - p0, meshData.vertices[indices[i + 2]].pos - p0);
+			float length = glm::length(normal);
+			if (length == 0.0f) {
+				continue;
+			}
+			normal /= length;
+			float d = glm::dot(normal, axis);
+			minDot = std::min(minDot, d);
+			if (d > 0.0f) {
+				//Distance along the axis from the center back to this triangle's plane
+				maxT = std::max(maxT, glm::dot(meshlet.center - p0, normal) / d);
+			}
+		}
+		//Cones wider than ~85 degrees from the axis would almost never cull
+		if (minDot <= 0.1f) {
+			return meshlet;
+		}
+		meshlet.coneAxis = axis;
+		meshlet.coneApex = meshlet.center - axis * maxT;
+		meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+		return meshlet;
+	}
+}
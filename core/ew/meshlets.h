@@ -0,0 +1,10 @@
+#pragma once
+#include "mesh.h"
+
+namespace ew {
+	//Splits every level of detail into clusters of adjacent triangles and reorders each level's indices so clusters are
+	//contiguous. Fills meshData.meshlets and the meshlet range of each level. Run after optimizeMesh and generateLods.
+	void buildMeshlets(MeshData& meshData, unsigned int maxVertices = 64, unsigned int maxTriangles = 124);
+	//Bounding sphere and normal cone of a range of triangles
+	Meshlet computeMeshletBounds(const MeshData& meshData, unsigned int indexOffset, unsigned int indexCount);
+}
@@ -3,54 +3,244 @@
 */
 
 #include "model.h"
+#include "cookedModel.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+#include "meshlets.h"
+#include <algorithm>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
 #include <assimp/scene.h>
 #include <glm/glm.hpp>
+#include <stdio.h>
 
 namespace ew {
-	ew::Mesh processAiMesh(aiMesh* aiMesh);
+	ew::MeshData convertAiMesh(aiMesh* aiMesh);
+	ew::MeshData processAiMesh(aiMesh* aiMesh, int numLods);
 
-	Model::Model(const std::string& filePath)
+	//Shared between a Model and the jobs of its loadAsync. Only touched on the thread draining the upload queue.
+	struct ModelLoadState {
+		std::vector<ew::Mesh> meshes;
+		int pending = -1; //Meshes left to upload, -1 until the import finished
+	};
+
+	/// <summary>
+	/// .ewmesh files are mapped and uploaded as is, using the format and levels of detail they were cooked with.
+	/// Anything else is imported with Assimp.
+	/// </summary>
+	/// <param name="numLods">Levels of detail to generate per mesh, including the full mesh</param>
+	Model::Model(const std::string& filePath, VertexFormat format, int numLods)
+	{
+		const std::string cookedExtension = ".ewmesh";
+		if (filePath.size() >= cookedExtension.size() && filePath.compare(filePath.size() - cookedExtension.size(), cookedExtension.size(), cookedExtension) == 0) {
+			loadCookedModel(filePath, m_meshes);
+		}
+		else {
+			std::vector<MeshData> meshes = loadModelMeshData(filePath, numLods);
+			for (size_t i = 0; i < meshes.size(); i++)
+			{
+				m_meshes.push_back(ew::Mesh(meshes[i], format));
+			}
+		}
+		computeBounds();
+	}
+
+	/// <param name="meshes">Processed meshes, see loadModelMeshData</param>
+	Model::Model(const std::vector<MeshData>& meshes, VertexFormat format)
 	{
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			m_meshes.push_back(ew::Mesh(meshes[i], format));
+		}
+		computeBounds();
+	}
+
+	void Model::computeBounds()
+	{
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			if (i == 0) {
+				m_boundsMin = m_meshes[i].getBoundsMin();
+				m_boundsMax = m_meshes[i].getBoundsMax();
+			}
+			m_boundsMin = glm::min(m_boundsMin, m_meshes[i].getBoundsMin());
+			m_boundsMax = glm::max(m_boundsMax, m_meshes[i].getBoundsMax());
+		}
+	}
+
+	/// <summary>
+	/// Imports every mesh in the file and runs the load time processing Model applies, without uploading anything.
+	/// For placing models in a GeometryArena.
+	/// </summary>
+	/// <param name="numLods">Levels of detail to generate per mesh, including the full mesh</param>
+	std::vector<ew::MeshData> loadModelMeshData(const std::string& filePath, int numLods, WorkerPool* pool)
+	{
+		std::vector<ew::MeshData> meshes;
 		Assimp::Importer importer;
 		const aiScene* aiScene = importer.ReadFile(filePath, aiProcess_Triangulate);
-		for (size_t i = 0; i < aiScene->mNumMeshes; i++)
+		if (aiScene == nullptr) {
+			printf("Failed to load model %s: %s\n", filePath.c_str(), importer.GetErrorString());
+			return meshes;
+		}
+		//The scene is only read, so every mesh can be processed at once
+		meshes.resize(aiScene->mNumMeshes);
+		if (pool == nullptr) {
+			pool = &WorkerPool::getShared();
+		}
+		pool->parallelFor(meshes.size(), [&](size_t i) {
+			meshes[i] = processAiMesh(aiScene->mMeshes[i], numLods);
+		});
+		return meshes;
+	}
+
+	/// <summary>
+	/// Imports every mesh in the file as stored, without the vertex cache, LOD or meshlet processing of
+	/// loadModelMeshData. For measuring what that processing does.
+	/// </summary>
+	std::vector<ew::MeshData> importModelMeshData(const std::string& filePath)
+	{
+		std::vector<ew::MeshData> meshes;
+		Assimp::Importer importer;
+		const aiScene* aiScene = importer.ReadFile(filePath, aiProcess_Triangulate);
+		if (aiScene == nullptr) {
+			printf("Failed to load model %s: %s\n", filePath.c_str(), importer.GetErrorString());
+			return meshes;
+		}
+		for (unsigned int i = 0; i < aiScene->mNumMeshes; i++)
+		{
+			meshes.push_back(convertAiMesh(aiScene->mMeshes[i]));
+		}
+		return meshes;
+	}
+
+	/// <summary>
+	/// The import runs as one job, then each mesh is processed as its own job and queued for upload as soon as it
+	/// is done, so the first meshes upload while later ones are still being processed.
+	/// </summary>
+	/// <param name="pool">Runs the import and mesh processing</param>
+	/// <param name="uploads">Receives one upload per mesh, drain it on the GL thread</param>
+	void Model::loadAsync(const std::string& filePath, WorkerPool& pool, UploadQueue& uploads, VertexFormat format, int numLods)
+	{
+		std::shared_ptr<ModelLoadState> state = std::make_shared<ModelLoadState>();
+		m_loadState = state;
+		m_meshes.clear();
+		WorkerPool* poolPtr = &pool;
+		UploadQueue* uploadsPtr = &uploads;
+		pool.submit([state, filePath, poolPtr, uploadsPtr, format, numLods]() {
+			std::shared_ptr<Assimp::Importer> importer = std::make_shared<Assimp::Importer>();
+			const aiScene* aiScene = importer->ReadFile(filePath, aiProcess_Triangulate);
+			if (aiScene == nullptr) {
+				printf("Failed to load model %s: %s\n", filePath.c_str(), importer->GetErrorString());
+			}
+			unsigned int meshCount = aiScene != nullptr ? aiScene->mNumMeshes : 0;
+			//Queued before any mesh so it always runs first
+			uploadsPtr->push([state, meshCount]() {
+				state->meshes.resize(meshCount);
+				state->pending = (int)meshCount;
+			});
+			for (unsigned int i = 0; i < meshCount; i++)
+			{
+				//Each job keeps the importer, and with it the scene, alive
+				poolPtr->submit([state, importer, aiScene, i, uploadsPtr, format, numLods]() {
+					std::shared_ptr<ew::MeshData> meshData = std::make_shared<ew::MeshData>(processAiMesh(aiScene->mMeshes[i], numLods));
+					uploadsPtr->push([state, meshData, i, format]() {
+						state->meshes[i].load(*meshData, format);
+						state->pending--;
+					});
+				});
+			}
+		});
+	}
+
+	bool Model::isLoaded()
+	{
+		if (m_loadState == nullptr) {
+			return true;
+		}
+		if (m_loadState->pending != 0) {
+			return false;
+		}
+		m_meshes = std::move(m_loadState->meshes);
+		m_loadState.reset();
+		computeBounds();
+		return true;
+	}
+
+	void Model::draw(int lod)
+	{
+		if (!isLoaded()) {
+			return;
+		}
+		for (size_t i = 0; i < m_meshes.size(); i++)
 		{
-			aiMesh* aiMesh = aiScene->mMeshes[i];
-			m_meshes.push_back(processAiMesh(aiMesh));
+			m_meshes[i].draw(ew::DrawMode::TRIANGLES, lod);
 		}
 	}
 
-	void Model::draw()
+	void Model::drawInstanced(const glm::mat4* transforms, int count, int lod)
 	{
+		if (count <= 0 || !isLoaded()) {
+			return;
+		}
+		ew::Mesh::uploadInstances(transforms, count);
 		for (size_t i = 0; i < m_meshes.size(); i++)
 		{
-			m_meshes[i].draw();
+			m_meshes[i].drawInstances(count, lod);
 		}
 	}
 
+	int Model::getNumLods() const
+	{
+		int numLods = 0;
+		for (const ew::Mesh& mesh : m_meshes) {
+			numLods = std::max(numLods, mesh.getNumLods());
+		}
+		return numLods;
+	}
+
+	float Model::getLodError(int lod) const
+	{
+		float error = 0.0f;
+		for (const ew::Mesh& mesh : m_meshes) {
+			error = std::max(error, mesh.getLodError(std::min(lod, mesh.getNumLods() - 1)));
+		}
+		return error;
+	}
+
+	unsigned int Model::getLodTriangleCount(int lod) const
+	{
+		unsigned int count = 0;
+		for (const ew::Mesh& mesh : m_meshes) {
+			count += mesh.getLodTriangleCount(std::min(lod, mesh.getNumLods() - 1));
+		}
+		return count;
+	}
+
 	glm::vec3 convertAIVec3(const aiVector3D& v) {
 		return glm::vec3(v.x, v.y, v.z);
 	}
 
 	//Utility functions local to this file
-	ew::Mesh processAiMesh(aiMesh* aiMesh) {
+	ew::MeshData convertAiMesh(aiMesh* aiMesh) {
 		ew::MeshData meshData;
+		//Zeroed so missing attributes don't keep identical vertices from welding
+		meshData.vertices.resize(aiMesh->mNumVertices, ew::Vertex());
+		bool hasNormals = aiMesh->HasNormals();
+		bool hasTexCoords = aiMesh->HasTextureCoords(0);
 		for (size_t i = 0; i < aiMesh->mNumVertices; i++)
 		{
-			ew::Vertex vertex;
+			ew::Vertex& vertex = meshData.vertices[i];
 			vertex.pos = convertAIVec3(aiMesh->mVertices[i]);
-			if (aiMesh->HasNormals()) {
+			if (hasNormals) {
 				vertex.normal = convertAIVec3(aiMesh->mNormals[i]);
 			}
-			if (aiMesh->HasTextureCoords(0)) {
+			if (hasTexCoords) {
 				vertex.uv = glm::vec2(convertAIVec3(aiMesh->mTextureCoords[0][i]));
 			}
-			meshData.vertices.push_back(vertex);
 		}
-		//Convert faces to indices
+		//Convert faces to indices, triangulated so every face has 3
+		meshData.indices.reserve((size_t)aiMesh->mNumFaces * 3);
 		for (size_t i = 0; i < aiMesh->mNumFaces; i++)
 		{
 			for (size_t j = 0; j < aiMesh->mFaces[i].mNumIndices; j++)
@@ -58,7 +248,19 @@ namespace ew {
 				meshData.indices.push_back(aiMesh->mFaces[i].mIndices[j]);
 			}
 		}
-		return ew::Mesh(meshData);
+		return meshData;
+	}
+
+	ew::MeshData processAiMesh(aiMesh* aiMesh, int numLods) {
+		ew::MeshData meshData = convertAiMesh(aiMesh);
+		//Importer order is arbitrary and corners are not shared, reorder for the vertex cache before upload
+		ew::optimizeMesh(meshData);
+		if (numLods > 1) {
+			ew::generateLods(meshData, numLods);
+		}
+		//Clusters for MeshletCuller, only changes triangle order within each level
+		ew::buildMeshlets(meshData);
+		return meshData;
 	}
 
 }
@@ -5,14 +5,51 @@
 #pragma once
 #include "mesh.h"
 #include "shader.h"
+#include "uploadQueue.h"
+#include "workerPool.h"
+#include <memory>
 #include <vector>
 
 namespace ew {
+	struct ModelLoadState;
+
+	//Imported, optimized meshes with LODs and meshlets, ready for Mesh or GeometryArena::add.
+	//Meshes are processed in parallel on pool, the shared pool if null.
+	std::vector<MeshData> loadModelMeshData(const std::string& filePath, int numLods = 1, WorkerPool* pool = nullptr);
+	//Meshes exactly as imported, before any of the processing above
+	std::vector<MeshData> importModelMeshData(const std::string& filePath);
+
 	class Model {
 	public:
-		Model(const std::string& filePath);
-		void draw();
+		//Empty until a loadAsync completes
+		Model() {};
+		//filePath may be a .ewmesh file from cookModel, which ignores format and numLods
+		Model(const std::string& filePath, VertexFormat format = VertexFormat::FLOAT, int numLods = 1);
+		Model(const std::vector<MeshData>& meshes, VertexFormat format = VertexFormat::FLOAT);
+		//Imports and processes on pool workers and queues one upload per mesh on uploads. The model draws nothing
+		//until every mesh has been uploaded, see isLoaded. Cooked .ewmesh files are not supported here.
+		void loadAsync(const std::string& filePath, WorkerPool& pool, UploadQueue& uploads, VertexFormat format = VertexFormat::FLOAT, int numLods = 1);
+		//Takes ownership of the uploaded meshes once a loadAsync has finished. True when nothing is pending.
+		bool isLoaded();
+		//Meshes with fewer levels draw their coarsest one
+		void draw(int lod = 0);
+		//One instanced draw per mesh, sharing a single upload of the transforms
+		void drawInstanced(const glm::mat4* transforms, int count, int lod = 0);
+		inline void drawInstanced(const std::vector<glm::mat4>& transforms, int lod = 0) { drawInstanced(transforms.data(), (int)transforms.size(), lod); }
+		//Levels of detail of the mesh with the most levels
+		int getNumLods()const;
+		//Largest error of any mesh at this level
+		float getLodError(int lod)const;
+		unsigned int getLodTriangleCount(int lod)const;
+		inline const glm::vec3& getBoundsMin()const { return m_boundsMin; }
+		inline const glm::vec3& getBoundsMax()const { return m_boundsMax; }
+		inline const std::vector<ew::Mesh>& getMeshes()const { return m_meshes; }
 	private:
+		void computeBounds();
+
 		std::vector<ew::Mesh> m_meshes;
+		std::shared_ptr<ModelLoadState> m_loadState;
+		glm::vec3 m_boundsMin = glm::vec3(0);
+		glm::vec3 m_boundsMax = glm::vec3(0);
 	};
 }
\ No newline at end of file
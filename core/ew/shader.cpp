@@ -3,27 +3,97 @@
 */
 
 #include "shader.h"
+#include "shaderCache.h"
 #include <fstream>
-#include <sstream>
+#include <algorithm>
 #include "external/glad.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 namespace ew {
+	//Deepest #include nesting before giving up, catches files that include each other
+	static const int MAX_INCLUDE_DEPTH = 16;
+
+	static std::string loadShaderSource(const std::string& filePath, int depth) {
+		std::ifstream fstream(filePath);
+		if (!fstream.is_open()) {
+			printf("Failed to load file %s\n", filePath.c_str());
+			return {};
+		}
+		size_t slash = filePath.find_last_of("/\\");
+		std::string directory = slash == std::string::npos ? std::string() : filePath.substr(0, slash + 1);
+
+		std::string source;
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(fstream, line)) {
+			lineNumber++;
+			size_t directive = line.find_first_not_of(" \t");
+			if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0) {
+				source += line + "\n";
+				continue;
+			}
+			size_t open = line.find('"', directive + 8);
+			size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+			if (close == std::string::npos) {
+				printf("%s(%d): expected #include \"file\"\n", filePath.c_str(), lineNumber);
+				source += "\n";
+				continue;
+			}
+			if (depth >= MAX_INCLUDE_DEPTH) {
+				printf("%s(%d): #include nested deeper than %d\n", filePath.c_str(), lineNumber, MAX_INCLUDE_DEPTH);
+				source += "\n";
+				continue;
+			}
+			//#line keeps compiler errors pointing at lines of the file they came from
+			source += "#line 1\n";
+			source += loadShaderSource(directory + line.substr(open + 1, close - open - 1), depth + 1);
+			source += "#line " + std::to_string(lineNumber + 1) + "\n";
+		}
+		return source;
+	}
+
 	/// <summary>
-	/// Loads shader source code from a file.
+	/// Loads shader source code from a file. #include "file" lines are replaced with the contents of
+	/// that file, relative to the including file's directory.
 	/// </summary>
 	/// <param name="filePath"></param>
 	/// <returns></returns>
 	std::string loadShaderSourceFromFile(const std::string& filePath) {
-		std::ifstream fstream(filePath);
-		if (!fstream.is_open()) {
-			printf("Failed to load file %s", filePath.c_str());
-			return {};
+		return loadShaderSource(filePath, 0);
+	}
+
+	/// <summary>
+	/// Inserts a #define for each entry directly after the #version line. A #line directive follows
+	/// so compiler errors still report line numbers of the original file.
+	/// </summary>
+	/// <param name="source">GLSL source code</param>
+	/// <param name="defines">Defines to inject, in order</param>
+	/// <returns></returns>
+	std::string injectShaderDefines(const std::string& source, const ShaderDefines& defines) {
+		if (defines.empty()) {
+			return source;
+		}
+		std::string defineBlock;
+		for (const ShaderDefine& define : defines) {
+			defineBlock += "#define " + define.name + " " + define.value + "\n";
 		}
-		std::stringstream buffer;
-		buffer << fstream.rdbuf();
-		return buffer.str();
+
+		//#version must stay the first directive
+		size_t versionStart = source.find("#version");
+		size_t insertAt = 0;
+		if (versionStart != std::string::npos) {
+			insertAt = source.find('\n', versionStart);
+			insertAt = insertAt == std::string::npos ? source.size() : insertAt + 1;
+		}
+		int nextLine = 1 + (int)std::count(source.begin(), source.begin() + insertAt, '\n');
+		defineBlock += "#line " + std::to_string(nextLine) + "\n";
+
+		std::string result = source.substr(0, insertAt);
+		if (!result.empty() && result.back() != '\n') {
+			result += '\n';
+		}
+		return result + defineBlock + source.substr(insertAt);
 	}
 
 	/// <summary>
@@ -57,6 +127,14 @@ namespace ew {
 	/// <param name="fragmentShaderSource">GLSL source code for the fragment shader</param>
 	/// <returns></returns>
 	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource) {
+		//Skip compilation entirely if this exact program was linked by a previous run
+		const char* sources[2] = { vertexShaderSource, fragmentShaderSource };
+		std::string cacheKey = ew::shaderCacheKey(sources, 2);
+		unsigned int cachedProgram = ew::loadCachedProgram(cacheKey);
+		if (cachedProgram != 0) {
+			return cachedProgram;
+		}
+
 		unsigned int vertexShader = createShader(GL_VERTEX_SHADER, vertexShaderSource);
 		unsigned int fragmentShader = createShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
 
@@ -64,6 +142,9 @@ namespace ew {
 		//Attach each stage
 		glAttachShader(shaderProgram, vertexShader);
 		glAttachShader(shaderProgram, fragmentShader);
+		if (ew::isShaderCacheEnabled()) {
+			glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
 		//Link all the stages together
 		glLinkProgram(shaderProgram);
 		int success;
@@ -73,21 +154,182 @@ namespace ew {
 			glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
 			printf("Failed to link shader program: %s", infoLog);
 		}
+		else {
+			ew::saveCachedProgram(cacheKey, shaderProgram);
+		}
 		//The linked program now contains our compiled code, so we can delete these intermediate objects
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
 		return shaderProgram;
 	}
+
+	/// <summary>
+	/// Creates a shader program with a single compute stage
+	/// </summary>
+	/// <param name="computeShaderSource">GLSL source code for the compute shader</param>
+	/// <returns></returns>
+	unsigned int createComputeProgram(const char* computeShaderSource) {
+		std::string cacheKey = ew::shaderCacheKey(&computeShaderSource, 1);
+		unsigned int cachedProgram = ew::loadCachedProgram(cacheKey);
+		if (cachedProgram != 0) {
+			return cachedProgram;
+		}
+
+		unsigned int computeShader = createShader(GL_COMPUTE_SHADER, computeShaderSource);
+
+		unsigned int shaderProgram = glCreateProgram();
+		glAttachShader(shaderProgram, computeShader);
+		if (ew::isShaderCacheEnabled()) {
+			glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glLinkProgram(shaderProgram);
+		int success;
+		glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+		if (!success) {
+			char infoLog[512];
+			glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+			printf("Failed to link compute program: %s", infoLog);
+		}
+		else {
+			ew::saveCachedProgram(cacheKey, shaderProgram);
+		}
+		glDeleteShader(computeShader);
+		return shaderProgram;
+	}
 	/// <summary>
 	/// Creates a shader instance with vertex + fragment stages
 	/// </summary>
 	/// <param name="vertexShader">File path to vertex shader</param>
 	/// <param name="fragmentShader">File path to fragment shader</param>
-	Shader::Shader(const std::string& vertexShader, const std::string& fragmentShader)
+	/// <param name="defines">Defines injected into both stages</param>
+	Shader::Shader(const std::string& vertexShader, const std::string& fragmentShader, const ShaderDefines& defines)
 	{
-		std::string vertexShaderSource = ew::loadShaderSourceFromFile(vertexShader.c_str());
-		std::string fragmentShaderSource = ew::loadShaderSourceFromFile(fragmentShader.c_str());
+		std::string vertexShaderSource = ew::injectShaderDefines(ew::loadShaderSourceFromFile(vertexShader.c_str()), defines);
+		std::string fragmentShaderSource = ew::injectShaderDefines(ew::loadShaderSourceFromFile(fragmentShader.c_str()), defines);
 		m_id = ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		cacheUniformLocations();
+	}
+	/// <summary>
+	/// Creates a shader instance with a compute stage. Dispatch with glDispatchCompute after use()
+	/// </summary>
+	/// <param name="computeShader">File path to compute shader</param>
+	/// <param name="defines">Defines injected into the shader</param>
+	Shader::Shader(const std::string& computeShader, const ShaderDefines& defines)
+	{
+		std::string computeShaderSource = ew::injectShaderDefines(ew::loadShaderSourceFromFile(computeShader.c_str()), defines);
+		m_id = ew::createComputeProgram(computeShaderSource.c_str());
+		cacheUniformLocations();
+	}
+
+	/// <summary>
+	/// Wraps an already linked program, e.g. one finished by ew::ShaderBatch
+	/// </summary>
+	/// <param name="program">Linked program handle</param>
+	Shader::Shader(unsigned int program)
+	{
+		m_id = program;
+		cacheUniformLocations();
+	}
+
+	static unsigned int hashUniformName(const std::string& name) {
+		unsigned int hash = 2166136261u;
+		for (size_t i = 0; i < name.size(); i++)
+		{
+			hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+		}
+		return hash;
+	}
+
+	/// <summary>
+	/// Queries every active uniform once after linking so setters never ask the driver for locations.
+	/// Arrays are registered as "name", "name[0]" ... "name[N-1]", matching glGetUniformLocation.
+	/// Names whose hashes collide are marked so hash lookups return -1 rather than the wrong location.
+	/// </summary>
+	void Shader::cacheUniformLocations()
+	{
+		m_uniforms.clear();
+		int numUniforms = 0;
+		glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numUniforms);
+		int maxNameLength = 0;
+		glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+		std::vector<char> nameBuffer(maxNameLength + 1);
+		const GLenum properties[2] = { GL_LOCATION, GL_ARRAY_SIZE };
+		for (int i = 0; i < numUniforms; i++)
+		{
+			int values[2];
+			glGetProgramResourceiv(m_id, GL_UNIFORM, i, 2, properties, 2, NULL, values);
+			//Uniform block members have no location
+			if (values[0] < 0) {
+				continue;
+			}
+			glGetProgramResourceName(m_id, GL_UNIFORM, i, nameBuffer.size(), NULL, nameBuffer.data());
+			std::string name = nameBuffer.data();
+
+			size_t arrayStart = name.size() > 3 ? name.rfind("[0]") : std::string::npos;
+			if (arrayStart != std::string::npos && arrayStart == name.size() - 3) {
+				std::string baseName = name.substr(0, arrayStart);
+				m_uniforms.push_back({ hashUniformName(baseName), values[0], false, baseName });
+				for (int j = 0; j < values[1]; j++)
+				{
+					std::string elementName = baseName + "[" + std::to_string(j) + "]";
+					m_uniforms.push_back({ hashUniformName(elementName), values[0] + j, false, elementName });
+				}
+			}
+			else {
+				m_uniforms.push_back({ hashUniformName(name), values[0], false, name });
+			}
+		}
+
+		for (size_t i = 0; i < m_uniforms.size(); i++)
+		{
+			for (size_t j = i + 1; j < m_uniforms.size(); j++)
+			{
+				if (m_uniforms[i].nameHash == m_uniforms[j].nameHash) {
+					printf("Uniform name hash collision: %s and %s, setting them by hash does nothing\n", m_uniforms[i].name.c_str(), m_uniforms[j].name.c_str());
+					m_uniforms[i].collision = m_uniforms[j].collision = true;
+				}
+			}
+		}
+		std::sort(m_uniforms.begin(), m_uniforms.end(), [](const UniformEntry& a, const UniformEntry& b) {
+			return a.nameHash < b.nameHash;
+		});
+	}
+
+	const Shader::UniformEntry* Shader::findUniform(unsigned int nameHash) const
+	{
+		auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), nameHash, [](const UniformEntry& entry, unsigned int hash) {
+			return entry.nameHash < hash;
+		});
+		return it != m_uniforms.end() && it->nameHash == nameHash ? &*it : nullptr;
+	}
+
+	UniformLocation Shader::getUniformLocation(unsigned int nameHash) const
+	{
+		UniformLocation uniform;
+		const UniformEntry* entry = findUniform(nameHash);
+		//A colliding hash can't tell its uniforms apart, so it stays -1
+		if (entry && !entry->collision) {
+			uniform.location = entry->location;
+		}
+		return uniform;
+	}
+
+	UniformLocation Shader::getUniformLocation(const std::string& name) const
+	{
+		UniformLocation uniform;
+		unsigned int nameHash = hashUniformName(name);
+		//Entries sharing a hash are adjacent, the name picks between them and rejects inactive names
+		const UniformEntry* entry = findUniform(nameHash);
+		const UniformEntry* end = m_uniforms.data() + m_uniforms.size();
+		for (; entry && entry != end && entry->nameHash == nameHash; entry++)
+		{
+			if (entry->name == name) {
+				uniform.location = entry->location;
+				break;
+			}
+		}
+		return uniform;
 	}
 	void Shader::use()const
 	{
@@ -95,15 +337,15 @@ namespace ew {
 	}
 	void Shader::setInt(const std::string& name, int v) const
 	{
-		glUniform1i(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1i(getUniformLocation(name).location, v);
 	}
 	void Shader::setFloat(const std::string& name, float v) const
 	{
-		glUniform1f(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1f(getUniformLocation(name).location, v);
 	}
 	void Shader::setVec2(const std::string& name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(m_id, name.c_str()), x, y);
+		glUniform2f(getUniformLocation(name).location, x, y);
 	}
 	void Shader::setVec2(const std::string& name, const glm::vec2& v) const
 	{
@@ -111,7 +353,7 @@ namespace ew {
 	}
 	void Shader::setVec3(const std::string& name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+		glUniform3f(getUniformLocation(name).location, x, y, z);
 	}
 	void Shader::setVec3(const std::string& name, const glm::vec3& v) const
 	{
@@ -119,7 +361,7 @@ namespace ew {
 	}
 	void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 	{
-		glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+		glUniform4f(getUniformLocation(name).location, x, y, z, w);
 	}
 	void Shader::setVec4(const std::string& name, const glm::vec4& v) const
 	{
@@ -127,7 +369,31 @@ namespace ew {
 	}
 	void Shader::setMat4(const std::string& name, const glm::mat4& m) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(m));
+		glUniformMatrix4fv(getUniformLocation(name).location, 1, GL_FALSE, glm::value_ptr(m));
+	}
+	void Shader::setInt(UniformLocation uniform, int v) const
+	{
+		glUniform1i(uniform.location, v);
+	}
+	void Shader::setFloat(UniformLocation uniform, float v) const
+	{
+		glUniform1f(uniform.location, v);
+	}
+	void Shader::setVec2(UniformLocation uniform, const glm::vec2& v) const
+	{
+		glUniform2f(uniform.location, v.x, v.y);
+	}
+	void Shader::setVec3(UniformLocation uniform, const glm::vec3& v) const
+	{
+		glUniform3f(uniform.location, v.x, v.y, v.z);
+	}
+	void Shader::setVec4(UniformLocation uniform, const glm::vec4& v) const
+	{
+		glUniform4f(uniform.location, v.x, v.y, v.z, v.w);
+	}
+	void Shader::setMat4(UniformLocation uniform, const glm::mat4& m) const
+	{
+		glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(m));
 	}
 }
 
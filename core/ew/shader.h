@@ -4,15 +4,44 @@
 
 #pragma once
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
 
 namespace ew {
+	//Preprocessor define injected after #version, e.g. { "PCF_SIZE", "5" }
+	struct ShaderDefine {
+		std::string name;
+		std::string value = "1";
+	};
+	typedef std::vector<ShaderDefine> ShaderDefines;
+
 	std::string loadShaderSourceFromFile(const std::string& filePath);
 	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+	unsigned int createComputeProgram(const char* computeShaderSource);
+	std::string injectShaderDefines(const std::string& source, const ShaderDefines& defines);
+
+	/// <summary>
+	/// FNV-1a hash of a uniform name. Evaluated at compile time when assigned to a constexpr, e.g.
+	/// constexpr unsigned int MODEL = ew::uniformHash("_Model");
+	/// </summary>
+	constexpr unsigned int uniformHash(const char* name, unsigned int hash = 2166136261u) {
+		return *name ? uniformHash(name + 1, (hash ^ (unsigned char)*name) * 16777619u) : hash;
+	}
+
+	//Pre-resolved uniform location. -1 if the uniform is not active in the program.
+	struct UniformLocation {
+		int location = -1;
+	};
+
 	class Shader {
 	public:
-		Shader(const std::string& vertexShader, const std::string& fragmentShader);
+		Shader(const std::string& vertexShader, const std::string& fragmentShader, const ShaderDefines& defines = ShaderDefines());
+		explicit Shader(const std::string& computeShader, const ShaderDefines& defines = ShaderDefines());
+		explicit Shader(unsigned int program);
 		void use()const;
+		UniformLocation getUniformLocation(const std::string& name) const;
+		UniformLocation getUniformLocation(unsigned int nameHash) const;
+		inline unsigned int getId()const { return m_id; }
 		void setInt(const std::string& name, int v) const;
 		void setFloat(const std::string& name, float v) const;
 		void setVec2(const std::string& name, float x, float y) const;
@@ -22,7 +51,24 @@ namespace ew {
 		void setVec4(const std::string& name, float x, float y, float z, float w) const;
 		void setVec4(const std::string& name, const glm::vec4& v) const;
 		void setMat4(const std::string& name, const glm::mat4& m) const;
+		void setInt(UniformLocation uniform, int v) const;
+		void setFloat(UniformLocation uniform, float v) const;
+		void setVec2(UniformLocation uniform, const glm::vec2& v) const;
+		void setVec3(UniformLocation uniform, const glm::vec3& v) const;
+		void setVec4(UniformLocation uniform, const glm::vec4& v) const;
+		void setMat4(UniformLocation uniform, const glm::mat4& m) const;
 	private:
+		void cacheUniformLocations();
+
+		struct UniformEntry {
+			unsigned int nameHash;
+			int location;
+			bool collision; //Another active uniform has the same hash, looked up by name instead
+			std::string name; //Compared on string lookups so an unknown name with a matching hash misses
+		};
+		//First entry with the hash, null if no active uniform has it
+		const UniformEntry* findUniform(unsigned int nameHash) const;
 		unsigned int m_id; //Shader program handle
+		std::vector<UniformEntry> m_uniforms; //Active uniforms sorted by name hash
 	};
-}
\ No newline at end of file
+}
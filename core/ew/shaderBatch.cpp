@@ -0,0 +1,269 @@
+#include "shaderBatch.h"
+#include "shaderCache.h"
+#include "external/glad.h"
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <assert.h>
+#include <future>
+
+//GL_KHR_parallel_shader_compile, not part of the generated loader
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (*PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+namespace ew {
+	struct PendingProgram {
+		std::vector<std::string> sources;
+		std::vector<unsigned int> stages;
+		std::vector<unsigned int> shaders;
+		std::string cacheKey;
+		unsigned int program = 0;
+		bool background = false;
+		std::promise<void> compiled;
+		std::shared_future<void> compiledFuture;
+		std::unique_ptr<Shader> shader;
+	};
+
+	static bool s_parallelCompileChecked = false;
+	static bool s_parallelCompileSupported = false;
+
+	/// <summary>
+	/// Detects GL_KHR_parallel_shader_compile (or the ARB version) and asks the driver for as many compiler threads as it allows
+	/// </summary>
+	static bool initParallelCompile() {
+		if (s_parallelCompileChecked) {
+			return s_parallelCompileSupported;
+		}
+		s_parallelCompileChecked = true;
+
+		const char* maxThreadsName = NULL;
+		int numExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+		for (int i = 0; i < numExtensions; i++)
+		{
+			std::string extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (extension == "GL_KHR_parallel_shader_compile") {
+				maxThreadsName = "glMaxShaderCompilerThreadsKHR";
+				break;
+			}
+			if (extension == "GL_ARB_parallel_shader_compile") {
+				maxThreadsName = "glMaxShaderCompilerThreadsARB";
+			}
+		}
+		if (maxThreadsName == NULL) {
+			return false;
+		}
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress(maxThreadsName);
+		if (maxShaderCompilerThreads != NULL) {
+			//0xFFFFFFFF = implementation maximum
+			maxShaderCompilerThreads(0xFFFFFFFF);
+		}
+		s_parallelCompileSupported = true;
+		return true;
+	}
+
+	/// <summary>
+	/// Loads the program from the binary cache or issues compile and link. No status is queried,
+	/// so with parallel compilation the calls return before the driver is done.
+	/// </summary>
+	static void beginProgram(PendingProgram* pending) {
+		std::vector<const char*> sourcePtrs;
+		for (const std::string& source : pending->sources) {
+			sourcePtrs.push_back(source.c_str());
+		}
+		pending->cacheKey = ew::shaderCacheKey(sourcePtrs.data(), sourcePtrs.size());
+		pending->program = ew::loadCachedProgram(pending->cacheKey);
+		if (pending->program != 0) {
+			return;
+		}
+
+		pending->program = glCreateProgram();
+		for (size_t i = 0; i < sourcePtrs.size(); i++)
+		{
+			unsigned int shader = glCreateShader(pending->stages[i]);
+			glShaderSource(shader, 1, &sourcePtrs[i], NULL);
+			glCompileShader(shader);
+			glAttachShader(pending->program, shader);
+			pending->shaders.push_back(shader);
+		}
+		if (ew::isShaderCacheEnabled()) {
+			glProgramParameteri(pending->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glLinkProgram(pending->program);
+	}
+
+	/// <summary>
+	/// Checks status, prints logs and stores the binary. Blocks if the driver has not finished yet.
+	/// </summary>
+	static void endProgram(PendingProgram* pending) {
+		if (pending->shaders.empty()) {
+			return;
+		}
+		for (unsigned int shader : pending->shaders) {
+			int success;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+			if (!success) {
+				char infoLog[512];
+				glGetShaderInfoLog(shader, 512, NULL, infoLog);
+				printf("Failed to compile shader: %s", infoLog);
+			}
+		}
+		int success;
+		glGetProgramiv(pending->program, GL_LINK_STATUS, &success);
+		if (!success) {
+			char infoLog[512];
+			glGetProgramInfoLog(pending->program, 512, NULL, infoLog);
+			printf("Failed to link shader program: %s", infoLog);
+		}
+		else {
+			ew::saveCachedProgram(pending->cacheKey, pending->program);
+		}
+		for (unsigned int shader : pending->shaders) {
+			glDeleteShader(shader);
+		}
+		pending->shaders.clear();
+	}
+
+	bool ShaderFuture::isReady() const
+	{
+		if (!m_pending) {
+			return false;
+		}
+		if (m_pending->shader) {
+			return true;
+		}
+		if (m_pending->background) {
+			return m_pending->compiledFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}
+		if (!s_parallelCompileSupported) {
+			//Without the extension any status query blocks, so there is nothing to wait for here
+			return true;
+		}
+		int completed = GL_FALSE;
+		glGetProgramiv(m_pending->program, GL_COMPLETION_STATUS_KHR, &completed);
+		return completed == GL_TRUE;
+	}
+
+	const Shader& ShaderFuture::get() const
+	{
+		assert(m_pending && "ShaderFuture::get called on an empty future, assign it from ShaderBatch::add first");
+		if (!m_pending->shader) {
+			if (m_pending->background) {
+				m_pending->compiledFuture.wait();
+			}
+			else {
+				endProgram(m_pending.get());
+			}
+			m_pending->shader.reset(new Shader(m_pending->program));
+		}
+		return *m_pending->shader;
+	}
+
+	/// <param name="sharedWindow">If set, compile on a background context shared with this window's context</param>
+	ShaderBatch::ShaderBatch(GLFWwindow* sharedWindow)
+	{
+		initParallelCompile();
+		if (sharedWindow == nullptr) {
+			return;
+		}
+		//Contexts are only current on one thread at a time, so the worker gets its own invisible window
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		m_workerWindow = glfwCreateWindow(1, 1, "Shader Compiler", NULL, sharedWindow);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+		if (m_workerWindow == NULL) {
+			printf("Failed to create shader compiler context, compiling on the main thread");
+			return;
+		}
+		m_worker = std::thread(&ShaderBatch::workerLoop, this);
+	}
+
+	ShaderBatch::~ShaderBatch()
+	{
+		if (m_workerWindow == nullptr) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_condition.notify_one();
+		m_worker.join();
+		glfwDestroyWindow(m_workerWindow);
+	}
+
+	void ShaderBatch::workerLoop()
+	{
+		glfwMakeContextCurrent(m_workerWindow);
+		while (true) {
+			std::shared_ptr<PendingProgram> pending;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+				if (m_queue.empty()) {
+					break;
+				}
+				pending = m_queue.front();
+				m_queue.pop_front();
+			}
+			beginProgram(pending.get());
+			endProgram(pending.get());
+			//Shared object changes must be complete before another context uses them
+			glFinish();
+			pending->compiled.set_value();
+		}
+		glfwMakeContextCurrent(NULL);
+	}
+
+	ShaderFuture ShaderBatch::add(const std::string& vertexShader, const std::string& fragmentShader, const ShaderDefines& defines)
+	{
+		std::string vertexShaderSource = ew::injectShaderDefines(ew::loadShaderSourceFromFile(vertexShader), defines);
+		std::string fragmentShaderSource = ew::injectShaderDefines(ew::loadShaderSourceFromFile(fragmentShader), defines);
+		return submit({ vertexShaderSource, fragmentShaderSource }, { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER });
+	}
+
+	ShaderFuture ShaderBatch::add(const std::string& computeShader, const ShaderDefines& defines)
+	{
+		return submit({ ew::injectShaderDefines(ew::loadShaderSourceFromFile(computeShader), defines) }, { GL_COMPUTE_SHADER });
+	}
+
+	ShaderFuture ShaderBatch::submit(const std::vector<std::string>& sources, const std::vector<unsigned int>& stages)
+	{
+		std::shared_ptr<PendingProgram> pending = std::make_shared<PendingProgram>();
+		pending->sources = sources;
+		pending->stages = stages;
+		pending->compiledFuture = pending->compiled.get_future().share();
+
+		if (m_workerWindow != nullptr) {
+			pending->background = true;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_queue.push_back(pending);
+			}
+			m_condition.notify_one();
+		}
+		else {
+			beginProgram(pending.get());
+		}
+
+		ShaderFuture future;
+		future.m_pending = pending;
+		m_futures.push_back(future);
+		return future;
+	}
+
+	bool ShaderBatch::isReady() const
+	{
+		for (const ShaderFuture& future : m_futures) {
+			if (!future.isReady()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void ShaderBatch::wait() const
+	{
+		for (const ShaderFuture& future : m_futures) {
+			future.get();
+		}
+	}
+}
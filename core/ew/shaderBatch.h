@@ -0,0 +1,62 @@
+#pragma once
+#include "shader.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace ew {
+	struct PendingProgram;
+
+	//A shader program that may still be compiling
+	class ShaderFuture {
+	public:
+		//Empty until assigned from ShaderBatch::add
+		ShaderFuture() {};
+		//False for an empty future
+		inline bool valid() const { return m_pending != nullptr; }
+		//True once the program finished compiling. Never blocks. False for an empty future.
+		bool isReady() const;
+		//Blocks until the program is linked, then returns it. Must not be called on an empty future.
+		const Shader& get() const;
+	private:
+		friend class ShaderBatch;
+		std::shared_ptr<PendingProgram> m_pending;
+	};
+
+	/// <summary>
+	/// Submits many programs for compilation up front so they build while the application loads other assets.
+	/// Without a window, compile and link are issued on the calling thread and the driver compiles them in
+	/// parallel if it supports GL_KHR_parallel_shader_compile. With a window, programs are compiled on a
+	/// background thread with a context shared with that window, which overlaps even on drivers that compile
+	/// synchronously inside glLinkProgram (e.g. llvmpipe).
+	/// </summary>
+	class ShaderBatch {
+	public:
+		ShaderBatch(GLFWwindow* sharedWindow = nullptr);
+		~ShaderBatch();
+		ShaderBatch(const ShaderBatch&) = delete;
+		ShaderBatch& operator=(const ShaderBatch&) = delete;
+
+		ShaderFuture add(const std::string& vertexShader, const std::string& fragmentShader, const ShaderDefines& defines = ShaderDefines());
+		ShaderFuture add(const std::string& computeShader, const ShaderDefines& defines = ShaderDefines());
+		bool isReady() const;
+		void wait() const;
+	private:
+		ShaderFuture submit(const std::vector<std::string>& sources, const std::vector<unsigned int>& stages);
+		void workerLoop();
+
+		std::vector<ShaderFuture> m_futures;
+		GLFWwindow* m_workerWindow = nullptr;
+		std::thread m_worker;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::deque<std::shared_ptr<PendingProgram>> m_queue;
+		bool m_stopping = false;
+	};
+}
@@ -0,0 +1,171 @@
+#include "shaderCache.h"
+#include "external/glad.h"
+#include <stdio.h>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#else
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
+
+namespace ew {
+	static std::string s_cacheDirectory;
+
+	//Cache file layout: header followed by the driver's program binary
+	struct ProgramBinaryHeader {
+		unsigned int magic;
+		unsigned int binaryFormat;
+		unsigned int length;
+	};
+	static const unsigned int PROGRAM_BINARY_MAGIC = 0x42505745; //"EWPB"
+
+	void setShaderCacheDirectory(const std::string& directory) {
+		s_cacheDirectory = directory;
+		if (directory.empty()) {
+			return;
+		}
+		int numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		if (numFormats == 0) {
+			printf("Shader cache disabled: driver has no program binary formats");
+			s_cacheDirectory.clear();
+			return;
+		}
+#ifdef _WIN32
+		_mkdir(directory.c_str());
+#else
+		mkdir(directory.c_str(), 0755);
+#endif
+	}
+
+	bool isShaderCacheEnabled() {
+		return !s_cacheDirectory.empty();
+	}
+
+	static bool isCacheFileName(const std::string& name) {
+		return name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0;
+	}
+
+	void clearShaderCache() {
+		if (!isShaderCacheEnabled()) {
+			return;
+		}
+		std::vector<std::string> files;
+#ifdef _WIN32
+		_finddata_t entry;
+		intptr_t find = _findfirst((s_cacheDirectory + "/*.bin").c_str(), &entry);
+		if (find != -1) {
+			do {
+				files.push_back(entry.name);
+			} while (_findnext(find, &entry) == 0);
+			_findclose(find);
+		}
+#else
+		DIR* directory = opendir(s_cacheDirectory.c_str());
+		if (directory != nullptr) {
+			while (dirent* entry = readdir(directory)) {
+				files.push_back(entry->d_name);
+			}
+			closedir(directory);
+		}
+#endif
+		for (const std::string& file : files) {
+			if (isCacheFileName(file)) {
+				remove((s_cacheDirectory + "/" + file).c_str());
+			}
+		}
+	}
+
+	static void hashBytes(unsigned long long* hash, const char* data) {
+		for (const char* c = data; c != NULL && *c != '\0'; c++) {
+			*hash = (*hash ^ (unsigned char)*c) * 1099511628211ull;
+		}
+		//Separator so "ab"+"c" and "a"+"bc" differ
+		*hash = (*hash ^ 0xff) * 1099511628211ull;
+	}
+
+	std::string shaderCacheKey(const char* const* sources, int numSources) {
+		if (!isShaderCacheEnabled()) {
+			return {};
+		}
+		unsigned long long hash = 14695981039346656037ull;
+		for (int i = 0; i < numSources; i++)
+		{
+			hashBytes(&hash, sources[i]);
+		}
+		hashBytes(&hash, (const char*)glGetString(GL_VENDOR));
+		hashBytes(&hash, (const char*)glGetString(GL_RENDERER));
+		hashBytes(&hash, (const char*)glGetString(GL_VERSION));
+
+		char key[17];
+		snprintf(key, sizeof(key), "%016llx", hash);
+		return key;
+	}
+
+	static std::string cacheFilePath(const std::string& key) {
+		return s_cacheDirectory + "/" + key + ".bin";
+	}
+
+	unsigned int loadCachedProgram(const std::string& key) {
+		if (!isShaderCacheEnabled() || key.empty()) {
+			return 0;
+		}
+		FILE* file = fopen(cacheFilePath(key).c_str(), "rb");
+		if (file == NULL) {
+			return 0;
+		}
+		ProgramBinaryHeader header;
+		std::vector<char> binary;
+		bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == PROGRAM_BINARY_MAGIC;
+		if (valid) {
+			binary.resize(header.length);
+			valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+		}
+		fclose(file);
+		if (!valid) {
+			return 0;
+		}
+
+		unsigned int program = glCreateProgram();
+		glProgramBinary(program, header.binaryFormat, binary.data(), binary.size());
+		int success;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success) {
+			//Driver changed underneath us, caller recompiles from source
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	/// <summary>
+	/// Writes a linked program's binary to the cache. The program should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
+	/// </summary>
+	void saveCachedProgram(const std::string& key, unsigned int program) {
+		if (!isShaderCacheEnabled() || key.empty()) {
+			return;
+		}
+		int length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) {
+			return;
+		}
+		ProgramBinaryHeader header;
+		header.magic = PROGRAM_BINARY_MAGIC;
+		std::vector<char> binary(length);
+		GLenum binaryFormat;
+		glGetProgramBinary(program, length, NULL, &binaryFormat, binary.data());
+		header.binaryFormat = binaryFormat;
+		header.length = length;
+
+		FILE* file = fopen(cacheFilePath(key).c_str(), "wb");
+		if (file == NULL) {
+			return;
+		}
+		fwrite(&header, sizeof(header), 1, file);
+		fwrite(binary.data(), 1, binary.size(), file);
+		fclose(file);
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+namespace ew {
+	//Enables caching of linked program binaries in the given directory (created if missing). An empty path disables the cache.
+	void setShaderCacheDirectory(const std::string& directory);
+	bool isShaderCacheEnabled();
+	//Deletes every cached program binary in the current cache directory, leaving the directory itself
+	void clearShaderCache();
+	//Key for a program built from the given stage sources. Includes the GL vendor/renderer/version so driver changes miss.
+	std::string shaderCacheKey(const char* const* sources, int numSources);
+	//Returns a linked program from the cache, or 0 on a miss or if the driver rejects the binary
+	unsigned int loadCachedProgram(const std::string& key);
+	void saveCachedProgram(const std::string& key, unsigned int program);
+}
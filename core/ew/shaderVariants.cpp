@@ -0,0 +1,67 @@
+#include "shaderVariants.h"
+#include <algorithm>
+
+namespace ew {
+	/// <summary>
+	/// Defines sorted by name so the same set gives the same key regardless of order
+	/// </summary>
+	static std::string variantKey(const ShaderDefines& defines) {
+		ShaderDefines sorted = defines;
+		std::sort(sorted.begin(), sorted.end(), [](const ShaderDefine& a, const ShaderDefine& b) {
+			return a.name < b.name;
+		});
+		std::string key;
+		for (const ShaderDefine& define : sorted) {
+			key += define.name + "=" + define.value + ";";
+		}
+		return key;
+	}
+
+	/// <param name="vertexShader">File path to vertex shader</param>
+	/// <param name="fragmentShader">File path to fragment shader</param>
+	ShaderVariants::ShaderVariants(const std::string& vertexShader, const std::string& fragmentShader)
+	{
+		m_paths = { vertexShader, fragmentShader };
+		m_sources = { ew::loadShaderSourceFromFile(vertexShader), ew::loadShaderSourceFromFile(fragmentShader) };
+	}
+
+	/// <param name="computeShader">File path to compute shader</param>
+	ShaderVariants::ShaderVariants(const std::string& computeShader)
+	{
+		m_paths = { computeShader };
+		m_sources = { ew::loadShaderSourceFromFile(computeShader) };
+	}
+
+	const Shader& ShaderVariants::get(const ShaderDefines& defines)
+	{
+		Variant& variant = m_variants[variantKey(defines)];
+		if (variant.shader) {
+			return *variant.shader;
+		}
+
+		if (variant.pending) {
+			variant.shader.reset(new Shader(variant.future.get()));
+			variant.pending = false;
+		}
+		else if (m_sources.size() == 2) {
+			std::string vertexShaderSource = ew::injectShaderDefines(m_sources[0], defines);
+			std::string fragmentShaderSource = ew::injectShaderDefines(m_sources[1], defines);
+			variant.shader.reset(new Shader(ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str())));
+		}
+		else {
+			std::string computeShaderSource = ew::injectShaderDefines(m_sources[0], defines);
+			variant.shader.reset(new Shader(ew::createComputeProgram(computeShaderSource.c_str())));
+		}
+		return *variant.shader;
+	}
+
+	void ShaderVariants::prewarm(ShaderBatch& batch, const ShaderDefines& defines)
+	{
+		Variant& variant = m_variants[variantKey(defines)];
+		if (variant.shader || variant.pending) {
+			return;
+		}
+		variant.future = m_paths.size() == 2 ? batch.add(m_paths[0], m_paths[1], defines) : batch.add(m_paths[0], defines);
+		variant.pending = true;
+	}
+}
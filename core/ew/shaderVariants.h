@@ -0,0 +1,37 @@
+#pragma once
+#include "shader.h"
+#include "shaderBatch.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ew {
+	/// <summary>
+	/// Specialized programs built from one set of shader files, one per define set. Features that are constant
+	/// for a whole frame become #if blocks instead of uniform branches. Variants compile on first request.
+	/// </summary>
+	class ShaderVariants {
+	public:
+		ShaderVariants(const std::string& vertexShader, const std::string& fragmentShader);
+		ShaderVariants(const std::string& computeShader);
+		ShaderVariants(const ShaderVariants&) = delete;
+		ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+		//Compiles the variant if it does not exist yet. The reference stays valid for the lifetime of this object.
+		const Shader& get(const ShaderDefines& defines);
+		//Starts compiling a variant on the batch so the first get() does not stall
+		void prewarm(ShaderBatch& batch, const ShaderDefines& defines);
+		//Number of variants compiled or compiling
+		inline size_t count() const { return m_variants.size(); }
+	private:
+		struct Variant {
+			ShaderFuture future;
+			bool pending = false;
+			std::unique_ptr<Shader> shader;
+		};
+		std::vector<std::string> m_paths; //Vertex + fragment or compute
+		std::vector<std::string> m_sources;
+		std::map<std::string, Variant> m_variants; //Keyed by the sorted define set
+	};
+}
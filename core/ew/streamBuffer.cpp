@@ -0,0 +1,108 @@
+#include "streamBuffer.h"
+#include "external/glad.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+namespace ew {
+	static size_t alignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	/// <param name="regionSize">Bytes available to each frame</param>
+	/// <param name="regionCount">Frames the CPU may run ahead of the GPU, at most 4</param>
+	StreamBuffer::StreamBuffer(size_t regionSize, int regionCount)
+		: m_regionCount(std::min(std::max(regionCount, 1), MAX_REGIONS))
+	{
+		GLint uniformAlignment = 0;
+		GLint storageAlignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+		m_alignment = std::max((size_t)std::max(uniformAlignment, storageAlignment), (size_t)16);
+		m_regionSize = alignUp(regionSize, m_alignment);
+
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &m_buffer);
+		glNamedBufferStorage(m_buffer, (GLsizeiptr)(m_regionSize * m_regionCount), NULL, flags);
+		m_mapped = (unsigned char*)glMapNamedBufferRange(m_buffer, 0, (GLsizeiptr)(m_regionSize * m_regionCount), flags);
+		if (m_mapped == nullptr) {
+			printf("Failed to map stream buffer of %zu bytes\n", m_regionSize * m_regionCount);
+		}
+	}
+
+	StreamBuffer::~StreamBuffer()
+	{
+		for (int i = 0; i < m_regionCount; i++) {
+			if (m_fences[i] != nullptr) {
+				glDeleteSync((GLsync)m_fences[i]);
+			}
+		}
+		if (m_mapped != nullptr) {
+			glUnmapNamedBuffer(m_buffer);
+		}
+		glDeleteBuffers(1, &m_buffer);
+	}
+
+	/// <summary>
+	/// The fence is polled first so a stall is only counted when the GPU really is behind
+	/// </summary>
+	void StreamBuffer::beginFrame()
+	{
+		m_region = (m_region + 1) % m_regionCount;
+		m_head = 0;
+		GLsync fence = (GLsync)m_fences[m_region];
+		if (fence == nullptr) {
+			return;
+		}
+		GLenum status = glClientWaitSync(fence, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED) {
+			m_stallCount++;
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			do {
+				status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			} while (status == GL_TIMEOUT_EXPIRED);
+			m_stallMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+		glDeleteSync(fence);
+		m_fences[m_region] = nullptr;
+	}
+
+	void StreamBuffer::endFrame()
+	{
+		if (m_fences[m_region] != nullptr) {
+			glDeleteSync((GLsync)m_fences[m_region]);
+		}
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	/// <param name="size">Bytes to reserve</param>
+	/// <param name="alignment">Offset alignment in bytes, a power of two</param>
+	StreamSlice StreamBuffer::allocate(size_t size, size_t alignment)
+	{
+		StreamSlice slice;
+		size_t offset = alignUp(m_head, alignment == 0 ? m_alignment : alignment);
+		if (m_mapped == nullptr || offset + size > m_regionSize) {
+			//Callers fall back every frame once a region is too small, so only the first overflow is printed
+			if (m_overflowCount++ == 0) {
+				printf("Stream buffer region of %zu bytes is full, %zu more requested. Further overflows are only counted\n", m_regionSize, size);
+			}
+			return slice;
+		}
+		m_head = offset + size;
+		slice.buffer = m_buffer;
+		slice.offset = m_regionSize * m_region + offset;
+		slice.data = m_mapped + slice.offset;
+		slice.size = size;
+		return slice;
+	}
+
+	StreamSlice StreamBuffer::write(const void* data, size_t size, size_t alignment)
+	{
+		StreamSlice slice = allocate(size, alignment);
+		if (slice.data != nullptr) {
+			memcpy(slice.data, data, size);
+		}
+		return slice;
+	}
+}
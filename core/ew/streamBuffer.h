@@ -0,0 +1,57 @@
+#pragma once
+#include <stddef.h>
+
+namespace ew {
+	//Part of a StreamBuffer handed out for one frame. data is null if the frame's region was full.
+	struct StreamSlice {
+		void* data = nullptr;
+		unsigned int buffer = 0;
+		size_t offset = 0; //Bytes from the start of buffer, for glBindBufferRange or as an indirect/vertex offset
+		size_t size = 0;
+	};
+
+	/// <summary>
+	/// Persistently mapped ring of per-frame regions for data rewritten every frame (transforms, lights, uniform blocks).
+	/// Each frame bump allocates from its own region, which is fenced at endFrame and only reused once the GPU has
+	/// passed the fence, so writes never need the driver to synchronize or orphan storage.
+	/// </summary>
+	class StreamBuffer {
+	public:
+		StreamBuffer(size_t regionSize, int regionCount = 3);
+		~StreamBuffer();
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+		//Moves to the next region, waiting for the GPU if it is still reading it
+		void beginFrame();
+		//Fences everything submitted since beginFrame
+		void endFrame();
+		//Writable slice of the current region. 0 alignment uses the larger of the uniform and storage buffer offset alignments.
+		StreamSlice allocate(size_t size, size_t alignment = 0);
+		//Allocates a slice and copies data into it
+		StreamSlice write(const void* data, size_t size, size_t alignment = 0);
+
+		inline unsigned int getBuffer()const { return m_buffer; }
+		inline size_t getRegionSize()const { return m_regionSize; }
+		inline size_t getUsedBytes()const { return m_head; }
+		//Frames where beginFrame had to wait because the CPU caught up with the GPU
+		inline unsigned int getStallCount()const { return m_stallCount; }
+		inline double getStallMs()const { return m_stallMs; }
+		//Allocations refused because the frame's region was full, only the first is printed
+		inline unsigned int getOverflowCount()const { return m_overflowCount; }
+	private:
+		static const int MAX_REGIONS = 4;
+
+		unsigned int m_buffer = 0;
+		unsigned char* m_mapped = nullptr;
+		size_t m_regionSize;
+		size_t m_alignment = 256;
+		int m_regionCount;
+		int m_region = 0;
+		size_t m_head = 0;
+		void* m_fences[MAX_REGIONS] = {};
+		unsigned int m_stallCount = 0;
+		double m_stallMs = 0.0;
+		unsigned int m_overflowCount = 0;
+	};
+}
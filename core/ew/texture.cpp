@@ -3,6 +3,7 @@
 */
 
 #include "texture.h"
+#include "textureCompression.h"
 #include "external/glad.h"
 #include "external/stb_image.h"
 
@@ -23,6 +24,14 @@ namespace ew {
 		return loadTexture(filePath, GL_REPEAT, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR, true);
 	}
 	unsigned int loadTexture(const char* filePath, int wrapMode, int magFilter, int minFilter, bool mipmap) {
+		//Block compressed mips can't be generated on the GPU, the file's are used
+		if (isCompressedTexturePath(filePath)) {
+			TextureData textureData;
+			if (!loadCompressedTextureData(filePath, textureData)) {
+				return 0;
+			}
+			return createTexture(textureData, wrapMode, magFilter, minFilter);
+		}
 		int width, height, numComponents;
 		unsigned char* data = stbi_load(filePath, &width, &height, &numComponents, 0);
 		if (data == NULL) {
@@ -30,6 +39,57 @@ namespace ew {
 			stbi_image_free(data);
 			return 0;
 		}
+		unsigned int texture = createTexture(data, width, height, numComponents, wrapMode, magFilter, minFilter, mipmap);
+		stbi_image_free(data);
+		return texture;
+	}
+	/// <summary>
+	/// Every level is copied into one buffer and read from there, so the driver can schedule the transfer instead of
+	/// copying from client memory during each call. Texel formats are sized so the driver doesn't pick its own.
+	/// </summary>
+	unsigned int createTexture(const TextureData& textureData, int wrapMode, int magFilter, int minFilter) {
+		static const int linearFormats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+		int internalFormat = textureData.srgb ? GL_SRGB8_ALPHA8 : linearFormats[textureData.numComponents - 1];
+		if (textureData.compressedFormat != 0) {
+			internalFormat = textureData.compressedFormat;
+		}
+		int format = getTextureFormat(textureData.numComponents);
+		unsigned int texture;
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+		glTextureStorage2D(texture, textureData.getLevelCount(), internalFormat, textureData.width, textureData.height);
+
+		unsigned int unpackBuffer;
+		glCreateBuffers(1, &unpackBuffer);
+		glNamedBufferStorage(unpackBuffer, textureData.pixels.size(), textureData.pixels.data(), 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+		//Levels are tightly packed, rows of small levels aren't 4 byte aligned
+		int unpackAlignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (int level = 0; level < textureData.getLevelCount(); level++) {
+			if (textureData.compressedFormat != 0) {
+				size_t levelEnd = level + 1 < textureData.getLevelCount() ? textureData.levelOffsets[level + 1] : textureData.pixels.size();
+				glCompressedTextureSubImage2D(texture, level, 0, 0, textureData.getLevelWidth(level), textureData.getLevelHeight(level), internalFormat,
+					(int)(levelEnd - textureData.levelOffsets[level]), (const void*)textureData.levelOffsets[level]);
+				continue;
+			}
+			glTextureSubImage2D(texture, level, 0, 0, textureData.getLevelWidth(level), textureData.getLevelHeight(level), format, GL_UNSIGNED_BYTE, (const void*)textureData.levelOffsets[level]);
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		//Deleted once the copies finish
+		glDeleteBuffers(1, &unpackBuffer);
+
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_S, wrapMode);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_T, wrapMode);
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, minFilter);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, magFilter);
+		//Black border by default
+		float borderColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		glTextureParameterfv(texture, GL_TEXTURE_BORDER_COLOR, borderColor);
+		return texture;
+	}
+	unsigned int createTexture(const unsigned char* data, int width, int height, int numComponents, int wrapMode, int magFilter, int minFilter, bool mipmap) {
 		unsigned int texture;
 		glGenTextures(1, &texture);
 		glBindTexture(GL_TEXTURE_2D, texture);
@@ -49,7 +109,6 @@ namespace ew {
 		}
 
 		glBindTexture(GL_TEXTURE_2D, 0);
-		stbi_image_free(data);
 		return texture;
 	}
 }
@@ -3,8 +3,15 @@
 */
 
 #pragma once
+#include "textureData.h"
 
 namespace ew {
+	//DDS and KTX2 files upload their stored blocks and mips, see textureCompression.h
 	unsigned int loadTexture(const char* filePath);
 	unsigned int loadTexture(const char* filePath, int wrapMode, int magFilter, int minFilter, bool mipmap);
+	//Uploads already decoded 8 bit pixels with 1-4 components. Must be called on the thread that owns the context.
+	unsigned int createTexture(const unsigned char* data, int width, int height, int numComponents, int wrapMode, int magFilter, int minFilter, bool mipmap);
+	//Immutable storage with exactly the levels in textureData, uploaded through a pixel unpack buffer. Nothing is
+	//generated on the GPU, build the mips with loadTextureData or generateMips first.
+	unsigned int createTexture(const TextureData& textureData, int wrapMode, int magFilter, int minFilter);
 }
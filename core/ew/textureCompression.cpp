@@ -0,0 +1,627 @@
+#include "textureCompression.h"
+#include "workerPool.h"
+#include "external/glad.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+//EXT_texture_compression_s3tc and EXT_texture_sRGB, available on every desktop driver but not part of core
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace ew {
+	struct BlockFormatInfo {
+		BlockFormat format;
+		unsigned int glFormat;
+		unsigned int glSrgbFormat; //0 when there is no sRGB variant
+		unsigned int dxgiFormat;
+		unsigned int dxgiSrgbFormat;
+		unsigned int blockBytes;
+		int numComponents;
+	};
+
+	static const BlockFormatInfo BLOCK_FORMATS[] = {
+		{ BlockFormat::BC1, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 71, 72, 8, 4 },
+		{ BlockFormat::BC3, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 77, 78, 16, 4 },
+		{ BlockFormat::BC5, GL_COMPRESSED_RG_RGTC2, 0, 83, 0, 16, 2 },
+		{ BlockFormat::BC7, GL_COMPRESSED_RGBA_BPTC_UNORM, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 98, 99, 16, 4 },
+	};
+
+	static const BlockFormatInfo* findBlockFormat(BlockFormat format) {
+		for (const BlockFormatInfo& info : BLOCK_FORMATS) {
+			if (info.format == format) {
+				return &info;
+			}
+		}
+		return nullptr;
+	}
+
+	static const BlockFormatInfo* findBlockFormatByGL(unsigned int glFormat) {
+		for (const BlockFormatInfo& info : BLOCK_FORMATS) {
+			if (info.glFormat == glFormat || (info.glSrgbFormat != 0 && info.glSrgbFormat == glFormat)) {
+				return &info;
+			}
+		}
+		return nullptr;
+	}
+
+	static size_t levelSize(int width, int height, unsigned int blockBytes) {
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+	}
+
+	static bool hasExtension(const std::string& filePath, const char* extension) {
+		size_t length = strlen(extension);
+		if (filePath.size() < length) {
+			return false;
+		}
+		for (size_t i = 0; i < length; i++) {
+			char c = filePath[filePath.size() - length + i];
+			if (c >= 'A' && c <= 'Z') {
+				c = c - 'A' + 'a';
+			}
+			if (c != extension[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool isCompressedTexturePath(const std::string& filePath)
+	{
+		return hasExtension(filePath, ".dds") || hasExtension(filePath, ".ktx2");
+	}
+
+	static bool readFile(const char* filePath, std::vector<unsigned char>& bytes) {
+		FILE* in = fopen(filePath, "rb");
+		if (in == nullptr) {
+			return false;
+		}
+		fseek(in, 0, SEEK_END);
+		long size = ftell(in);
+		fseek(in, 0, SEEK_SET);
+		bytes.resize(size > 0 ? (size_t)size : 0);
+		bool read = size > 0 && fread(bytes.data(), 1, bytes.size(), in) == bytes.size();
+		fclose(in);
+		return read;
+	}
+
+	static unsigned int readU32(const unsigned char* p) {
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+	}
+
+	static unsigned long long readU64(const unsigned char* p) {
+		return readU32(p) | ((unsigned long long)readU32(p + 4) << 32);
+	}
+
+	static unsigned int fourCC(const char* code) {
+		return code[0] | (code[1] << 8) | (code[2] << 16) | ((unsigned int)code[3] << 24);
+	}
+
+	/// <summary>
+	/// Block format, size and level count from a DDS header. Legacy FourCC headers and DX10 headers are both read.
+	/// </summary>
+	static bool parseDds(const std::vector<unsigned char>& bytes, const BlockFormatInfo*& info, bool& srgb, int& width, int& height, int& levels, size_t& dataOffset) {
+		const size_t headerSize = 4 + 124;
+		if (bytes.size() < headerSize || readU32(&bytes[0]) != fourCC("DDS ")) {
+			return false;
+		}
+		const unsigned char* header = &bytes[4];
+		height = (int)readU32(header + 8);
+		width = (int)readU32(header + 12);
+		levels = (int)readU32(header + 24);
+		unsigned int code = readU32(header + 80);
+		dataOffset = headerSize;
+		info = nullptr;
+		srgb = false;
+		if (code == fourCC("DX10")) {
+			if (bytes.size() < headerSize + 20) {
+				return false;
+			}
+			unsigned int dxgiFormat = readU32(&bytes[headerSize]);
+			dataOffset += 20;
+			for (const BlockFormatInfo& candidate : BLOCK_FORMATS) {
+				if (candidate.dxgiFormat == dxgiFormat || (candidate.dxgiSrgbFormat != 0 && candidate.dxgiSrgbFormat == dxgiFormat)) {
+					info = &candidate;
+					srgb = candidate.dxgiSrgbFormat == dxgiFormat;
+				}
+			}
+		}
+		else if (code == fourCC("DXT1")) {
+			info = findBlockFormat(BlockFormat::BC1);
+		}
+		else if (code == fourCC("DXT5")) {
+			info = findBlockFormat(BlockFormat::BC3);
+		}
+		else if (code == fourCC("ATI2") || code == fourCC("BC5U")) {
+			info = findBlockFormat(BlockFormat::BC5);
+		}
+		return info != nullptr;
+	}
+
+	/// <summary>
+	/// Only the level index is used, the data format descriptor is skipped since the Vulkan format says everything needed
+	/// </summary>
+	static bool parseKtx2(const std::vector<unsigned char>& bytes, TextureData& textureData, const BlockFormatInfo*& info, bool& srgb) {
+		static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+		const size_t headerSize = 12 + 9 * 4 + 4 * 4 + 2 * 8;
+		if (bytes.size() < headerSize || memcmp(bytes.data(), identifier, sizeof(identifier)) != 0) {
+			return false;
+		}
+		const unsigned char* header = &bytes[12];
+		unsigned int vkFormat = readU32(header);
+		int width = (int)readU32(header + 8);
+		int height = (int)readU32(header + 12);
+		unsigned int levelCount = readU32(header + 28);
+		unsigned int supercompression = readU32(header + 32);
+		if (supercompression != 0) {
+			return false;
+		}
+		levelCount = levelCount > 0 ? levelCount : 1;
+		info = nullptr;
+		srgb = false;
+		switch (vkFormat) {
+		case 131: case 133: info = findBlockFormat(BlockFormat::BC1); break;
+		case 132: case 134: info = findBlockFormat(BlockFormat::BC1); srgb = true; break;
+		case 137: info = findBlockFormat(BlockFormat::BC3); break;
+		case 138: info = findBlockFormat(BlockFormat::BC3); srgb = true; break;
+		case 141: info = findBlockFormat(BlockFormat::BC5); break;
+		case 145: info = findBlockFormat(BlockFormat::BC7); break;
+		case 146: info = findBlockFormat(BlockFormat::BC7); srgb = true; break;
+		}
+		if (info == nullptr || bytes.size() < headerSize + levelCount * 24) {
+			return false;
+		}
+		textureData.width = width;
+		textureData.height = height;
+		textureData.levelOffsets.resize(levelCount);
+		size_t total = 0;
+		for (unsigned int level = 0; level < levelCount; level++) {
+			textureData.levelOffsets[level] = total;
+			total += levelSize(textureData.getLevelWidth(level), textureData.getLevelHeight(level), info->blockBytes);
+		}
+		textureData.pixels.resize(total);
+		//Levels are stored smallest first, the index lists them largest first
+		for (unsigned int level = 0; level < levelCount; level++) {
+			const unsigned char* entry = &bytes[headerSize + level * 24];
+			unsigned long long offset = readU64(entry);
+			unsigned long long length = readU64(entry + 8);
+			size_t expected = levelSize(textureData.getLevelWidth(level), textureData.getLevelHeight(level), info->blockBytes);
+			if (length != expected || offset + length > bytes.size()) {
+				return false;
+			}
+			memcpy(&textureData.pixels[textureData.levelOffsets[level]], &bytes[(size_t)offset], expected);
+		}
+		return true;
+	}
+
+	bool loadCompressedTextureData(const char* filePath, TextureData& textureData, bool srgb)
+	{
+		std::vector<unsigned char> bytes;
+		if (!readFile(filePath, bytes)) {
+			printf("Failed to load image %s\n", filePath);
+			return false;
+		}
+		const BlockFormatInfo* info = nullptr;
+		bool storedSrgb = false;
+		bool parsed = false;
+		if (hasExtension(filePath, ".ktx2")) {
+			parsed = parseKtx2(bytes, textureData, info, storedSrgb);
+		}
+		else {
+			int width, height, levels;
+			size_t dataOffset;
+			parsed = parseDds(bytes, info, storedSrgb, width, height, levels, dataOffset);
+			if (parsed) {
+				textureData.width = width;
+				textureData.height = height;
+				textureData.levelOffsets.resize(levels > 0 ? levels : 1);
+				size_t total = 0;
+				for (int level = 0; level < textureData.getLevelCount(); level++) {
+					textureData.levelOffsets[level] = total;
+					total += levelSize(textureData.getLevelWidth(level), textureData.getLevelHeight(level), info->blockBytes);
+				}
+				parsed = dataOffset + total <= bytes.size();
+				if (parsed) {
+					textureData.pixels.assign(bytes.begin() + dataOffset, bytes.begin() + dataOffset + total);
+				}
+			}
+		}
+		if (!parsed) {
+			printf("Unsupported or corrupt compressed texture %s\n", filePath);
+			return false;
+		}
+		textureData.numComponents = info->numComponents;
+		textureData.srgb = (storedSrgb || srgb) && info->glSrgbFormat != 0;
+		textureData.compressedFormat = textureData.srgb ? info->glSrgbFormat : info->glFormat;
+		return true;
+	}
+
+	//4x4 RGBA pixels, edges of levels smaller than a block repeat the last row and column
+	static void fetchBlock(const unsigned char* pixels, int width, int height, int numComponents, int blockX, int blockY, unsigned char block[16][4]) {
+		for (int y = 0; y < 4; y++) {
+			int py = blockY * 4 + y < height ? blockY * 4 + y : height - 1;
+			for (int x = 0; x < 4; x++) {
+				int px = blockX * 4 + x < width ? blockX * 4 + x : width - 1;
+				const unsigned char* p = pixels + ((size_t)py * width + px) * numComponents;
+				unsigned char* out = block[y * 4 + x];
+				out[0] = p[0];
+				out[1] = numComponents >= 2 ? p[1] : p[0];
+				out[2] = numComponents >= 3 ? p[2] : (numComponents == 1 ? p[0] : 0);
+				out[3] = numComponents == 4 ? p[3] : 255;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Endpoints are the extremes of the block along its principal axis, found with a few power iterations
+	/// </summary>
+	static void principalEndpoints(const unsigned char block[16][4], int channels, float endpoint0[4], float endpoint1[4]) {
+		float mean[4] = {};
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < channels; c++) {
+				mean[c] += block[i][c] / 16.0f;
+			}
+		}
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; i++) {
+			for (int a = 0; a < channels; a++) {
+				for (int b = 0; b < channels; b++) {
+					covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+				}
+			}
+		}
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[4] = {};
+			float length = 0.0f;
+			for (int a = 0; a < channels; a++) {
+				for (int b = 0; b < channels; b++) {
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length += next[a] * next[a];
+			}
+			if (length < 1e-6f) {
+				break;
+			}
+			length = sqrtf(length);
+			for (int a = 0; a < channels; a++) {
+				axis[a] = next[a] / length;
+			}
+		}
+		float minT = 0.0f, maxT = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			float t = 0.0f;
+			for (int c = 0; c < channels; c++) {
+				t += (block[i][c] - mean[c]) * axis[c];
+			}
+			minT = t < minT ? t : minT;
+			maxT = t > maxT ? t : maxT;
+		}
+		for (int c = 0; c < channels; c++) {
+			endpoint0[c] = fminf(fmaxf(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+			endpoint1[c] = fminf(fmaxf(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+		}
+	}
+
+	static int colorDistance(const int a[3], const unsigned char b[4]) {
+		int dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+		return dr * dr + dg * dg + db * db;
+	}
+
+	//BC1 color in four color mode, the alpha channel is ignored
+	static void encodeColorBlock(const unsigned char block[16][4], unsigned char* out) {
+		float endpoint0[4], endpoint1[4];
+		principalEndpoints(block, 3, endpoint0, endpoint1);
+		auto to565 = [](const float c[4]) {
+			unsigned int r = (unsigned int)(c[0] * 31.0f / 255.0f + 0.5f);
+			unsigned int g = (unsigned int)(c[1] * 63.0f / 255.0f + 0.5f);
+			unsigned int b = (unsigned int)(c[2] * 31.0f / 255.0f + 0.5f);
+			return (unsigned short)((r << 11) | (g << 5) | b);
+		};
+		unsigned short color0 = to565(endpoint0);
+		unsigned short color1 = to565(endpoint1);
+		if (color0 < color1) {
+			unsigned short swap = color0;
+			color0 = color1;
+			color1 = swap;
+		}
+		unsigned int indices = 0;
+		if (color0 != color1) {
+			int palette[4][3];
+			for (int e = 0; e < 2; e++) {
+				unsigned short color = e == 0 ? color0 : color1;
+				int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+				palette[e][0] = (r << 3) | (r >> 2);
+				palette[e][1] = (g << 2) | (g >> 4);
+				palette[e][2] = (b << 3) | (b >> 2);
+			}
+			for (int c = 0; c < 3; c++) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			for (int i = 0; i < 16; i++) {
+				unsigned int best = 0;
+				int bestDistance = colorDistance(palette[0], block[i]);
+				for (unsigned int p = 1; p < 4; p++) {
+					int distance = colorDistance(palette[p], block[i]);
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						best = p;
+					}
+				}
+				indices |= best << (2 * i);
+			}
+		}
+		out[0] = color0 & 0xFF;
+		out[1] = color0 >> 8;
+		out[2] = color1 & 0xFF;
+		out[3] = color1 >> 8;
+		for (int i = 0; i < 4; i++) {
+			out[4 + i] = (indices >> (8 * i)) & 0xFF;
+		}
+	}
+
+	//BC4 block of one channel in eight value mode, also the alpha of BC3 and each half of BC5
+	static void encodeChannelBlock(const unsigned char block[16][4], int channel, unsigned char* out) {
+		int maxValue = 0, minValue = 255;
+		for (int i = 0; i < 16; i++) {
+			maxValue = block[i][channel] > maxValue ? block[i][channel] : maxValue;
+			minValue = block[i][channel] < minValue ? block[i][channel] : minValue;
+		}
+		out[0] = (unsigned char)maxValue;
+		out[1] = (unsigned char)minValue;
+		unsigned long long indices = 0;
+		if (maxValue != minValue) {
+			int palette[8] = { maxValue, minValue };
+			for (int k = 2; k < 8; k++) {
+				palette[k] = ((8 - k) * maxValue + (k - 1) * minValue) / 7;
+			}
+			for (int i = 0; i < 16; i++) {
+				unsigned long long best = 0;
+				int bestDistance = 256;
+				for (int k = 0; k < 8; k++) {
+					int distance = abs(palette[k] - block[i][channel]);
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						best = k;
+					}
+				}
+				indices |= best << (3 * i);
+			}
+		}
+		for (int i = 0; i < 6; i++) {
+			out[2 + i] = (indices >> (8 * i)) & 0xFF;
+		}
+	}
+
+	//Little endian bit stream for BC7 blocks
+	struct BlockWriter {
+		unsigned char* out;
+		int bit = 0;
+
+		void write(unsigned int value, int bits) {
+			for (int i = 0; i < bits; i++, bit++) {
+				if (value & (1u << i)) {
+					out[bit >> 3] |= (unsigned char)(1u << (bit & 7));
+				}
+			}
+		}
+	};
+
+	/// <summary>
+	/// BC7 mode 6: one subset, 7 bit RGBA endpoints with a shared bit each and 4 bit indices. Every combination of
+	/// the two shared bits is tried and the one with the least error kept.
+	/// </summary>
+	static void encodeBC7Block(const unsigned char block[16][4], unsigned char* out) {
+		static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		float endpoint0[4], endpoint1[4];
+		principalEndpoints(block, 4, endpoint0, endpoint1);
+
+		int bestQuantized[2][4] = {};
+		int bestShared[2] = {};
+		int bestIndices[16] = {};
+		int bestError = -1;
+		for (int shared = 0; shared < 4; shared++) {
+			int pbit[2] = { shared & 1, shared >> 1 };
+			int quantized[2][4];
+			int endpoints[2][4];
+			for (int e = 0; e < 2; e++) {
+				const float* source = e == 0 ? endpoint0 : endpoint1;
+				for (int c = 0; c < 4; c++) {
+					int q = (int)((source[c] - pbit[e]) / 2.0f + 0.5f);
+					q = q < 0 ? 0 : (q > 127 ? 127 : q);
+					quantized[e][c] = q;
+					endpoints[e][c] = (q << 1) | pbit[e];
+				}
+			}
+			int palette[16][4];
+			for (int w = 0; w < 16; w++) {
+				for (int c = 0; c < 4; c++) {
+					palette[w][c] = ((64 - weights[w]) * endpoints[0][c] + weights[w] * endpoints[1][c] + 32) >> 6;
+				}
+			}
+			int indices[16];
+			int error = 0;
+			for (int i = 0; i < 16; i++) {
+				int bestDistance = -1;
+				for (int w = 0; w < 16; w++) {
+					int distance = 0;
+					for (int c = 0; c < 4; c++) {
+						int d = palette[w][c] - block[i][c];
+						distance += d * d;
+					}
+					if (bestDistance < 0 || distance < bestDistance) {
+						bestDistance = distance;
+						indices[i] = w;
+					}
+				}
+				error += bestDistance;
+			}
+			if (bestError < 0 || error < bestError) {
+				bestError = error;
+				memcpy(bestQuantized, quantized, sizeof(quantized));
+				memcpy(bestIndices, indices, sizeof(indices));
+				bestShared[0] = pbit[0];
+				bestShared[1] = pbit[1];
+			}
+		}
+		//The first index is stored without its top bit, so it must be below 8
+		if (bestIndices[0] >= 8) {
+			for (int c = 0; c < 4; c++) {
+				int swap = bestQuantized[0][c];
+				bestQuantized[0][c] = bestQuantized[1][c];
+				bestQuantized[1][c] = swap;
+			}
+			int swap = bestShared[0];
+			bestShared[0] = bestShared[1];
+			bestShared[1] = swap;
+			for (int i = 0; i < 16; i++) {
+				bestIndices[i] = 15 - bestIndices[i];
+			}
+		}
+		memset(out, 0, 16);
+		BlockWriter writer = { out };
+		writer.write(1 << 6, 7);
+		for (int c = 0; c < 4; c++) {
+			writer.write(bestQuantized[0][c], 7);
+			writer.write(bestQuantized[1][c], 7);
+		}
+		writer.write(bestShared[0], 1);
+		writer.write(bestShared[1], 1);
+		writer.write(bestIndices[0], 3);
+		for (int i = 1; i < 16; i++) {
+			writer.write(bestIndices[i], 4);
+		}
+	}
+
+	void compressTexture(const TextureData& textureData, BlockFormat format, TextureData& compressed, WorkerPool* pool)
+	{
+		const BlockFormatInfo* info = findBlockFormat(format);
+		compressed.width = textureData.width;
+		compressed.height = textureData.height;
+		compressed.numComponents = info->numComponents;
+		compressed.srgb = textureData.srgb && info->glSrgbFormat != 0;
+		compressed.compressedFormat = compressed.srgb ? info->glSrgbFormat : info->glFormat;
+		compressed.levelOffsets.resize(textureData.getLevelCount());
+		size_t total = 0;
+		for (int level = 0; level < textureData.getLevelCount(); level++) {
+			compressed.levelOffsets[level] = total;
+			total += levelSize(textureData.getLevelWidth(level), textureData.getLevelHeight(level), info->blockBytes);
+		}
+		compressed.pixels.assign(total, 0);
+
+		for (int level = 0; level < textureData.getLevelCount(); level++) {
+			const int width = textureData.getLevelWidth(level);
+			const int height = textureData.getLevelHeight(level);
+			const int blocksX = (width + 3) / 4;
+			const int blocksY = (height + 3) / 4;
+			const unsigned char* pixels = textureData.pixels.data() + textureData.levelOffsets[level];
+			unsigned char* blocks = compressed.pixels.data() + compressed.levelOffsets[level];
+			auto encodeRow = [&](size_t blockY) {
+				unsigned char block[16][4];
+				for (int blockX = 0; blockX < blocksX; blockX++) {
+					fetchBlock(pixels, width, height, textureData.numComponents, blockX, (int)blockY, block);
+					unsigned char* out = blocks + ((size_t)blockY * blocksX + blockX) * info->blockBytes;
+					switch (format) {
+					case BlockFormat::BC1:
+						encodeColorBlock(block, out);
+						break;
+					case BlockFormat::BC3:
+						encodeChannelBlock(block, 3, out);
+						encodeColorBlock(block, out + 8);
+						break;
+					case BlockFormat::BC5:
+						encodeChannelBlock(block, 0, out);
+						encodeChannelBlock(block, 1, out + 8);
+						break;
+					case BlockFormat::BC7:
+						encodeBC7Block(block, out);
+						break;
+					}
+				}
+			};
+			if (pool != nullptr && blocksY > 1) {
+				pool->parallelFor(blocksY, encodeRow);
+			}
+			else {
+				for (int blockY = 0; blockY < blocksY; blockY++) {
+					encodeRow(blockY);
+				}
+			}
+		}
+	}
+
+	static void writeU32(FILE* out, unsigned int value) {
+		unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+		fwrite(bytes, 1, 4, out);
+	}
+
+	bool writeDds(const std::string& filePath, const TextureData& compressed)
+	{
+		const BlockFormatInfo* info = findBlockFormatByGL(compressed.compressedFormat);
+		if (info == nullptr) {
+			printf("Can't write %s, the texture isn't block compressed\n", filePath.c_str());
+			return false;
+		}
+		FILE* out = fopen(filePath.c_str(), "wb");
+		if (out == nullptr) {
+			printf("Failed to open %s for writing\n", filePath.c_str());
+			return false;
+		}
+		const unsigned int DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+		const unsigned int DDPF_FOURCC = 0x4;
+		const unsigned int DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+		const int levels = compressed.getLevelCount();
+		writeU32(out, fourCC("DDS "));
+		writeU32(out, 124);
+		writeU32(out, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE);
+		writeU32(out, compressed.height);
+		writeU32(out, compressed.width);
+		writeU32(out, (unsigned int)levelSize(compressed.width, compressed.height, info->blockBytes));
+		writeU32(out, 0); //Depth
+		writeU32(out, levels);
+		for (int i = 0; i < 11; i++) {
+			writeU32(out, 0);
+		}
+		//Pixel format
+		writeU32(out, 32);
+		writeU32(out, DDPF_FOURCC);
+		writeU32(out, fourCC("DX10"));
+		for (int i = 0; i < 5; i++) {
+			writeU32(out, 0);
+		}
+		writeU32(out, DDSCAPS_TEXTURE | (levels > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0));
+		for (int i = 0; i < 4; i++) {
+			writeU32(out, 0);
+		}
+		//DX10 header: format, 2D, no flags, one layer
+		writeU32(out, compressed.srgb ? info->dxgiSrgbFormat : info->dxgiFormat);
+		writeU32(out, 3);
+		writeU32(out, 0);
+		writeU32(out, 1);
+		writeU32(out, 0);
+		bool written = fwrite(compressed.pixels.data(), 1, compressed.pixels.size(), out) == compressed.pixels.size();
+		fclose(out);
+		return written;
+	}
+
+	std::string getCompressedTexturePath(const std::string& sourcePath)
+	{
+		std::string compressedPath = sourcePath + ".dds";
+		struct stat sourceInfo;
+		struct stat compressedInfo;
+		if (stat(compressedPath.c_str(), &compressedInfo) == 0
+			&& (stat(sourcePath.c_str(), &sourceInfo) != 0 || compressedInfo.st_mtime >= sourceInfo.st_mtime)) {
+			return compressedPath;
+		}
+		return sourcePath;
+	}
+}
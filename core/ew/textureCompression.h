@@ -0,0 +1,28 @@
+#pragma once
+#include "textureData.h"
+#include <string>
+
+namespace ew {
+	class WorkerPool;
+
+	enum class BlockFormat {
+		BC1, //RGB, 4 bits per pixel, no alpha
+		BC3, //RGBA, 8 bits per pixel
+		BC5, //Two channels (normal map XY), 8 bits per pixel
+		BC7 //RGBA, 8 bits per pixel, best quality
+	};
+
+	//True for the file types loadCompressedTextureData reads
+	bool isCompressedTexturePath(const std::string& filePath);
+	//Reads a DDS (including DX10 headers) or uncompressed-container KTX2 file holding BC1, BC3, BC5 or BC7 blocks with
+	//every stored mip. srgb selects the sRGB variant of formats stored as UNORM. Safe to call from worker threads.
+	bool loadCompressedTextureData(const char* filePath, TextureData& textureData, bool srgb = false);
+	//Encodes every level of uncompressed textureData. Blocks of large levels are split across pool when given.
+	//The encoder favours speed over quality, BC7 only uses mode 6.
+	void compressTexture(const TextureData& textureData, BlockFormat format, TextureData& compressed, WorkerPool* pool = nullptr);
+	//DDS with a DX10 header, which every BC format and sRGB can be described with
+	bool writeDds(const std::string& filePath, const TextureData& compressed);
+	//Path of a compressed copy of sourcePath (sourcePath + ".dds") when there is one at least as new as the source,
+	//otherwise sourcePath. Nothing is encoded at runtime, see tools/texCompress.
+	std::string getCompressedTexturePath(const std::string& sourcePath);
+}
@@ -0,0 +1,169 @@
+#include "textureData.h"
+#include "textureCompression.h"
+#include "workerPool.h"
+#include "external/stb_image.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EW_TEXTURE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ew {
+	//sRGB to 16 bit linear, and 12 bit linear back to sRGB
+	struct SrgbTables {
+		unsigned short toLinear[256];
+		unsigned char fromLinear[4096];
+
+		SrgbTables() {
+			for (int i = 0; i < 256; i++) {
+				float c = i / 255.0f;
+				float linear = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+				toLinear[i] = (unsigned short)(linear * 65535.0f + 0.5f);
+			}
+			for (int i = 0; i < 4096; i++) {
+				float linear = i / 4095.0f;
+				float c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+				fromLinear[i] = (unsigned char)(c * 255.0f + 0.5f);
+			}
+		}
+	};
+
+	static const SrgbTables& srgbTables() {
+		static SrgbTables tables;
+		return tables;
+	}
+
+	/// <summary>
+	/// One destination row from two source rows. Columns past the edge of a 1 pixel wide source repeat the last one.
+	/// </summary>
+	static void downsampleRow(const unsigned char* row0, const unsigned char* row1, unsigned char* dst, int srcWidth, int dstWidth, int numComponents, bool srgb) {
+		int x = 0;
+		if (srgb) {
+			//Alpha, the fourth channel, stays linear
+			const SrgbTables& tables = srgbTables();
+			for (; x < dstWidth; x++) {
+				int x0 = 2 * x;
+				int x1 = 2 * x + 1 < srcWidth ? 2 * x + 1 : srcWidth - 1;
+				for (int c = 0; c < numComponents; c++) {
+					const unsigned char a = row0[x0 * numComponents + c], b = row0[x1 * numComponents + c];
+					const unsigned char d = row1[x0 * numComponents + c], e = row1[x1 * numComponents + c];
+					if (c == 3) {
+						dst[x * numComponents + c] = (unsigned char)((a + b + d + e + 2) >> 2);
+					}
+					else {
+						unsigned int sum = tables.toLinear[a] + tables.toLinear[b] + tables.toLinear[d] + tables.toLinear[e];
+						dst[x * numComponents + c] = tables.fromLinear[sum >> 6];
+					}
+				}
+			}
+			return;
+		}
+#ifdef EW_TEXTURE_SSE2
+		//Two RGBA pixels per iteration: rows are summed as 16 bit, then horizontal neighbours, then rounded and packed
+		if (numComponents == 4 && srcWidth >= 2) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i two = _mm_set1_epi16(2);
+			for (; x + 2 <= dstWidth; x += 2) {
+				__m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+				__m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+				__m128i left = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i right = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+				__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+				sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+				_mm_storel_epi64((__m128i*)(dst + x * 4), _mm_packus_epi16(sum, zero));
+			}
+		}
+#endif
+		for (; x < dstWidth; x++) {
+			int x0 = 2 * x;
+			int x1 = 2 * x + 1 < srcWidth ? 2 * x + 1 : srcWidth - 1;
+			for (int c = 0; c < numComponents; c++) {
+				int sum = row0[x0 * numComponents + c] + row0[x1 * numComponents + c] + row1[x0 * numComponents + c] + row1[x1 * numComponents + c];
+				dst[x * numComponents + c] = (unsigned char)((sum + 2) >> 2);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Odd sizes round down like GL's own level sizes, so the last row or column of an odd level is dropped.
+	/// Levels are built in order since each reads the previous one, rows within a level are independent.
+	/// </summary>
+	void generateMips(TextureData& textureData, WorkerPool* pool)
+	{
+		const int numComponents = textureData.numComponents;
+		const bool srgb = textureData.srgb && numComponents >= 3;
+		int levels = 1;
+		for (int size = textureData.width > textureData.height ? textureData.width : textureData.height; size > 1; size >>= 1) {
+			levels++;
+		}
+		textureData.levelOffsets.resize(levels);
+		size_t total = 0;
+		for (int level = 0; level < levels; level++) {
+			textureData.levelOffsets[level] = total;
+			total += (size_t)textureData.getLevelWidth(level) * textureData.getLevelHeight(level) * numComponents;
+		}
+		textureData.pixels.resize(total);
+
+		const int rowsPerJob = 32;
+		for (int level = 1; level < levels; level++) {
+			const int srcWidth = textureData.getLevelWidth(level - 1);
+			const int srcHeight = textureData.getLevelHeight(level - 1);
+			const int dstWidth = textureData.getLevelWidth(level);
+			const int dstHeight = textureData.getLevelHeight(level);
+			const unsigned char* src = textureData.pixels.data() + textureData.levelOffsets[level - 1];
+			unsigned char* dst = textureData.pixels.data() + textureData.levelOffsets[level];
+			auto downsampleRows = [&](size_t job) {
+				int firstRow = (int)job * rowsPerJob;
+				int lastRow = firstRow + rowsPerJob < dstHeight ? firstRow + rowsPerJob : dstHeight;
+				for (int y = firstRow; y < lastRow; y++) {
+					int y1 = 2 * y + 1 < srcHeight ? 2 * y + 1 : srcHeight - 1;
+					downsampleRow(src + (size_t)2 * y * srcWidth * numComponents, src + (size_t)y1 * srcWidth * numComponents,
+						dst + (size_t)y * dstWidth * numComponents, srcWidth, dstWidth, numComponents, srgb);
+				}
+			};
+			size_t jobs = (dstHeight + rowsPerJob - 1) / rowsPerJob;
+			if (pool != nullptr && jobs > 1) {
+				pool->parallelFor(jobs, downsampleRows);
+			}
+			else {
+				for (size_t job = 0; job < jobs; job++) {
+					downsampleRows(job);
+				}
+			}
+		}
+	}
+
+	bool loadTextureData(const char* filePath, TextureData& textureData, bool mipmap, bool srgb, WorkerPool* pool)
+	{
+		if (isCompressedTexturePath(filePath)) {
+			return loadCompressedTextureData(filePath, textureData, srgb);
+		}
+		int width, height, numComponents;
+		if (!stbi_info(filePath, &width, &height, &numComponents)) {
+			printf("Failed to load image %s\n", filePath);
+			return false;
+		}
+		//RGB is padded to RGBA anyway by most drivers, and 4 byte pixels take the SIMD path
+		int desiredComponents = numComponents == 3 ? 4 : numComponents;
+		unsigned char* data = stbi_load(filePath, &width, &height, &numComponents, desiredComponents);
+		if (data == NULL) {
+			printf("Failed to load image %s\n", filePath);
+			return false;
+		}
+		textureData.width = width;
+		textureData.height = height;
+		textureData.numComponents = desiredComponents;
+		textureData.srgb = srgb && desiredComponents == 4;
+		size_t size = (size_t)width * height * desiredComponents;
+		textureData.pixels.assign(data, data + size);
+		textureData.levelOffsets.assign(1, 0);
+		stbi_image_free(data);
+		if (mipmap) {
+			generateMips(textureData, pool);
+		}
+		return true;
+	}
+}
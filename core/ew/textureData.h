@@ -0,0 +1,30 @@
+#pragma once
+#include <stddef.h>
+#include <vector>
+
+namespace ew {
+	class WorkerPool;
+
+	//Decoded 8 bit pixels with their mip chain, built off the GL thread and uploaded with createTexture
+	struct TextureData {
+		int width = 0;
+		int height = 0;
+		int numComponents = 0; //1, 2 or 4, RGB is expanded to RGBA when loaded
+		bool srgb = false; //Color channels are sRGB encoded, averaged in linear space and uploaded as an sRGB format
+		unsigned int compressedFormat = 0; //GL block compressed format, pixels then holds 4x4 blocks, see textureCompression.h
+		std::vector<unsigned char> pixels; //Every level tightly packed, largest first
+		std::vector<size_t> levelOffsets; //Into pixels, one per level
+
+		inline int getLevelCount()const { return (int)levelOffsets.size(); }
+		inline int getLevelWidth(int level)const { return width >> level > 0 ? width >> level : 1; }
+		inline int getLevelHeight(int level)const { return height >> level > 0 ? height >> level : 1; }
+	};
+
+	//Decodes with stb_image and optionally builds the full mip chain. Safe to call from worker threads.
+	//srgb only applies to color images, one and two component images are always linear.
+	//DDS and KTX2 files are read as stored, with their own mips, see loadCompressedTextureData.
+	bool loadTextureData(const char* filePath, TextureData& textureData, bool mipmap, bool srgb = false, WorkerPool* pool = nullptr);
+	//Replaces every level after the first with a 2x2 box filtered chain down to 1x1.
+	//Rows of large levels are split across pool when given.
+	void generateMips(TextureData& textureData, WorkerPool* pool = nullptr);
+}
@@ -0,0 +1,221 @@
+#include "textureRegistry.h"
+#include "texture.h"
+#include "external/glad.h"
+
+namespace ew {
+	TextureRef::TextureRef(TextureRegistry* registry, int entry)
+		: m_registry(registry), m_entry(entry)
+	{
+		m_registry->addRef(m_entry);
+	}
+
+	TextureRef::TextureRef(const TextureRef& other)
+		: m_registry(other.m_registry), m_entry(other.m_entry)
+	{
+		if (m_registry != nullptr) {
+			m_registry->addRef(m_entry);
+		}
+	}
+
+	TextureRef::TextureRef(TextureRef&& other)
+		: m_registry(other.m_registry), m_entry(other.m_entry)
+	{
+		other.m_registry = nullptr;
+		other.m_entry = -1;
+	}
+
+	TextureRef& TextureRef::operator=(const TextureRef& other)
+	{
+		//Referenced first so assigning a reference to itself can't drop the texture
+		TextureRegistry* registry = other.m_registry;
+		int entry = other.m_entry;
+		if (registry != nullptr) {
+			registry->addRef(entry);
+		}
+		reset();
+		m_registry = registry;
+		m_entry = entry;
+		return *this;
+	}
+
+	TextureRef& TextureRef::operator=(TextureRef&& other)
+	{
+		if (this != &other) {
+			reset();
+			m_registry = other.m_registry;
+			m_entry = other.m_entry;
+			other.m_registry = nullptr;
+			other.m_entry = -1;
+		}
+		return *this;
+	}
+
+	TextureRef::~TextureRef()
+	{
+		reset();
+	}
+
+	unsigned int TextureRef::get()const
+	{
+		return m_registry != nullptr ? m_registry->m_entries[m_entry].texture : 0;
+	}
+
+	void TextureRef::reset()
+	{
+		if (m_registry != nullptr) {
+			m_registry->release(m_entry);
+		}
+		m_registry = nullptr;
+		m_entry = -1;
+	}
+
+	static std::string makeKey(const std::string& filePath, int wrapMode, int magFilter, int minFilter, bool mipmap, bool srgb) {
+		return filePath + "|" + std::to_string(wrapMode) + "|" + std::to_string(magFilter) + "|" + std::to_string(minFilter) + "|" + (mipmap ? "1" : "0") + (srgb ? "1" : "0");
+	}
+
+	TextureRegistry::TextureRegistry(size_t budgetBytes)
+		: m_budgetBytes(budgetBytes)
+	{
+	}
+
+	TextureRegistry::~TextureRegistry()
+	{
+		for (const Entry& entry : m_entries) {
+			if (entry.texture != 0) {
+				glDeleteTextures(1, &entry.texture);
+			}
+		}
+	}
+
+	TextureRef TextureRegistry::load(const std::string& filePath)
+	{
+		return load(filePath, GL_REPEAT, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR, true);
+	}
+
+	TextureRef TextureRegistry::load(const std::string& filePath, int wrapMode, int magFilter, int minFilter, bool mipmap, bool srgb)
+	{
+		TextureRef resident = find(filePath, wrapMode, magFilter, minFilter, mipmap, srgb);
+		if (resident.valid()) {
+			return resident;
+		}
+		TextureData textureData;
+		if (!loadTextureData(filePath.c_str(), textureData, mipmap, srgb)) {
+			return TextureRef();
+		}
+		return add(filePath, wrapMode, magFilter, minFilter, mipmap, srgb, textureData);
+	}
+
+	TextureRef TextureRegistry::find(const std::string& filePath, int wrapMode, int magFilter, int minFilter, bool mipmap, bool srgb)
+	{
+		std::unordered_map<std::string, int>::const_iterator it = m_lookup.find(makeKey(filePath, wrapMode, magFilter, minFilter, mipmap, srgb));
+		if (it == m_lookup.end()) {
+			return TextureRef();
+		}
+		m_hits++;
+		return TextureRef(this, it->second);
+	}
+
+	TextureRef TextureRegistry::add(const std::string& filePath, int wrapMode, int magFilter, int minFilter, bool mipmap, bool srgb, const TextureData& textureData)
+	{
+		std::string key = makeKey(filePath, wrapMode, magFilter, minFilter, mipmap, srgb);
+		std::unordered_map<std::string, int>::const_iterator it = m_lookup.find(key);
+		if (it != m_lookup.end()) {
+			m_hits++;
+			return TextureRef(this, it->second);
+		}
+		m_misses++;
+		unsigned int texture = createTexture(textureData, wrapMode, magFilter, minFilter);
+		//Referenced before trimming so the new texture is never the one evicted
+		TextureRef ref(this, insert(key, texture, textureData.pixels.size()));
+		trim();
+		return ref;
+	}
+
+	void TextureRegistry::setBudget(size_t budgetBytes)
+	{
+		m_budgetBytes = budgetBytes;
+		trim();
+	}
+
+	void TextureRegistry::evictUnused()
+	{
+		for (size_t i = 0; i < m_entries.size(); i++) {
+			if (m_entries[i].texture != 0 && m_entries[i].refCount == 0) {
+				evict((int)i);
+			}
+		}
+	}
+
+	int TextureRegistry::insert(const std::string& key, unsigned int texture, size_t bytes)
+	{
+		int index;
+		if (!m_freeEntries.empty()) {
+			index = m_freeEntries.back();
+			m_freeEntries.pop_back();
+		}
+		else {
+			index = (int)m_entries.size();
+			m_entries.push_back(Entry());
+		}
+		Entry& entry = m_entries[index];
+		entry.key = key;
+		entry.texture = texture;
+		entry.bytes = bytes;
+		entry.refCount = 0;
+		entry.lastUse = m_useCounter++;
+		m_lookup[key] = index;
+		m_residentBytes += bytes;
+		m_residentCount++;
+		return index;
+	}
+
+	void TextureRegistry::evict(int index)
+	{
+		Entry& entry = m_entries[index];
+		glDeleteTextures(1, &entry.texture);
+		m_lookup.erase(entry.key);
+		m_residentBytes -= entry.bytes;
+		m_residentCount--;
+		m_evictions++;
+		entry = Entry();
+		m_freeEntries.push_back(index);
+	}
+
+	/// <summary>
+	/// Referenced textures are never evicted, so a budget smaller than what is in use is exceeded rather than enforced
+	/// </summary>
+	void TextureRegistry::trim()
+	{
+		while (m_budgetBytes > 0 && m_residentBytes > m_budgetBytes) {
+			int oldest = -1;
+			for (size_t i = 0; i < m_entries.size(); i++) {
+				const Entry& entry = m_entries[i];
+				if (entry.texture != 0 && entry.refCount == 0 && (oldest < 0 || entry.lastUse < m_entries[oldest].lastUse)) {
+					oldest = (int)i;
+				}
+			}
+			if (oldest < 0) {
+				return;
+			}
+			evict(oldest);
+		}
+	}
+
+	void TextureRegistry::addRef(int index)
+	{
+		Entry& entry = m_entries[index];
+		entry.refCount++;
+		entry.lastUse = m_useCounter++;
+	}
+
+	//Released textures stay resident until the budget needs their memory
+	void TextureRegistry::release(int index)
+	{
+		Entry& entry = m_entries[index];
+		entry.refCount--;
+		entry.lastUse = m_useCounter++;
+		if (entry.refCount == 0) {
+			trim();
+		}
+	}
+}
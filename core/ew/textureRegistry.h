@@ -0,0 +1,96 @@
+#pragma once
+#include "textureData.h"
+#include <stddef.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ew {
+	class TextureRegistry;
+
+	/// <summary>
+	/// Counted reference to a texture in a TextureRegistry. The texture stays resident while any reference to it
+	/// exists. References must not outlive their registry and, like everything GL, belong to the context's thread.
+	/// </summary>
+	class TextureRef {
+	public:
+		TextureRef() {};
+		TextureRef(const TextureRef& other);
+		TextureRef(TextureRef&& other);
+		TextureRef& operator=(const TextureRef& other);
+		TextureRef& operator=(TextureRef&& other);
+		~TextureRef();
+		//GL texture, 0 for an empty reference
+		unsigned int get()const;
+		inline bool valid()const { return m_registry != nullptr; }
+		void reset();
+	private:
+		friend class TextureRegistry;
+		TextureRef(TextureRegistry* registry, int entry);
+
+		TextureRegistry* m_registry = nullptr;
+		int m_entry = -1;
+	};
+
+	/// <summary>
+	/// Loads each texture once per path and sampler settings. Textures nothing references are kept in case they are
+	/// needed again, and deleted least recently used first once resident memory passes the budget.
+	/// </summary>
+	class TextureRegistry {
+	public:
+		//0 never evicts
+		TextureRegistry(size_t budgetBytes = 0);
+		//Deletes every texture, referenced or not
+		~TextureRegistry();
+		TextureRegistry(const TextureRegistry&) = delete;
+		TextureRegistry& operator=(const TextureRegistry&) = delete;
+
+		//Decodes and uploads on a miss, returning an empty reference if that fails. Sampling defaults match loadTexture.
+		TextureRef load(const std::string& filePath);
+		TextureRef load(const std::string& filePath, int wrapMode, int magFilter, int minFilter, bool mipmap, bool srgb = false);
+		//Empty reference unless the texture is resident
+		TextureRef find(const std::string& filePath, int wrapMode, int magFilter, int minFilter, bool mipmap, bool srgb = false);
+		//Uploads a texture decoded elsewhere, see loadTextureData. Returns the resident texture instead if there already is one.
+		TextureRef add(const std::string& filePath, int wrapMode, int magFilter, int minFilter, bool mipmap, bool srgb, const TextureData& textureData);
+
+		void setBudget(size_t budgetBytes);
+		//Deletes every unreferenced texture regardless of the budget
+		void evictUnused();
+
+		inline size_t getBudget()const { return m_budgetBytes; }
+		//Video memory of every resident texture, including mip chains
+		inline size_t getResidentBytes()const { return m_residentBytes; }
+		inline int getResidentCount()const { return m_residentCount; }
+		//Loads answered by a resident texture and loads that had to decode
+		inline unsigned int getHitCount()const { return m_hits; }
+		inline unsigned int getMissCount()const { return m_misses; }
+		inline unsigned int getEvictionCount()const { return m_evictions; }
+	private:
+		friend class TextureRef;
+		struct Entry {
+			std::string key;
+			unsigned int texture = 0;
+			size_t bytes = 0;
+			int refCount = 0;
+			unsigned int lastUse = 0;
+		};
+
+		int insert(const std::string& key, unsigned int texture, size_t bytes);
+		void evict(int entry);
+		//Evicts until under budget
+		void trim();
+		void addRef(int entry);
+		void release(int entry);
+
+		std::vector<Entry> m_entries;
+		std::vector<int> m_freeEntries;
+		std::unordered_map<std::string, int> m_lookup;
+		size_t m_budgetBytes;
+		size_t m_residentBytes = 0;
+		int m_residentCount = 0;
+		unsigned int m_useCounter = 0;
+		unsigned int m_hits = 0;
+		unsigned int m_misses = 0;
+		unsigned int m_evictions = 0;
+	};
+}
@@ -0,0 +1,50 @@
+#include "uploadQueue.h"
+#include <chrono>
+
+namespace ew {
+	void UploadQueue::push(std::function<void()> upload)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(std::move(upload));
+	}
+
+	/// <summary>
+	/// The lock is only held to pop, so workers can keep queueing while an upload runs
+	/// </summary>
+	/// <param name="budgetMs">Milliseconds this frame may spend on uploads. A single upload may overrun it.</param>
+	int UploadQueue::drain(double budgetMs)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		double elapsedMs = 0.0;
+		int count = 0;
+		while (count == 0 || elapsedMs < budgetMs) {
+			std::function<void()> upload;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_queue.empty()) {
+					break;
+				}
+				upload = std::move(m_queue.front());
+				m_queue.pop_front();
+			}
+			upload();
+			count++;
+			m_completed++;
+			elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+		m_lastDrainMs = elapsedMs;
+		return count;
+	}
+
+	void UploadQueue::drainAll()
+	{
+		while (drain(1e9) > 0) {
+		}
+	}
+
+	size_t UploadQueue::getPendingCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_queue.size();
+	}
+}
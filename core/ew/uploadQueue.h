@@ -0,0 +1,29 @@
+#pragma once
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace ew {
+	/// <summary>
+	/// GL work produced on other threads (usually WorkerPool jobs) and run on the thread that owns the context.
+	/// The render loop drains it once per frame under a time budget so loading never causes a long frame.
+	/// </summary>
+	class UploadQueue {
+	public:
+		//Thread safe
+		void push(std::function<void()> upload);
+		//Runs queued uploads in order until budgetMs has passed, always at least one. Returns how many ran.
+		int drain(double budgetMs);
+		//Runs everything queued, including uploads queued while draining
+		void drainAll();
+		size_t getPendingCount();
+		//Time spent in the last drain
+		inline double getLastDrainMs()const { return m_lastDrainMs; }
+		inline unsigned int getCompletedCount()const { return m_completed; }
+	private:
+		std::mutex m_mutex;
+		std::deque<std::function<void()>> m_queue;
+		double m_lastDrainMs = 0.0;
+		unsigned int m_completed = 0;
+	};
+}
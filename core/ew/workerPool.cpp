@@ -0,0 +1,111 @@
+#include "workerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace ew {
+	WorkerPool::WorkerPool(int workerCount)
+	{
+		if (workerCount <= 0) {
+			workerCount = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+		}
+		for (int i = 0; i < workerCount; i++) {
+			m_workers.push_back(std::thread(&WorkerPool::workerLoop, this));
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_condition.notify_all();
+		for (std::thread& worker : m_workers) {
+			worker.join();
+		}
+	}
+
+	void WorkerPool::submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queue.push_back(std::move(job));
+		}
+		m_condition.notify_one();
+	}
+
+	/// <summary>
+	/// Indices are handed out through a shared counter, so uneven jobs balance themselves. Helpers that start
+	/// after the range is used up return immediately.
+	/// </summary>
+	void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& job)
+	{
+		if (count == 0) {
+			return;
+		}
+		struct Range {
+			std::atomic<size_t> next;
+			std::atomic<size_t> finished;
+			std::mutex mutex;
+			std::condition_variable done;
+		};
+		std::shared_ptr<Range> range = std::make_shared<Range>();
+		range->next = 0;
+		range->finished = 0;
+		const std::function<void(size_t)>* jobPtr = &job;
+		auto work = [range, count, jobPtr]() {
+			for (size_t i = range->next++; i < count; i = range->next++) {
+				(*jobPtr)(i);
+				if (++range->finished == count) {
+					std::lock_guard<std::mutex> lock(range->mutex);
+					range->done.notify_all();
+				}
+			}
+		};
+		size_t helpers = std::min(count - 1, m_workers.size());
+		for (size_t i = 0; i < helpers; i++) {
+			submit(work);
+		}
+		work();
+		std::unique_lock<std::mutex> lock(range->mutex);
+		range->done.wait(lock, [&range, count] { return range->finished == count; });
+	}
+
+	void WorkerPool::wait()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idleCondition.wait(lock, [this] { return m_queue.empty() && m_running == 0; });
+	}
+
+	WorkerPool& WorkerPool::getShared()
+	{
+		static WorkerPool pool;
+		return pool;
+	}
+
+	void WorkerPool::workerLoop()
+	{
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+				if (m_queue.empty()) {
+					break;
+				}
+				job = std::move(m_queue.front());
+				m_queue.pop_front();
+				m_running++;
+			}
+			job();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_running--;
+				if (m_queue.empty() && m_running == 0) {
+					m_idleCondition.notify_all();
+				}
+			}
+		}
+	}
+}
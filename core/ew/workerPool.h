@@ -0,0 +1,43 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ew {
+	/// <summary>
+	/// Fixed set of worker threads running CPU jobs (mesh processing, decoding). Jobs must not call GL,
+	/// queue GPU work on an UploadQueue instead.
+	/// </summary>
+	class WorkerPool {
+	public:
+		//0 workers means one per hardware thread besides the calling one
+		WorkerPool(int workerCount = 0);
+		//Finishes every queued job before joining
+		~WorkerPool();
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		void submit(std::function<void()> job);
+		//Runs job(i) for every i in [0, count) on the workers and the calling thread, returning when all are done.
+		//Safe to call from a job since the caller works through the range itself.
+		void parallelFor(size_t count, const std::function<void(size_t)>& job);
+		//Blocks until no job is queued or running
+		void wait();
+		inline int getWorkerCount()const { return (int)m_workers.size(); }
+		//Pool shared by loaders that aren't given one, created on first use
+		static WorkerPool& getShared();
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> m_workers;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::condition_variable m_idleCondition;
+		std::deque<std::function<void()>> m_queue;
+		int m_running = 0;
+		bool m_stopping = false;
+	};
+}
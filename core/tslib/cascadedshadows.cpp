@@ -0,0 +1,240 @@
+#include "cascadedshadows.h"
+#include "../ew/external/glad.h"
+#include <math.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace tslib {
+	static unsigned int clampCascadeCount(unsigned int numCascades) {
+		return numCascades < 1 ? 1 : (numCascades > MAX_SHADOW_CASCADES ? MAX_SHADOW_CASCADES : numCascades);
+	}
+
+	static unsigned int createDepthArray(unsigned int resolution, unsigned int layers) {
+		unsigned int texture;
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+		glTextureStorage3D(texture, 1, GL_DEPTH_COMPONENT16, resolution, resolution, layers);
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		float borderColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		glTextureParameterfv(texture, GL_TEXTURE_BORDER_COLOR, borderColor);
+		return texture;
+	}
+
+	static void createLayerFramebuffers(unsigned int texture, unsigned int layers, unsigned int* fbos) {
+		glCreateFramebuffers(layers, fbos);
+		for (unsigned int i = 0; i < layers; i++) {
+			glNamedFramebufferTextureLayer(fbos[i], GL_DEPTH_ATTACHMENT, texture, 0, i);
+			glNamedFramebufferDrawBuffer(fbos[i], GL_NONE);
+			glNamedFramebufferReadBuffer(fbos[i], GL_NONE);
+		}
+	}
+
+	CascadedShadowMap::CascadedShadowMap(unsigned int resolution, unsigned int numCascades)
+		: m_resolution(resolution), m_numCascades(clampCascadeCount(numCascades))
+	{
+		create();
+	}
+
+	CascadedShadowMap::~CascadedShadowMap()
+	{
+		destroyStatic();
+		destroy();
+	}
+
+	void CascadedShadowMap::resize(unsigned int resolution, unsigned int numCascades)
+	{
+		bool staticCaching = getStaticCaching();
+		destroyStatic();
+		destroy();
+		m_resolution = resolution;
+		m_numCascades = clampCascadeCount(numCascades);
+		create();
+		if (staticCaching) {
+			createStatic();
+		}
+	}
+
+	void CascadedShadowMap::create()
+	{
+		m_texture = createDepthArray(m_resolution, m_numCascades);
+		createLayerFramebuffers(m_texture, m_numCascades, m_fbos);
+		glGenTextures(m_numCascades, m_views);
+		for (unsigned int i = 0; i < m_numCascades; i++) {
+			glTextureView(m_views[i], GL_TEXTURE_2D, m_texture, GL_DEPTH_COMPONENT16, 0, 1, i, 1);
+		}
+	}
+
+	void CascadedShadowMap::destroy()
+	{
+		glDeleteFramebuffers(m_numCascades, m_fbos);
+		glDeleteTextures(m_numCascades, m_views);
+		glDeleteTextures(1, &m_texture);
+		for (unsigned int i = 0; i < MAX_SHADOW_CASCADES; i++) {
+			m_fbos[i] = m_views[i] = 0;
+		}
+		m_texture = 0;
+	}
+
+	void CascadedShadowMap::createStatic()
+	{
+		m_staticTexture = createDepthArray(m_resolution, m_numCascades);
+		createLayerFramebuffers(m_staticTexture, m_numCascades, m_staticFbos);
+		for (unsigned int i = 0; i < MAX_SHADOW_CASCADES; i++) {
+			m_staticDirty[i] = true;
+		}
+	}
+
+	void CascadedShadowMap::destroyStatic()
+	{
+		if (m_staticTexture == 0) {
+			return;
+		}
+		glDeleteFramebuffers(m_numCascades, m_staticFbos);
+		glDeleteTextures(1, &m_staticTexture);
+		for (unsigned int i = 0; i < MAX_SHADOW_CASCADES; i++) {
+			m_staticFbos[i] = 0;
+		}
+		m_staticTexture = 0;
+	}
+
+	void CascadedShadowMap::setStaticCaching(bool enabled)
+	{
+		if (enabled && m_staticTexture == 0) {
+			createStatic();
+		}
+		else if (!enabled) {
+			destroyStatic();
+		}
+	}
+
+	void CascadedShadowMap::invalidateStatic()
+	{
+		for (unsigned int i = 0; i < MAX_SHADOW_CASCADES; i++) {
+			m_staticDirty[i] = true;
+		}
+	}
+
+	/// <summary>
+	/// Splits blend between uniform, which wastes resolution up close, and logarithmic, which matches how
+	/// perspective shrinks texels but leaves the far cascades huge. Each cascade is the bounding sphere of its
+	/// slice, rounded so float error doesn't change its size, with the center snapped to the texel grid in light space.
+	/// A static cache stays valid only while the light camera is unchanged, so with caching the center snaps to a
+	/// coarser grid in all three axes and the cascade grows by one grid step to still cover its slice.
+	/// </summary>
+	void CascadedShadowMap::update(const ew::Camera& camera, const glm::vec3& lightDirection)
+	{
+		float nearPlane = camera.nearPlane;
+		float farPlane = glm::min(camera.farPlane, shadowDistance);
+		glm::mat4 invView = glm::inverse(camera.viewMatrix());
+		float tanHalfHeight = camera.orthographic ? 0.0f : tanf(glm::radians(camera.fov) * 0.5f);
+		float orthoHalfHeight = camera.orthographic ? camera.orthoHeight * 0.5f : 0.0f;
+
+		// The basis ew::Camera::viewMatrix builds looking along the light
+		glm::vec3 direction = glm::normalize(lightDirection);
+		glm::vec3 up = glm::vec3(0, 1, 0);
+		if (glm::abs(glm::dot(direction, up)) >= 1.0f - glm::epsilon<float>()) {
+			up = glm::vec3(0, 0, 1);
+		}
+		glm::mat3 lightRotation = glm::mat3(glm::lookAt(glm::vec3(0), direction, up));
+		bool staticCaching = getStaticCaching();
+		unsigned int snapTexels = staticCaching ? m_resolution / 16 : 1;
+		unsigned int paddingTexels = staticCaching ? snapTexels : 0;
+
+		float sliceNear = nearPlane;
+		for (unsigned int i = 0; i < m_numCascades; i++) {
+			float p = (float)(i + 1) / m_numCascades;
+			float logSplit = nearPlane * powf(farPlane / nearPlane, p);
+			float uniformSplit = nearPlane + (farPlane - nearPlane) * p;
+			float sliceFar = glm::mix(uniformSplit, logSplit, splitLambda);
+			m_splits[i] = sliceFar;
+
+			glm::vec3 corners[8];
+			glm::vec3 center = glm::vec3(0);
+			for (int c = 0; c < 8; c++) {
+				float depth = c < 4 ? sliceNear : sliceFar;
+				float halfHeight = depth * tanHalfHeight + orthoHalfHeight;
+				float halfWidth = halfHeight * camera.aspectRatio;
+				glm::vec4 corner = invView * glm::vec4((c & 1) ? halfWidth : -halfWidth, (c & 2) ? halfHeight : -halfHeight, -depth, 1.0f);
+				corners[c] = glm::vec3(corner);
+				center += corners[c] / 8.0f;
+			}
+			float radius = 0.0f;
+			for (const glm::vec3& corner : corners) {
+				radius = glm::max(radius, glm::length(corner - center));
+			}
+			radius = ceilf(radius * 16.0f) / 16.0f;
+
+			float texelSize = radius * 2.0f / (m_resolution - paddingTexels * 2);
+			float snapSize = texelSize * snapTexels;
+			float halfExtent = texelSize * m_resolution * 0.5f;
+			glm::vec3 lightCenter = lightRotation * center;
+			lightCenter.x = floorf(lightCenter.x / snapSize) * snapSize;
+			lightCenter.y = floorf(lightCenter.y / snapSize) * snapSize;
+			if (staticCaching) {
+				lightCenter.z = floorf(lightCenter.z / snapSize) * snapSize;
+			}
+			center = glm::transpose(lightRotation) * lightCenter;
+
+			ew::Camera& cascade = m_cameras[i];
+			cascade.orthographic = true;
+			cascade.aspectRatio = 1.0f;
+			cascade.orthoHeight = halfExtent * 2.0f;
+			cascade.target = center;
+			cascade.position = center - direction * (halfExtent + casterDistance);
+			cascade.nearPlane = 0.0f;
+			cascade.farPlane = halfExtent * 2.0f + casterDistance;
+
+			if (staticCaching) {
+				m_staticDirty[i] = m_staticDirty[i] || getViewProjection(i) != m_staticViewProj[i];
+				if (!m_staticDirty[i]) {
+					m_staticReuses[i]++;
+				}
+			}
+
+			sliceNear = sliceFar;
+		}
+	}
+
+	void CascadedShadowMap::bindCascade(unsigned int cascade) const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbos[cascade]);
+		glViewport(0, 0, m_resolution, m_resolution);
+	}
+
+	void CascadedShadowMap::bindStaticCascade(unsigned int cascade)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_staticFbos[cascade]);
+		glViewport(0, 0, m_resolution, m_resolution);
+		m_staticViewProj[cascade] = getViewProjection(cascade);
+		m_staticDirty[cascade] = false;
+		m_staticRefreshes[cascade]++;
+	}
+
+	void CascadedShadowMap::copyStaticCascade(unsigned int cascade) const
+	{
+		glCopyImageSubData(m_staticTexture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascade,
+			m_texture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascade, m_resolution, m_resolution, 1);
+	}
+
+	/// <summary>
+	/// Array uniforms are set with one call each from their base location, the names are hashed at compile time
+	/// </summary>
+	void CascadedShadowMap::setUniforms(const ew::Shader& shader, int textureUnit) const
+	{
+		constexpr unsigned int SHADOW_MAP = ew::uniformHash("_ShadowMap");
+		constexpr unsigned int NUM_CASCADES = ew::uniformHash("_NumCascades");
+		constexpr unsigned int CASCADE_SPLITS = ew::uniformHash("_CascadeSplits");
+		constexpr unsigned int CASCADE_VIEW_PROJ = ew::uniformHash("_CascadeViewProj");
+
+		glm::mat4 viewProjections[MAX_SHADOW_CASCADES];
+		for (unsigned int i = 0; i < m_numCascades; i++) {
+			viewProjections[i] = getViewProjection(i);
+		}
+		glBindTextureUnit(textureUnit, m_texture);
+		shader.setInt(shader.getUniformLocation(SHADOW_MAP), textureUnit);
+		shader.setInt(shader.getUniformLocation(NUM_CASCADES), m_numCascades);
+		glUniform1fv(shader.getUniformLocation(CASCADE_SPLITS).location, m_numCascades, m_splits);
+		glUniformMatrix4fv(shader.getUniformLocation(CASCADE_VIEW_PROJ).location, m_numCascades, GL_FALSE, &viewProjections[0][0][0]);
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "../ew/camera.h"
+#include "../ew/shader.h"
+
+namespace tslib {
+	// Must match MAX_CASCADES in the lighting shaders
+	const unsigned int MAX_SHADOW_CASCADES = 4;
+
+	// Directional light shadows split along the view into cascades, each an orthographic map of its own slice of
+	// the camera frustum, all layers of one depth GL_TEXTURE_2D_ARRAY. Near cascades cover little ground so their
+	// texels are small. Each cascade is a sphere around its slice, so rotating the camera doesn't resize it,
+	// and its center moves in whole texels so the map doesn't shimmer as the camera moves.
+	//
+	// With static caching, casters that rarely move draw into a second array that is only redrawn when a cascade's
+	// light camera changes or invalidateStatic() is called. Each frame the cached depth is copied into the shadow map
+	// and dynamic casters draw over it. Cascades then move in steps of 1/16 of the map, padded by as much, so the
+	// cache survives small camera moves at the cost of texels about 14% larger.
+	class CascadedShadowMap {
+	public:
+		CascadedShadowMap(unsigned int resolution, unsigned int numCascades = 3);
+		~CascadedShadowMap();
+		CascadedShadowMap(const CascadedShadowMap&) = delete;
+		CascadedShadowMap& operator=(const CascadedShadowMap&) = delete;
+
+		// Recreates the texture array
+		void resize(unsigned int resolution, unsigned int numCascades);
+		// Splits camera's frustum out to shadowDistance and fits a cascade to each slice
+		void update(const ew::Camera& camera, const glm::vec3& lightDirection);
+		// Binds one layer as the depth attachment and sets the viewport to it
+		void bindCascade(unsigned int cascade) const;
+		// Sets _ShadowMap, _NumCascades, _CascadeSplits[] and _CascadeViewProj[], binds the array to textureUnit
+		void setUniforms(const ew::Shader& shader, int textureUnit) const;
+
+		// Creates or frees the static caster cache, takes effect on the next update()
+		void setStaticCaching(bool enabled);
+		inline bool getStaticCaching() const { return m_staticTexture != 0; }
+		// Static casters moved, every cascade redraws them. Call before update() so the frame isn't counted as reused.
+		void invalidateStatic();
+		// True when the cascade's static casters must be redrawn this frame
+		inline bool needsStaticRefresh(unsigned int cascade) const { return m_staticDirty[cascade]; }
+		// Binds the cascade's static layer like bindCascade and marks it up to date, the caller clears and draws into it
+		void bindStaticCascade(unsigned int cascade);
+		// Replaces the cascade's shadow map layer with its static layer, dynamic casters then draw over it
+		void copyStaticCascade(unsigned int cascade) const;
+		inline unsigned int getStaticTexture() const { return m_staticTexture; }
+		// Frames the cascade's static casters were redrawn, and frames the cache was used as is
+		inline unsigned int getStaticRefreshCount(unsigned int cascade) const { return m_staticRefreshes[cascade]; }
+		inline unsigned int getStaticReuseCount(unsigned int cascade) const { return m_staticReuses[cascade]; }
+
+		// Orthographic light camera over a cascade, for rendering, culling casters and selecting their detail
+		inline const ew::Camera& getCamera(unsigned int cascade) const { return m_cameras[cascade]; }
+		inline glm::mat4 getViewProjection(unsigned int cascade) const { return m_cameras[cascade].projectionMatrix() * m_cameras[cascade].viewMatrix(); }
+		// View depth where the cascade ends
+		inline float getSplit(unsigned int cascade) const { return m_splits[cascade]; }
+		// World units covered by one texel
+		inline float getTexelSize(unsigned int cascade) const { return m_cameras[cascade].orthoHeight / m_resolution; }
+		inline unsigned int getTexture() const { return m_texture; }
+		// 2D view of one layer, for debug display
+		inline unsigned int getCascadeView(unsigned int cascade) const { return m_views[cascade]; }
+		inline unsigned int getResolution() const { return m_resolution; }
+		inline unsigned int getCascadeCount() const { return m_numCascades; }
+		inline unsigned int getTexelCount() const { return m_resolution * m_resolution * m_numCascades; }
+
+		float splitLambda = 0.75f;		// 0 splits the distance evenly, 1 logarithmically
+		float shadowDistance = 40.0f;	// Nothing is shadowed past this, clamped to the camera's far plane
+		float casterDistance = 20.0f;	// How far toward the light casters outside a slice still shadow it
+	private:
+		void create();
+		void destroy();
+		void createStatic();
+		void destroyStatic();
+
+		unsigned int m_texture = 0;
+		unsigned int m_fbos[MAX_SHADOW_CASCADES] = {};
+		unsigned int m_views[MAX_SHADOW_CASCADES] = {};
+		unsigned int m_staticTexture = 0;
+		unsigned int m_staticFbos[MAX_SHADOW_CASCADES] = {};
+		glm::mat4 m_staticViewProj[MAX_SHADOW_CASCADES]; // Light camera the static layer was drawn with
+		bool m_staticDirty[MAX_SHADOW_CASCADES] = {};
+		unsigned int m_staticRefreshes[MAX_SHADOW_CASCADES] = {};
+		unsigned int m_staticReuses[MAX_SHADOW_CASCADES] = {};
+		unsigned int m_resolution;
+		unsigned int m_numCascades;
+		ew::Camera m_cameras[MAX_SHADOW_CASCADES];
+		float m_splits[MAX_SHADOW_CASCADES] = {};
+	};
+}
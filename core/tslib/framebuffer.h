@@ -9,9 +9,33 @@ namespace tslib {
 		unsigned int depthBuffer;
 		unsigned int width;
 		unsigned int height;
+		unsigned int numColorBuffers = 1;
 	};
 
-	Framebuffer createFramebuffer(unsigned int width, unsigned int height, int colorFormat) {
+	// Attachments written by geometryPass.frag and read by the lighting pass
+	enum class GBufferLayout {
+		FULL,	// 0 = RGB32F world position, 1 = RGB16F world normal, 2 = RGB16F albedo, 16 bit depth
+		COMPACT	// 0 = RG16_SNORM octahedral normal, 1 = RGBA8 albedo + material bits, 24 bit depth.
+				// Shaders compiled with COMPACT_GBUFFER 1 rebuild world position from depth.
+	};
+
+	// Formats of a layout's attachments, returns the number of color attachments
+	inline unsigned int getGBufferFormats(GBufferLayout layout, int colorFormats[3], int& depthFormat) {
+		if (layout == GBufferLayout::COMPACT) {
+			colorFormats[0] = GL_RG16_SNORM;	// 0 = Octahedral World Normal
+			colorFormats[1] = GL_RGBA8;			// 1 = Albedo + Material Bits
+			// Positions come from depth, 16 bits bands visibly at a distance
+			depthFormat = GL_DEPTH_COMPONENT24;
+			return 2;
+		}
+		colorFormats[0] = GL_RGB32F; // 0 = World Position 
+		colorFormats[1] = GL_RGB16F; // 1 = World Normal
+		colorFormats[2] = GL_RGB16F; // 2 = Albedo
+		depthFormat = GL_DEPTH_COMPONENT16;
+		return 3;
+	}
+
+	inline Framebuffer createFramebuffer(unsigned int width, unsigned int height, int colorFormat) {
 		Framebuffer fb = Framebuffer();
 
 		glCreateFramebuffers(1, &fb.fbo);
@@ -36,7 +60,7 @@ namespace tslib {
 		return fb;
 	}
 
-	Framebuffer createGBuffer(unsigned int width, unsigned int height) {
+	inline Framebuffer createGBuffer(unsigned int width, unsigned int height, GBufferLayout layout = GBufferLayout::FULL) {
 		Framebuffer framebuffer;
 		framebuffer.width = width;
 		framebuffer.height = height;
@@ -44,13 +68,11 @@ namespace tslib {
 		glCreateFramebuffers(1, &framebuffer.fbo);
 		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
 
-		int formats[3] = {
-			GL_RGB32F, // 0 = World Position 
-			GL_RGB16F, // 1 = World Normal
-			GL_RGB16F  // 2 = Albedo
-		};
+		int formats[3];
+		int depthFormat;
+		framebuffer.numColorBuffers = getGBufferFormats(layout, formats, depthFormat);
 
-		for (size_t i = 0; i < 3; i++)
+		for (size_t i = 0; i < framebuffer.numColorBuffers; i++)
 		{
 			glGenTextures(1, &framebuffer.colorBuffers[i]);
 			glBindTexture(GL_TEXTURE_2D, framebuffer.colorBuffers[i]);
@@ -67,15 +89,39 @@ namespace tslib {
 		const GLenum drawBuffers[3] = {
 				GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2
 		};
-		glDrawBuffers(3, drawBuffers);
+		glDrawBuffers(framebuffer.numColorBuffers, drawBuffers);
 
 		glGenTextures(1, &framebuffer.depthBuffer);
 		glBindTexture(GL_TEXTURE_2D, framebuffer.depthBuffer);
-		glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT16, width, height);
+		glTexStorage2D(GL_TEXTURE_2D, 1, depthFormat, width, height);
 		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, framebuffer.depthBuffer, 0);
 
 		glBindTexture(GL_TEXTURE_2D, 0);
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		return framebuffer;
 	}
+
+	inline void deleteFramebuffer(Framebuffer& framebuffer) {
+		glDeleteTextures(framebuffer.numColorBuffers, framebuffer.colorBuffers);
+		glDeleteTextures(1, &framebuffer.depthBuffer);
+		glDeleteFramebuffers(1, &framebuffer.fbo);
+		framebuffer = Framebuffer();
+	}
+
+	// Bytes per pixel across every attachment, from the component sizes the driver reports for them
+	inline unsigned int getBytesPerPixel(const Framebuffer& framebuffer) {
+		const GLenum sizeParams[6] = {
+			GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE, GL_TEXTURE_ALPHA_SIZE, GL_TEXTURE_DEPTH_SIZE, GL_TEXTURE_STENCIL_SIZE
+		};
+		unsigned int bits = 0;
+		for (unsigned int i = 0; i <= framebuffer.numColorBuffers; i++) {
+			unsigned int texture = i < framebuffer.numColorBuffers ? framebuffer.colorBuffers[i] : framebuffer.depthBuffer;
+			for (GLenum param : sizeParams) {
+				int size = 0;
+				glGetTextureLevelParameteriv(texture, 0, param, &size);
+				bits += size;
+			}
+		}
+		return bits / 8;
+	}
 }
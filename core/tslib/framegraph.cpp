@@ -0,0 +1,443 @@
+#include "framegraph.h"
+#include "../ew/external/glad.h"
+#include <stdio.h>
+#include <chrono>
+
+namespace tslib {
+	FrameGraphPassBuilder& FrameGraphPassBuilder::read(FrameGraphResource resource)
+	{
+		if (resource.valid()) {
+			m_graph->m_passes[m_pass].reads.push_back(resource.index);
+		}
+		return *this;
+	}
+
+	FrameGraphPassBuilder& FrameGraphPassBuilder::write(FrameGraphResource resource)
+	{
+		if (resource.valid()) {
+			m_graph->m_passes[m_pass].writes.push_back(resource.index);
+			m_graph->m_resources[resource.index].writers.push_back(m_pass);
+		}
+		return *this;
+	}
+
+	FrameGraphPassBuilder& FrameGraphPassBuilder::sideEffect()
+	{
+		m_graph->m_passes[m_pass].sideEffect = true;
+		return *this;
+	}
+
+	FrameGraph::FrameGraph(RenderTargetPool& pool)
+		: m_pool(pool)
+	{
+	}
+
+	FrameGraph::~FrameGraph()
+	{
+		for (auto& timer : m_timers) {
+			glDeleteQueries(TIMER_QUERIES, timer.second.queries);
+		}
+	}
+
+	void FrameGraph::reset()
+	{
+		m_resources.clear();
+		m_passes.clear();
+		m_order.clear();
+		m_compiled = false;
+	}
+
+	FrameGraphResource FrameGraph::createTexture(const std::string& name, const RenderTargetDesc& desc)
+	{
+		Resource resource = Resource();
+		resource.name = name;
+		resource.kind = ResourceKind::TRANSIENT;
+		resource.desc = desc;
+		m_resources.push_back(resource);
+		FrameGraphResource handle;
+		handle.index = (int)m_resources.size() - 1;
+		return handle;
+	}
+
+	FrameGraphResource FrameGraph::importTarget(const std::string& name, const Framebuffer& framebuffer)
+	{
+		Resource resource = Resource();
+		resource.name = name;
+		resource.kind = ResourceKind::TARGET;
+		resource.target = framebuffer;
+		m_resources.push_back(resource);
+		FrameGraphResource handle;
+		handle.index = (int)m_resources.size() - 1;
+		return handle;
+	}
+
+	FrameGraphResource FrameGraph::importTexture(const std::string& name, unsigned int texture)
+	{
+		Resource resource = Resource();
+		resource.name = name;
+		resource.kind = ResourceKind::TEXTURE;
+		resource.handle = texture;
+		m_resources.push_back(resource);
+		FrameGraphResource handle;
+		handle.index = (int)m_resources.size() - 1;
+		return handle;
+	}
+
+	FrameGraphResource FrameGraph::importBuffer(const std::string& name, unsigned int buffer)
+	{
+		Resource resource = Resource();
+		resource.name = name;
+		resource.kind = ResourceKind::BUFFER;
+		resource.handle = buffer;
+		m_resources.push_back(resource);
+		FrameGraphResource handle;
+		handle.index = (int)m_resources.size() - 1;
+		return handle;
+	}
+
+	/// <summary>
+	/// Declares a pass. Nothing runs until execute(), so the callback must capture what it needs by reference
+	/// and fetch graph textures with getTexture() when it is called. A pass that draws over what earlier passes
+	/// wrote should read that resource as well as write it, otherwise those passes can be culled.
+	/// </summary>
+	FrameGraphPassBuilder FrameGraph::addPass(const std::string& name, PassType type, std::function<void()> execute)
+	{
+		Pass pass = Pass();
+		pass.name = name;
+		pass.type = type;
+		pass.execute = execute;
+		m_passes.push_back(pass);
+		m_compiled = false;
+		return FrameGraphPassBuilder(this, (int)m_passes.size() - 1);
+	}
+
+	/// <summary>
+	/// Culls passes that don't contribute to a side effect pass, then sorts the rest. Writers of a resource
+	/// run in the order they were declared. A pass that only reads it runs after the last writer declared
+	/// before it and before the next one, or after the last writer if it was declared before all of them.
+	/// Ties keep declaration order, so a graph declared in a valid order runs in that order.
+	/// </summary>
+	void FrameGraph::compile()
+	{
+		// Walk back from the side effect passes through the writers of everything they read
+		std::vector<int> stack;
+		for (size_t i = 0; i < m_passes.size(); i++) {
+			m_passes[i].alive = m_passes[i].sideEffect;
+			if (m_passes[i].alive) {
+				stack.push_back((int)i);
+			}
+		}
+		while (!stack.empty()) {
+			int pass = stack.back();
+			stack.pop_back();
+			for (int read : m_passes[pass].reads) {
+				for (int writer : m_resources[read].writers) {
+					if (!m_passes[writer].alive) {
+						m_passes[writer].alive = true;
+						stack.push_back(writer);
+					}
+				}
+			}
+		}
+
+		std::vector<std::vector<int>> successors(m_passes.size());
+		std::vector<int> inDegree(m_passes.size(), 0);
+		auto addEdge = [&](int from, int to) {
+			successors[from].push_back(to);
+			inDegree[to]++;
+		};
+		for (size_t r = 0; r < m_resources.size(); r++) {
+			// Walked in declaration order. A reader sees the latest writer declared before it, and the next
+			// writer waits for it so it doesn't overwrite the contents early (write-after-read).
+			int lastWriter = -1;
+			std::vector<int> readersSinceWrite;
+			std::vector<int> readersBeforeWrite;
+			for (size_t p = 0; p < m_passes.size(); p++) {
+				const Pass& pass = m_passes[p];
+				if (!pass.alive) {
+					continue;
+				}
+				bool reads = false, writes = false;
+				for (int read : pass.reads) {
+					reads = reads || read == (int)r;
+				}
+				for (int write : pass.writes) {
+					writes = writes || write == (int)r;
+				}
+				if (writes) {
+					if (lastWriter >= 0) {
+						addEdge(lastWriter, (int)p);
+					}
+					for (int reader : readersSinceWrite) {
+						addEdge(reader, (int)p);
+					}
+					readersSinceWrite.clear();
+					lastWriter = (int)p;
+				}
+				else if (reads && lastWriter >= 0) {
+					addEdge(lastWriter, (int)p);
+					readersSinceWrite.push_back((int)p);
+				}
+				else if (reads) {
+					readersBeforeWrite.push_back((int)p);
+				}
+			}
+			// Read before any writer was declared, so it reads what the last writer leaves
+			if (lastWriter >= 0) {
+				for (int reader : readersBeforeWrite) {
+					addEdge(lastWriter, reader);
+				}
+			}
+		}
+
+		// Kahn's algorithm, always taking the earliest declared pass that is ready
+		m_order.clear();
+		std::vector<bool> scheduled(m_passes.size(), false);
+		while (true) {
+			int next = -1;
+			for (size_t p = 0; p < m_passes.size(); p++) {
+				if (m_passes[p].alive && !scheduled[p] && inDegree[p] == 0) {
+					next = (int)p;
+					break;
+				}
+			}
+			if (next < 0) {
+				break;
+			}
+			scheduled[next] = true;
+			m_order.push_back(next);
+			for (int successor : successors[next]) {
+				inDegree[successor]--;
+			}
+		}
+		for (size_t p = 0; p < m_passes.size(); p++) {
+			if (m_passes[p].alive && !scheduled[p]) {
+				printf("Frame graph pass %s is part of a dependency cycle, running it in declaration order\n", m_passes[p].name.c_str());
+				m_order.push_back((int)p);
+			}
+		}
+
+		for (Resource& resource : m_resources) {
+			resource.firstUse = -1;
+			resource.lastUse = -1;
+			resource.computeWritten = false;
+			resource.readSinceBarrier = false;
+		}
+		for (size_t i = 0; i < m_order.size(); i++) {
+			const Pass& pass = m_passes[m_order[i]];
+			for (const std::vector<int>* uses : { &pass.reads, &pass.writes }) {
+				for (int use : *uses) {
+					Resource& resource = m_resources[use];
+					resource.firstUse = resource.firstUse < 0 ? (int)i : resource.firstUse;
+					resource.lastUse = (int)i;
+				}
+			}
+		}
+
+		m_timings.clear();
+		for (int p : m_order) {
+			PassTiming timing = { m_passes[p].name, false, 0.0f, 0.0f };
+			m_timings.push_back(timing);
+		}
+		for (const Pass& pass : m_passes) {
+			if (!pass.alive) {
+				PassTiming timing = { pass.name, true, 0.0f, 0.0f };
+				m_timings.push_back(timing);
+			}
+		}
+		m_compiled = true;
+	}
+
+	void FrameGraph::execute()
+	{
+		if (!m_compiled) {
+			compile();
+		}
+		m_barrierCount = 0;
+		for (size_t i = 0; i < m_order.size(); i++) {
+			const Pass& pass = m_passes[m_order[i]];
+			for (Resource& resource : m_resources) {
+				if (resource.kind == ResourceKind::TRANSIENT && resource.firstUse == (int)i) {
+					resource.handle = m_pool.acquire(resource.desc);
+				}
+			}
+
+			insertBarrier(pass);
+			if (pass.type == PassType::RASTER) {
+				bindFramebuffer(pass);
+			}
+
+			// Skip timing rather than wait on a query the GPU hasn't finished
+			PassTimer& timer = getTimer(pass.name);
+			for (int q = 0; q < TIMER_QUERIES; q++) {
+				GLint available = 0;
+				if (timer.pending[q]) {
+					glGetQueryObjectiv(timer.queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+				}
+				if (available) {
+					GLuint64 elapsed;
+					glGetQueryObjectui64v(timer.queries[q], GL_QUERY_RESULT, &elapsed);
+					timer.gpuMs = elapsed / 1000000.0f;
+					timer.pending[q] = false;
+				}
+			}
+			int query = timer.pending[timer.next] ? -1 : timer.next;
+			if (query >= 0) {
+				glBeginQuery(GL_TIME_ELAPSED, timer.queries[query]);
+			}
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			pass.execute();
+			float cpuMs = (float)std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			if (query >= 0) {
+				glEndQuery(GL_TIME_ELAPSED);
+				timer.pending[query] = true;
+				timer.next = (query + 1) % TIMER_QUERIES;
+			}
+			m_timings[i].cpuMs = cpuMs;
+			m_timings[i].gpuMs = timer.gpuMs;
+
+			if (pass.type == PassType::COMPUTE) {
+				for (int write : pass.writes) {
+					m_resources[write].computeWritten = true;
+				}
+			}
+			for (int read : pass.reads) {
+				m_resources[read].readSinceBarrier = true;
+			}
+			for (Resource& resource : m_resources) {
+				if (resource.kind == ResourceKind::TRANSIENT && resource.lastUse == (int)i) {
+					m_pool.release(resource.handle);
+					resource.handle = 0;
+				}
+			}
+		}
+		m_framebuffer = Framebuffer();
+	}
+
+	//Raster passes that only write buffers or imported textures keep whatever framebuffer is bound
+	void FrameGraph::bindFramebuffer(const Pass& pass)
+	{
+		Framebuffer framebuffer = Framebuffer();
+		framebuffer.numColorBuffers = 0;
+		framebuffer.colorBuffers[0] = framebuffer.colorBuffers[1] = framebuffer.colorBuffers[2] = 0;
+		const Resource* imported = nullptr;
+		bool transient = false;
+		for (int write : pass.writes) {
+			const Resource& resource = m_resources[write];
+			if (resource.kind == ResourceKind::TARGET) {
+				imported = &resource;
+			}
+			else if (resource.kind == ResourceKind::TRANSIENT) {
+				if (resource.desc.usage == RenderTargetUsage::DEPTH) {
+					framebuffer.depthBuffer = resource.handle;
+				}
+				else if (framebuffer.numColorBuffers < 3) {
+					framebuffer.colorBuffers[framebuffer.numColorBuffers++] = resource.handle;
+				}
+				else {
+					printf("Frame graph pass %s writes more than 3 color targets\n", pass.name.c_str());
+				}
+				m_pool.getSize(resource.desc, framebuffer.width, framebuffer.height);
+				transient = true;
+			}
+		}
+
+		if (imported != nullptr) {
+			if (transient) {
+				printf("Frame graph pass %s writes %s and transient targets, only %s is bound\n", pass.name.c_str(), imported->name.c_str(), imported->name.c_str());
+			}
+			framebuffer = imported->target;
+		}
+		else if (transient) {
+			framebuffer.fbo = m_pool.getFramebuffer(framebuffer);
+		}
+		else {
+			return;
+		}
+		m_framebuffer = framebuffer;
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+		glViewport(0, 0, framebuffer.width, framebuffer.height);
+	}
+
+	/// <summary>
+	/// Compute writes aren't visible to later passes until a barrier for the way they are used next.
+	/// Textures may be sampled, loaded as images or attached, buffers are read as storage buffers.
+	/// Compute stores aren't ordered after earlier reads either, so a compute pass overwriting something
+	/// read since the last barrier gets one too.
+	/// </summary>
+	void FrameGraph::insertBarrier(const Pass& pass)
+	{
+		GLbitfield barriers = 0;
+		for (const std::vector<int>* uses : { &pass.reads, &pass.writes }) {
+			for (int use : *uses) {
+				Resource& resource = m_resources[use];
+				bool writeAfterRead = pass.type == PassType::COMPUTE && uses == &pass.writes && resource.readSinceBarrier;
+				if (!resource.computeWritten && !writeAfterRead) {
+					continue;
+				}
+				if (resource.kind == ResourceKind::BUFFER) {
+					barriers |= GL_SHADER_STORAGE_BARRIER_BIT;
+				}
+				else {
+					barriers |= GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT;
+				}
+				resource.computeWritten = false;
+				resource.readSinceBarrier = false;
+			}
+		}
+		if (barriers != 0) {
+			glMemoryBarrier(barriers);
+			m_barrierCount++;
+		}
+	}
+
+	FrameGraph::PassTimer& FrameGraph::getTimer(const std::string& name)
+	{
+		auto it = m_timers.find(name);
+		if (it != m_timers.end()) {
+			return it->second;
+		}
+		PassTimer timer = PassTimer();
+		glGenQueries(TIMER_QUERIES, timer.queries);
+		return m_timers[name] = timer;
+	}
+
+	unsigned int FrameGraph::getTexture(FrameGraphResource resource) const
+	{
+		const Resource& r = m_resources[resource.index];
+		if (r.kind == ResourceKind::TARGET) {
+			return r.target.numColorBuffers > 0 ? r.target.colorBuffers[0] : r.target.depthBuffer;
+		}
+		return r.kind != ResourceKind::BUFFER ? r.handle : 0;
+	}
+
+	unsigned int FrameGraph::getBuffer(FrameGraphResource resource) const
+	{
+		const Resource& r = m_resources[resource.index];
+		return r.kind == ResourceKind::BUFFER ? r.handle : 0;
+	}
+
+	float FrameGraph::getGpuMs(const std::string& passName) const
+	{
+		auto it = m_timers.find(passName);
+		return it != m_timers.end() ? it->second.gpuMs : 0.0f;
+	}
+
+	void FrameGraph::printTimings() const
+	{
+		float gpuMs = 0.0f, cpuMs = 0.0f;
+		unsigned int culled = 0;
+		for (const PassTiming& timing : m_timings) {
+			if (timing.culled) {
+				printf("  %-20s culled\n", timing.name.c_str());
+				culled++;
+				continue;
+			}
+			printf("  %-20s GPU %7.3f ms  CPU %7.3f ms\n", timing.name.c_str(), timing.gpuMs, timing.cpuMs);
+			gpuMs += timing.gpuMs;
+			cpuMs += timing.cpuMs;
+		}
+		printf("Frame graph: %u passes run, %u culled, %u barriers, GPU %.3f ms, CPU %.3f ms\n",
+			(unsigned int)(m_timings.size() - culled), culled, m_barrierCount, gpuMs, cpuMs);
+	}
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "framebuffer.h"
+#include "rendertargets.h"
+
+namespace tslib {
+	enum class PassType {
+		RASTER,	// Draws into the textures it writes, bound as attachments in the order written
+		COMPUTE	// Dispatches, what it writes gets a memory barrier before the next pass that uses it
+	};
+
+	// Texture or buffer declared on a FrameGraph, only valid until the next reset()
+	struct FrameGraphResource {
+		int index = -1;
+		inline bool valid() const { return index >= 0; }
+	};
+
+	class FrameGraph;
+
+	// Returned by FrameGraph::addPass to declare what the pass touches
+	class FrameGraphPassBuilder {
+	public:
+		FrameGraphPassBuilder(FrameGraph* graph, int pass) : m_graph(graph), m_pass(pass) {}
+		// Sampled, fetched or loaded by the pass
+		FrameGraphPassBuilder& read(FrameGraphResource resource);
+		// Rendered to or stored to by the pass
+		FrameGraphPassBuilder& write(FrameGraphResource resource);
+		// Never culled, for passes that present or read back
+		FrameGraphPassBuilder& sideEffect();
+	private:
+		FrameGraph* m_graph;
+		int m_pass;
+	};
+
+	// Per frame list of render passes that declare the resources they read and write.
+	// compile() drops passes none of whose outputs reach a side effect pass, and orders the rest so every writer
+	// of a resource runs before its readers, keeping declaration order otherwise. execute() acquires transient
+	// textures from the pool just before their first use and releases them after their last, so passes that
+	// don't overlap share memory, binds each raster pass's attachments and inserts memory barriers after compute.
+	class FrameGraph {
+	public:
+		struct PassTiming {
+			std::string name;
+			bool culled;
+			float cpuMs;
+			float gpuMs; // From queries a frame or two old, the pass is never stalled on
+		};
+
+		FrameGraph(RenderTargetPool& pool);
+		~FrameGraph();
+		FrameGraph(const FrameGraph&) = delete;
+		FrameGraph& operator=(const FrameGraph&) = delete;
+
+		// Clears last frame's passes and resources, timings are kept
+		void reset();
+
+		// Acquired from the pool for the passes that use it
+		FrameGraphResource createTexture(const std::string& name, const RenderTargetDesc& desc);
+		// Render target owned outside the graph, an fbo of 0 is the default framebuffer
+		FrameGraphResource importTarget(const std::string& name, const Framebuffer& framebuffer);
+		// Texture owned outside the graph, raster passes writing it bind their own framebuffer, e.g. one layer at a time
+		FrameGraphResource importTexture(const std::string& name, unsigned int texture);
+		FrameGraphResource importBuffer(const std::string& name, unsigned int buffer);
+
+		FrameGraphPassBuilder addPass(const std::string& name, PassType type, std::function<void()> execute);
+
+		void compile();
+		void execute();
+
+		// Handles are only valid while a pass that uses them executes
+		unsigned int getTexture(FrameGraphResource resource) const;
+		unsigned int getBuffer(FrameGraphResource resource) const;
+		// Attachments of the executing raster pass
+		inline const Framebuffer& getFramebuffer() const { return m_framebuffer; }
+
+		// Passes in execution order followed by the culled ones
+		inline const std::vector<PassTiming>& getTimings() const { return m_timings; }
+		float getGpuMs(const std::string& passName) const;
+		inline unsigned int getBarrierCount() const { return m_barrierCount; }
+		void printTimings() const;
+	private:
+		friend class FrameGraphPassBuilder;
+
+		enum class ResourceKind {
+			TRANSIENT,
+			TARGET,
+			TEXTURE,
+			BUFFER
+		};
+		struct Resource {
+			std::string name;
+			ResourceKind kind;
+			RenderTargetDesc desc;
+			Framebuffer target;
+			unsigned int handle; // Imported textures and buffers, transient textures once acquired
+			std::vector<int> writers;
+			int firstUse;
+			int lastUse;
+			bool computeWritten; // Written by a compute pass with no barrier since
+			bool readSinceBarrier; // Read by a pass with no barrier since, a compute store must wait for it
+		};
+		struct Pass {
+			std::string name;
+			PassType type;
+			std::function<void()> execute;
+			std::vector<int> reads;
+			std::vector<int> writes;
+			bool sideEffect;
+			bool alive;
+		};
+		// GL_TIME_ELAPSED queries rotate so a pending result never blocks the next frame
+		static const int TIMER_QUERIES = 3;
+		struct PassTimer {
+			unsigned int queries[TIMER_QUERIES];
+			bool pending[TIMER_QUERIES];
+			int next;
+			float gpuMs;
+		};
+
+		void bindFramebuffer(const Pass& pass);
+		void insertBarrier(const Pass& pass);
+		PassTimer& getTimer(const std::string& name);
+
+		RenderTargetPool& m_pool;
+		std::vector<Resource> m_resources;
+		std::vector<Pass> m_passes;
+		std::vector<int> m_order;
+		bool m_compiled = false;
+		Framebuffer m_framebuffer;
+		std::map<std::string, PassTimer> m_timers;
+		std::vector<PassTiming> m_timings;
+		unsigned int m_barrierCount = 0;
+	};
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../ew/external/glad.h"
+
+namespace tslib {
+	// Must match TILE_SIZE and MAX_LIGHTS_PER_TILE in lightCulling.comp / tiledDeferredLit.frag
+	const unsigned int LIGHT_TILE_SIZE = 16;
+	const unsigned int MAX_LIGHTS_PER_TILE = 256;
+
+	// Per screen tile light lists written by the light culling compute pass.
+	// Each tile stores [count, index0, index1, ...] with a stride of maxLightsPerTile + 1 uints
+	struct LightTiles {
+		unsigned int ssbo;
+		unsigned int numTilesX;
+		unsigned int numTilesY;
+		unsigned int width;
+		unsigned int height;
+		unsigned int maxLightsPerTile; // Shaders must be compiled with MAX_LIGHTS_PER_TILE set to this
+	};
+
+	inline LightTiles createLightTiles(unsigned int width, unsigned int height, unsigned int maxLightsPerTile = MAX_LIGHTS_PER_TILE) {
+		LightTiles lt = LightTiles();
+
+		lt.width = width;
+		lt.height = height;
+		lt.maxLightsPerTile = maxLightsPerTile;
+		lt.numTilesX = (width + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+		lt.numTilesY = (height + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+
+		glCreateBuffers(1, &lt.ssbo);
+		glNamedBufferStorage(lt.ssbo, sizeof(unsigned int) * (maxLightsPerTile + 1) * lt.numTilesX * lt.numTilesY, NULL, 0);
+
+		return lt;
+	}
+
+	// Bins lights into tiles. Expects the culling shader to be in use with its uniforms set.
+	// The shading pass needs a GL_SHADER_STORAGE_BARRIER_BIT barrier before it reads the tile lists,
+	// a FrameGraph compute pass gets one inserted.
+	inline void dispatchLightCulling(const LightTiles& lt, unsigned int depthTexture) {
+		glBindTextureUnit(0, depthTexture);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, lt.ssbo);
+		glDispatchCompute(lt.numTilesX, lt.numTilesY, 1);
+	}
+}
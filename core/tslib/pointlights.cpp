@@ -0,0 +1,98 @@
+#include "pointlights.h"
+#include "../ew/external/glad.h"
+
+namespace tslib {
+	// Count is padded to the 16 byte alignment of the PointLight array in std430
+	static const unsigned int HEADER_SIZE = 16;
+
+	PointLightBuffer::PointLightBuffer(unsigned int capacity)
+	{
+		m_capacity = capacity > 0 ? capacity : 1;
+		m_lights.reserve(m_capacity);
+		m_dirty.reserve(m_capacity);
+	}
+
+	PointLightBuffer::~PointLightBuffer()
+	{
+		if (m_ssbo != 0) {
+			glDeleteBuffers(1, &m_ssbo);
+		}
+	}
+
+	unsigned int PointLightBuffer::add(const PointLight& light)
+	{
+		m_lights.push_back(light);
+		m_dirty.push_back(true);
+		m_countDirty = true;
+		return m_lights.size() - 1;
+	}
+
+	void PointLightBuffer::set(unsigned int index, const PointLight& light)
+	{
+		m_lights[index] = light;
+		m_dirty[index] = true;
+	}
+
+	void PointLightBuffer::clear()
+	{
+		m_lights.clear();
+		m_dirty.clear();
+		m_countDirty = true;
+	}
+
+	/// <summary>
+	/// Creates GPU storage for the given number of lights. Everything is re-uploaded on the next upload()
+	/// </summary>
+	void PointLightBuffer::allocate(unsigned int capacity)
+	{
+		if (m_ssbo == 0) {
+			glCreateBuffers(1, &m_ssbo);
+		}
+		m_capacity = capacity;
+		glNamedBufferData(m_ssbo, HEADER_SIZE + sizeof(PointLight) * m_capacity, NULL, GL_DYNAMIC_DRAW);
+		for (size_t i = 0; i < m_dirty.size(); i++)
+		{
+			m_dirty[i] = true;
+		}
+		m_countDirty = true;
+	}
+
+	/// <summary>
+	/// Sends the light count and any lights changed since the last upload. Contiguous changes are sent as one range.
+	/// </summary>
+	void PointLightBuffer::upload()
+	{
+		if (m_ssbo == 0 || m_lights.size() > m_capacity) {
+			unsigned int capacity = m_capacity;
+			while (capacity < m_lights.size()) {
+				capacity *= 2;
+			}
+			allocate(capacity);
+		}
+
+		if (m_countDirty) {
+			unsigned int count = m_lights.size();
+			glNamedBufferSubData(m_ssbo, 0, sizeof(unsigned int), &count);
+			m_countDirty = false;
+		}
+
+		size_t i = 0;
+		while (i < m_dirty.size()) {
+			if (!m_dirty[i]) {
+				i++;
+				continue;
+			}
+			size_t first = i;
+			while (i < m_dirty.size() && m_dirty[i]) {
+				m_dirty[i] = false;
+				i++;
+			}
+			glNamedBufferSubData(m_ssbo, HEADER_SIZE + sizeof(PointLight) * first, sizeof(PointLight) * (i - first), &m_lights[first]);
+		}
+	}
+
+	void PointLightBuffer::bind(unsigned int binding) const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_ssbo);
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace tslib {
+	// Matches the std430 PointLight struct in the lighting shaders (32 bytes)
+	struct PointLight {
+		glm::vec3 position;
+		float radius;
+		glm::vec4 color;
+	};
+
+	// Point lights packed into a shader storage buffer:
+	//	layout(std430) buffer PointLights { uint _NumPointLights; PointLight _PointLights[]; };
+	// Only lights changed since the last upload() are sent to the GPU.
+	class PointLightBuffer {
+	public:
+		PointLightBuffer(unsigned int capacity = 64);
+		~PointLightBuffer();
+		PointLightBuffer(const PointLightBuffer&) = delete;
+		PointLightBuffer& operator=(const PointLightBuffer&) = delete;
+
+		unsigned int add(const PointLight& light);
+		void set(unsigned int index, const PointLight& light);
+		void clear();
+		void upload();
+		void bind(unsigned int binding) const;
+		inline const PointLight& get(unsigned int index) const { return m_lights[index]; }
+		inline unsigned int count() const { return m_lights.size(); }
+		inline unsigned int getBuffer() const { return m_ssbo; }
+	private:
+		void allocate(unsigned int capacity);
+
+		std::vector<PointLight> m_lights;
+		std::vector<bool> m_dirty;
+		bool m_countDirty = true;
+		unsigned int m_capacity = 0;
+		unsigned int m_ssbo = 0;
+	};
+}
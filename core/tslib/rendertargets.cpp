@@ -0,0 +1,226 @@
+#include "rendertargets.h"
+#include "../ew/external/glad.h"
+#include <stdio.h>
+
+namespace tslib {
+	RenderTargetPool::RenderTargetPool(unsigned int maxIdleFrames)
+		: m_maxIdleFrames(maxIdleFrames)
+	{
+	}
+
+	RenderTargetPool::~RenderTargetPool()
+	{
+		while (!m_targets.empty()) {
+			destroy(m_targets.size() - 1);
+		}
+	}
+
+	void RenderTargetPool::getSize(const RenderTargetDesc& desc, unsigned int& width, unsigned int& height) const
+	{
+		if (desc.width != 0 && desc.height != 0) {
+			width = desc.width;
+			height = desc.height;
+			return;
+		}
+		width = (unsigned int)(m_screenWidth * desc.scale);
+		height = (unsigned int)(m_screenHeight * desc.scale);
+		width = width > 0 ? width : 1;
+		height = height > 0 ? height : 1;
+	}
+
+	void RenderTargetPool::setScreenSize(unsigned int width, unsigned int height)
+	{
+		if (width == m_screenWidth && height == m_screenHeight) {
+			return;
+		}
+		m_screenWidth = width;
+		m_screenHeight = height;
+		for (size_t i = m_targets.size(); i-- > 0;) {
+			if (m_targets[i].screenSized && !m_targets[i].inUse) {
+				destroy(i);
+			}
+		}
+	}
+
+	void RenderTargetPool::beginFrame()
+	{
+		m_frame++;
+		for (size_t i = m_targets.size(); i-- > 0;) {
+			const Target& target = m_targets[i];
+			if (!target.inUse && m_frame - target.lastUsedFrame > m_maxIdleFrames) {
+				destroy(i);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Reuses a free target with the same size, format and usage, otherwise creates one.
+	/// Targets are sampled with nearest filtering and clamped, the way full screen passes read them.
+	/// </summary>
+	unsigned int RenderTargetPool::acquire(const RenderTargetDesc& desc)
+	{
+		unsigned int width, height;
+		getSize(desc, width, height);
+		bool screenSized = desc.width == 0 || desc.height == 0;
+		for (Target& target : m_targets) {
+			if (!target.inUse && target.format == desc.format && target.usage == desc.usage
+				&& target.width == width && target.height == height && target.screenSized == screenSized) {
+				target.inUse = true;
+				target.lastUsedFrame = m_frame;
+				return target.texture;
+			}
+		}
+
+		Target target;
+		glCreateTextures(GL_TEXTURE_2D, 1, &target.texture);
+		glTextureStorage2D(target.texture, 1, desc.format, width, height);
+		glTextureParameteri(target.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(target.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(target.texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(target.texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		target.format = desc.format;
+		target.usage = desc.usage;
+		target.width = width;
+		target.height = height;
+		target.screenSized = screenSized;
+		target.scale = desc.scale;
+		target.inUse = true;
+		target.lastUsedFrame = m_frame;
+
+		// Sized from what the driver allocated rather than a table of formats
+		const GLenum sizeParams[6] = {
+			GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE, GL_TEXTURE_ALPHA_SIZE, GL_TEXTURE_DEPTH_SIZE, GL_TEXTURE_STENCIL_SIZE
+		};
+		unsigned int bits = 0;
+		for (GLenum param : sizeParams) {
+			int size = 0;
+			glGetTextureLevelParameteriv(target.texture, 0, param, &size);
+			bits += size;
+		}
+		target.bytes = (size_t)width * height * bits / 8;
+
+		m_targets.push_back(target);
+		m_createdCount++;
+		m_allocatedBytes += target.bytes;
+		m_peakBytes = m_allocatedBytes > m_peakBytes ? m_allocatedBytes : m_peakBytes;
+		return target.texture;
+	}
+
+	//Targets left over from before a resize are deleted instead of returning to the pool
+	void RenderTargetPool::release(unsigned int texture)
+	{
+		for (size_t i = 0; i < m_targets.size(); i++) {
+			Target& target = m_targets[i];
+			if (target.texture != texture) {
+				continue;
+			}
+			target.inUse = false;
+			if (target.screenSized) {
+				RenderTargetDesc desc;
+				desc.scale = target.scale;
+				unsigned int width, height;
+				getSize(desc, width, height);
+				if (width != target.width || height != target.height) {
+					destroy(i);
+				}
+			}
+			return;
+		}
+		printf("Released a texture that is not from this render target pool: %u\n", texture);
+	}
+
+	void RenderTargetPool::destroy(size_t index)
+	{
+		unsigned int texture = m_targets[index].texture;
+		for (size_t i = m_framebuffers.size(); i-- > 0;) {
+			const CachedFramebuffer& cached = m_framebuffers[i];
+			for (unsigned int attachment : cached.attachments) {
+				if (attachment == texture) {
+					glDeleteFramebuffers(1, &cached.fbo);
+					m_framebuffers.erase(m_framebuffers.begin() + i);
+					break;
+				}
+			}
+		}
+		glDeleteTextures(1, &texture);
+		m_allocatedBytes -= m_targets[index].bytes;
+		m_targets.erase(m_targets.begin() + index);
+	}
+
+	unsigned int RenderTargetPool::getFramebuffer(const Framebuffer& framebuffer)
+	{
+		unsigned int attachments[4] = {};
+		for (unsigned int i = 0; i < framebuffer.numColorBuffers; i++) {
+			attachments[i] = framebuffer.colorBuffers[i];
+		}
+		attachments[3] = framebuffer.depthBuffer;
+		for (const CachedFramebuffer& cached : m_framebuffers) {
+			bool match = true;
+			for (int i = 0; i < 4; i++) {
+				match = match && cached.attachments[i] == attachments[i];
+			}
+			if (match) {
+				return cached.fbo;
+			}
+		}
+
+		CachedFramebuffer cached;
+		glCreateFramebuffers(1, &cached.fbo);
+		GLenum drawBuffers[3];
+		for (unsigned int i = 0; i < framebuffer.numColorBuffers; i++) {
+			glNamedFramebufferTexture(cached.fbo, GL_COLOR_ATTACHMENT0 + i, attachments[i], 0);
+			drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		}
+		glNamedFramebufferDrawBuffers(cached.fbo, framebuffer.numColorBuffers, drawBuffers);
+		if (attachments[3] != 0) {
+			glNamedFramebufferTexture(cached.fbo, GL_DEPTH_ATTACHMENT, attachments[3], 0);
+		}
+		GLenum status = glCheckNamedFramebufferStatus(cached.fbo, GL_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			printf("Pooled framebuffer incomplete: %d\n", status);
+		}
+		for (int i = 0; i < 4; i++) {
+			cached.attachments[i] = attachments[i];
+		}
+		m_framebuffers.push_back(cached);
+		return cached.fbo;
+	}
+
+	Framebuffer RenderTargetPool::acquireFramebuffer(const RenderTargetDesc* colors, unsigned int numColors, const RenderTargetDesc* depth)
+	{
+		Framebuffer framebuffer;
+		framebuffer.numColorBuffers = numColors;
+		for (unsigned int i = 0; i < 3; i++) {
+			framebuffer.colorBuffers[i] = i < numColors ? acquire(colors[i]) : 0;
+		}
+		framebuffer.depthBuffer = depth != nullptr ? acquire(*depth) : 0;
+		getSize(numColors > 0 ? colors[0] : *depth, framebuffer.width, framebuffer.height);
+		framebuffer.fbo = getFramebuffer(framebuffer);
+		return framebuffer;
+	}
+
+	Framebuffer RenderTargetPool::acquireGBuffer(GBufferLayout layout)
+	{
+		int colorFormats[3];
+		int depthFormat;
+		unsigned int numColors = getGBufferFormats(layout, colorFormats, depthFormat);
+		RenderTargetDesc colors[3];
+		for (unsigned int i = 0; i < numColors; i++) {
+			colors[i].format = colorFormats[i];
+		}
+		RenderTargetDesc depth;
+		depth.format = depthFormat;
+		depth.usage = RenderTargetUsage::DEPTH;
+		return acquireFramebuffer(colors, numColors, &depth);
+	}
+
+	void RenderTargetPool::releaseFramebuffer(const Framebuffer& framebuffer)
+	{
+		for (unsigned int i = 0; i < framebuffer.numColorBuffers; i++) {
+			release(framebuffer.colorBuffers[i]);
+		}
+		if (framebuffer.depthBuffer != 0) {
+			release(framebuffer.depthBuffer);
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "framebuffer.h"
+
+namespace tslib {
+	enum class RenderTargetUsage {
+		COLOR,
+		DEPTH
+	};
+
+	// What a pass needs from a target. Width and height of 0 follow the pool's screen size times scale.
+	struct RenderTargetDesc {
+		int format = 0;
+		RenderTargetUsage usage = RenderTargetUsage::COLOR;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		float scale = 1.0f;
+	};
+
+	// Hands out render target textures by descriptor instead of each pass owning full resolution targets.
+	// A released target is immediately free for any later acquire with the same size and format, so passes
+	// whose lifetimes don't overlap share memory. Targets idle for a few frames are deleted, and screen sized
+	// ones are rebuilt lazily on their next acquire after a resize.
+	class RenderTargetPool {
+	public:
+		RenderTargetPool(unsigned int maxIdleFrames = 3);
+		~RenderTargetPool();
+		RenderTargetPool(const RenderTargetPool&) = delete;
+		RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+		// Free targets of the old size are deleted now, held ones when they are released
+		void setScreenSize(unsigned int width, unsigned int height);
+		// Deletes targets no pass acquired for more than maxIdleFrames frames
+		void beginFrame();
+		// Texture for desc that nothing else holds until release() is called on it
+		unsigned int acquire(const RenderTargetDesc& desc);
+		void release(unsigned int texture);
+
+		// Targets for every attachment with a cached FBO over them. depth may be nullptr.
+		Framebuffer acquireFramebuffer(const RenderTargetDesc* colors, unsigned int numColors, const RenderTargetDesc* depth);
+		Framebuffer acquireGBuffer(GBufferLayout layout);
+		// Releases every attachment, the FBO stays cached for the next time they are acquired together
+		void releaseFramebuffer(const Framebuffer& framebuffer);
+		// Cached FBO over acquired targets, the way acquireFramebuffer builds its own
+		unsigned int getFramebuffer(const Framebuffer& framebuffer);
+		// Size a target for desc gets at the current screen size
+		void getSize(const RenderTargetDesc& desc, unsigned int& width, unsigned int& height) const;
+
+		inline unsigned int getScreenWidth() const { return m_screenWidth; }
+		inline unsigned int getScreenHeight() const { return m_screenHeight; }
+		inline size_t getAllocatedBytes() const { return m_allocatedBytes; }
+		inline size_t getPeakBytes() const { return m_peakBytes; }
+		inline unsigned int getTargetCount() const { return m_targets.size(); }
+		// Textures created over the pool's lifetime, stays flat once frames reuse their targets
+		inline unsigned int getCreatedCount() const { return m_createdCount; }
+	private:
+		struct Target {
+			unsigned int texture;
+			int format;
+			RenderTargetUsage usage;
+			unsigned int width;
+			unsigned int height;
+			bool screenSized;
+			float scale;
+			bool inUse;
+			unsigned int lastUsedFrame;
+			size_t bytes;
+		};
+		struct CachedFramebuffer {
+			unsigned int fbo;
+			unsigned int attachments[4]; // Colors then depth, 0 when unused
+		};
+
+		void destroy(size_t index);
+
+		std::vector<Target> m_targets;
+		std::vector<CachedFramebuffer> m_framebuffers;
+		unsigned int m_screenWidth = 0;
+		unsigned int m_screenHeight = 0;
+		unsigned int m_frame = 0;
+		unsigned int m_maxIdleFrames;
+		unsigned int m_createdCount = 0;
+		size_t m_allocatedBytes = 0;
+		size_t m_peakBytes = 0;
+	};
+}
@@ -0,0 +1,52 @@
+// Cascaded shadow map lookup, #include "tslib/cascadedShadows.glsl" in a fragment shader.
+// Uniforms are filled by tslib::CascadedShadowMap::setUniforms, MAX_CASCADES must match MAX_SHADOW_CASCADES
+#define MAX_CASCADES 4
+uniform sampler2DArray _ShadowMap;
+uniform int _NumCascades;
+uniform float _CascadeSplits[MAX_CASCADES]; // View depth each cascade ends at
+uniform mat4 _CascadeViewProj[MAX_CASCADES];
+uniform mat4 _View;
+
+// Width of the PCF kernel in texels, must be odd. 1 takes a single shadow map sample.
+#ifndef PCF_SIZE
+#define PCF_SIZE 3
+#endif
+
+float calcShadow(sampler2DArray shadowMap, vec3 worldPos, vec3 normal, vec3 lightDirection){
+	// Nearest cascade covering this depth, nothing is shadowed past the last
+	float viewDepth = -(_View * vec4(worldPos, 1)).z;
+	if (viewDepth > _CascadeSplits[_NumCascades - 1]) {
+		return 0.0;
+	}
+	int cascade = 0;
+	while (cascade < _NumCascades - 1 && viewDepth > _CascadeSplits[cascade]) {
+		cascade++;
+	}
+
+	// Cascades have different depth ranges and texel sizes, so instead of a fixed depth bias the position
+	// is pushed out along the normal by a texel, more at grazing angles
+	vec2 texelOffset = 1.0 / textureSize(shadowMap, 0).xy;
+	float texelWorldSize = 2.0 * texelOffset.x / _CascadeViewProj[cascade][0][0];
+	float slope = 1.0 - clamp(dot(normal, -normalize(lightDirection)), 0.0, 1.0);
+	vec4 lightSpacePos = _CascadeViewProj[cascade] * vec4(worldPos + normal * texelWorldSize * (1.0 + slope), 1);
+
+	//Homogeneous Clip space to NDC [-w,w] to [-1,1]
+	vec3 sampleCoord = lightSpacePos.xyz / lightSpacePos.w;
+	//Convert from [-1,1] to [0,1]
+	sampleCoord = sampleCoord * 0.5 + 0.5;
+	float myDepth = sampleCoord.z - 0.001;
+
+	// PCF filtering, one shadow map tap per texel of the kernel
+	float totalShadow = 0;
+
+	for (int y = -PCF_SIZE / 2; y <= PCF_SIZE / 2; y++) {
+		for (int x = -PCF_SIZE / 2; x <= PCF_SIZE / 2; x++) {
+			vec2 uv = sampleCoord.xy + vec2(x * texelOffset.x, y * texelOffset.y);
+			totalShadow += step(texture(shadowMap, vec3(uv, cascade)).r, myDepth);
+		}
+	}
+
+	totalShadow /= float(PCF_SIZE * PCF_SIZE);
+
+	return totalShadow;
+}
@@ -0,0 +1,46 @@
+// G-Buffer inputs, #include "tslib/gBuffer.glsl" in a fragment shader that reads a G-Buffer from
+// tslib::RenderTargetPool::acquireGBuffer.
+// Compile with COMPACT_GBUFFER 1 for tslib::GBufferLayout::COMPACT, depth is then bound in place of positions
+#ifndef COMPACT_GBUFFER
+#define COMPACT_GBUFFER 0
+#endif
+
+#if COMPACT_GBUFFER
+uniform layout(binding = 0) sampler2D _gDepth;
+uniform mat4 _InvViewProjection;
+#else
+uniform layout(binding = 0) sampler2D _gPositions;
+#endif
+uniform layout(binding = 1) sampler2D _gNormals;
+uniform layout(binding = 2) sampler2D _gAlbedo;
+
+#if COMPACT_GBUFFER
+vec3 octDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+vec3 reconstructWorldPos(vec2 uv, float depth) {
+	vec4 world = _InvViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+	return world.xyz / world.w;
+}
+#endif
+
+// Decodes the G-Buffer texel at uv. Returns false if nothing was drawn there (compact layout only).
+bool readGBuffer(vec2 uv, out vec3 worldPos, out vec3 normal, out vec3 albedo) {
+#if COMPACT_GBUFFER
+	vec4 albedoBits = texture(_gAlbedo, uv);
+	albedo = albedoBits.rgb;
+	normal = octDecode(texture(_gNormals, uv).xy);
+	worldPos = reconstructWorldPos(uv, texture(_gDepth, uv).r);
+	return albedoBits.a != 0.0;
+#else
+	worldPos = texture(_gPositions, uv).xyz;
+	normal = texture(_gNormals, uv).xyz;
+	albedo = texture(_gAlbedo, uv).xyz;
+	return true;
+#endif
+}
@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include <ew/cookedModel.h>
+
+// Cooks any Assimp supported model into a .ewmesh file that ew::Model loads without Assimp.
+// Usage: meshCook <source> [-o output] [-f float|packed|quantized] [-l lods]
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		printf("Usage: meshCook <source> [-o output] [-f float|packed|quantized] [-l lods]\n");
+		return 1;
+	}
+	std::string sourcePath = argv[1];
+	std::string cookedPath = sourcePath + ".ewmesh";
+	ew::VertexFormat format = ew::VertexFormat::FLOAT;
+	int numLods = 1;
+	for (int i = 2; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-o") == 0) {
+			cookedPath = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-f") == 0) {
+			if (strcmp(argv[i + 1], "packed") == 0) {
+				format = ew::VertexFormat::PACKED;
+			}
+			else if (strcmp(argv[i + 1], "quantized") == 0) {
+				format = ew::VertexFormat::PACKED_QUANTIZED;
+			}
+			else if (strcmp(argv[i + 1], "float") != 0) {
+				printf("Unknown vertex format %s\n", argv[i + 1]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-l") == 0) {
+			numLods = atoi(argv[i + 1]);
+			if (numLods < 1) {
+				numLods = 1;
+			}
+		}
+		else {
+			printf("Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	if (!ew::cookModel(sourcePath, cookedPath, format, numLods)) {
+		return 1;
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	printf("Cooked %s -> %s in %.1f ms\n", sourcePath.c_str(), cookedPath.c_str(), ms);
+	return 0;
+}
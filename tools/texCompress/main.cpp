@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include <ew/textureCompression.h>
+#include <ew/workerPool.h>
+
+// Encodes a PNG/JPG (or anything stb_image reads) with its full mip chain into a block compressed .dds file
+// that ew::loadTexture uploads as is.
+// Usage: texCompress <source> [-o output] [-f bc1|bc3|bc5|bc7] [-c srgb|linear]
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		printf("Usage: texCompress <source> [-o output] [-f bc1|bc3|bc5|bc7] [-c srgb|linear]\n");
+		return 1;
+	}
+	std::string sourcePath = argv[1];
+	std::string compressedPath = sourcePath + ".dds";
+	ew::BlockFormat format = ew::BlockFormat::BC7;
+	bool srgb = false;
+	for (int i = 2; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-o") == 0) {
+			compressedPath = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-f") == 0) {
+			if (strcmp(argv[i + 1], "bc1") == 0) {
+				format = ew::BlockFormat::BC1;
+			}
+			else if (strcmp(argv[i + 1], "bc3") == 0) {
+				format = ew::BlockFormat::BC3;
+			}
+			else if (strcmp(argv[i + 1], "bc5") == 0) {
+				format = ew::BlockFormat::BC5;
+			}
+			else if (strcmp(argv[i + 1], "bc7") != 0) {
+				printf("Unknown block format %s\n", argv[i + 1]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-c") == 0) {
+			if (strcmp(argv[i + 1], "srgb") == 0) {
+				srgb = true;
+			}
+			else if (strcmp(argv[i + 1], "linear") != 0) {
+				printf("Unknown color space %s\n", argv[i + 1]);
+				return 1;
+			}
+		}
+		else {
+			printf("Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	ew::WorkerPool pool;
+	ew::TextureData textureData;
+	if (!ew::loadTextureData(sourcePath.c_str(), textureData, true, srgb, &pool)) {
+		return 1;
+	}
+	ew::TextureData compressed;
+	ew::compressTexture(textureData, format, compressed, &pool);
+	if (!ew::writeDds(compressedPath, compressed)) {
+		return 1;
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	printf("Compressed %s -> %s (%zu KB, %zu KB uncompressed) in %.1f ms\n", sourcePath.c_str(), compressedPath.c_str(),
+		compressed.pixels.size() / 1024, textureData.pixels.size() / 1024, ms);
+	return 0;
+}